@@ -0,0 +1,252 @@
+#include "anytimepathfinder.hpp"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+AnytimePathfinder::AnytimePathfinder(const int nStartX, const int nStartY,
+                                     const int nTargetX, const int nTargetY,
+                                     const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                     int* pOutBuffer, const int nOutBufferSize,
+                                     const AnytimeOptions& options):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(pMap, nMapWidth, nMapHeight),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _options(options), _stopCondition(nullptr),
+  _openList(0), _bound(numeric_limits<double>::infinity())
+{
+  throwIfBadInput(checkMapInput(nMapWidth, nMapHeight));
+  throwIfBadInput(_map.checkQuery(_start, _target, nOutBufferSize));
+  chooseWeightScale();
+}
+
+AnytimePathfinder::AnytimePathfinder(const int nStartX, const int nStartY,
+                                     const int nTargetX, const int nTargetY,
+                                     const PreparedMap& preparedMap,
+                                     int* pOutBuffer, const int nOutBufferSize,
+                                     const AnytimeOptions& options):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(preparedMap),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _options(options), _stopCondition(nullptr),
+  _openList(0), _bound(numeric_limits<double>::infinity())
+{
+  throwIfBadInput(_map.checkQuery(_start, _target, nOutBufferSize));
+  chooseWeightScale();
+}
+
+void AnytimePathfinder::chooseWeightScale()
+{
+  // Largest scale for which no priority can overflow :
+  // g is less than the number of cells, h at most the distance between two corners.
+  const long long cells = _map.cellCount();
+  const long long maxDistance = _map.distance(Coordinates(0, 0), _map.indexToCoordinates(_map.cellCount() - 1));
+  const double initialWeight = max(1.0, _options.initialWeight);
+  for (_weightScale = MAX_WEIGHT_SCALE; _weightScale > 1; _weightScale /= 2)
+  {
+    const long long weight = (long long)ceil(initialWeight * _weightScale);
+    if (_weightScale * cells + weight * maxDistance <= INT_MAX) { break; }
+  }
+  _initialWeight = (int)ceil(initialWeight * _weightScale);
+  if (cells + _initialWeight * maxDistance > INT_MAX)
+  {
+    _initialWeight = 1;  // giant map : plain A*
+  }
+  _weight = _initialWeight;
+}
+
+int AnytimePathfinder::findPath(SearchStats* pStats)
+{
+  if (pStats == nullptr)
+  {
+    NoStatsCollector collector;
+    return search(collector);
+  }
+  StatsCollector collector(*pStats);
+  return search(collector);
+}
+
+template<class Collector>
+int AnytimePathfinder::search(Collector& collector)
+{
+  _solutions.clear();
+  _bound = numeric_limits<double>::infinity();
+
+  // Easy case : Target and Start are the same location
+  if (_start == _target)
+  {
+    _bound = 1;
+    return 0;
+  }
+
+  // Easy case : Target and Start are not in the same connected component, there is no path
+  if (!_map.mayConnect(_start, _target))
+  {
+    _bound = 1;
+    return -1;
+  }
+
+  collector.startSearch();
+  const chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  const int mapSize = _map.cellCount();
+  const int startIndex  = _map.coordinatesToIndex(_start);
+  const int targetIndex = _map.coordinatesToIndex(_target);
+  _shortestPathTree.assign(mapSize, -1);
+  _costFromStart.assign(mapSize, INT_MAX);
+  _closed.assign(mapSize, false);
+  _expanded.assign(mapSize, false);
+  _inconsistent.assign(mapSize, false);
+  _inconsistentList.clear();
+  _nodesExpanded = 0;
+  _expansionsLeft = (_options.maxExpansions > 0) ? _options.maxExpansions : LLONG_MAX;
+  _expansionsBeforeCheck = StopCondition::CHECK_PERIOD;
+
+  _weight = _initialWeight;
+  _costFromStart[startIndex] = 0;
+  _openList = IndexedHeap(mapSize, TieBreak::HigherG);
+  _openList.put(startIndex, priority(startIndex, 0), 0);
+
+  const int weightStep = max(1, (int)lround(_options.weightStep * _weightScale));
+  while (improvePath(collector))
+  {
+    if (_costFromStart[targetIndex] == INT_MAX)
+    {
+      _bound = 1;  // the whole reachable area was searched : there is no path
+      break;
+    }
+    publishSolution(chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count(), _nodesExpanded);
+    if (_bound <= 1) { break; }
+
+    // Decrease the weight, and resume the search from the cells whose cost may lead to a better path :
+    // the open list and the inconsistent cells, all gathered in _inconsistentList by publishSolution()
+    _weight = max(_weightScale, _weight - weightStep);
+    for (const int index : _inconsistentList)
+    {
+      _inconsistent[index] = false;
+      _openList.put(index, priority(index, _costFromStart[index]), _costFromStart[index]);
+    }
+    _inconsistentList.clear();
+    _closed.assign(mapSize, false);
+  }
+  collector.endSearch();
+  collector.allocated(_shortestPathTree.capacity()*sizeof(int) + _costFromStart.capacity()*sizeof(int) +
+                      3*_closed.capacity()/8 + _inconsistentList.capacity()*sizeof(int) + _openList.bytesAllocated());
+
+  if (_costFromStart[targetIndex] == INT_MAX) { return -1; }
+  collector.startOutput();
+  const int length = backtrackLength();
+  convertToOutput(length);
+  collector.endOutput();
+  return length;
+}
+
+template<class Collector>
+bool AnytimePathfinder::improvePath(Collector& collector)
+{
+  const int targetIndex = _map.coordinatesToIndex(_target);
+  while (!_openList.empty())
+  {
+    // stop when no cell in the open list can lead to a better path with the current weight
+    const int targetCost = _costFromStart[targetIndex];
+    if (targetCost != INT_MAX && _openList.topPriority() >= (long long)_weightScale * targetCost) { break; }
+
+    // stop when the budget is spent - the clock is read periodically only
+    if (_expansionsLeft-- == 0) { return false; }
+    if (_stopCondition != nullptr && --_expansionsBeforeCheck == 0)
+    {
+      _expansionsBeforeCheck = StopCondition::CHECK_PERIOD;
+      if (_stopCondition->check() != FindPathStatus::Ok) { return false; }
+    }
+
+    const int currentIndex = _openList.dequeue();
+    _closed[currentIndex] = true;
+    if (_expanded[currentIndex]) { collector.reExpanded(); }
+    _expanded[currentIndex] = true;
+    ++_nodesExpanded;
+    collector.expanded();
+
+    const Coordinates currentCell = _map.indexToCoordinates(currentIndex);
+    const int newCost = _costFromStart[currentIndex] + 1;
+    Coordinates neighbors[4];
+    const int nbNeighbors = _map.findNeighbors(currentCell, neighbors);
+    for (int i = 0; i < nbNeighbors; ++i)
+    {
+      const int nextIndex = _map.coordinatesToIndex(neighbors[i]);
+      collector.generated();
+      if (newCost >= _costFromStart[nextIndex]) { continue; }
+
+      _costFromStart[nextIndex] = newCost;
+      _shortestPathTree[nextIndex] = currentIndex;
+      if (!_closed[nextIndex])
+      {
+        _openList.put(nextIndex, priority(nextIndex, newCost), newCost);
+      }
+      else if (!_inconsistent[nextIndex])
+      {
+        // already expanded with this weight : it will be expanded again with the next one
+        _inconsistent[nextIndex] = true;
+        _inconsistentList.push_back(nextIndex);
+      }
+    }
+    collector.openListSize(_openList.size());
+  }
+  return true;
+}
+
+int AnytimePathfinder::priority(const int index, const int costFromStart) const
+{
+  const int heuristics = _map.distance(_map.indexToCoordinates(index), _target);
+  return _weightScale * costFromStart + _weight * heuristics;
+}
+
+void AnytimePathfinder::publishSolution(const double microseconds, const long long nodesExpanded)
+{
+  // The shortest path goes through a cell of the open list or an inconsistent cell :
+  // their lowest g + h (not weighted) is a lower bound of the shortest length.
+  while (!_openList.empty())
+  {
+    const int index = _openList.dequeue();
+    _inconsistent[index] = true;
+    _inconsistentList.push_back(index);
+  }
+  int lowerBound = INT_MAX;
+  for (const int index : _inconsistentList)
+  {
+    lowerBound = min(lowerBound, _costFromStart[index] + _map.distance(_map.indexToCoordinates(index), _target));
+  }
+
+  const int length = backtrackLength();
+  const double weight = (double)_weight / _weightScale;
+  _bound = (lowerBound == INT_MAX) ? 1 : max(1.0, min(weight, (double)length / lowerBound));
+  _solutions.push_back(AnytimeSolution{length, weight, _bound, nodesExpanded, microseconds});
+}
+
+int AnytimePathfinder::backtrackLength() const
+{
+  // Costs only decrease, so following the tree from Target always reaches Start
+  // within _costFromStart[target] moves, possibly less.
+  const int startIndex  = _map.coordinatesToIndex(_start);
+  int length = 0;
+  for (int currentIndex = _map.coordinatesToIndex(_target); currentIndex != startIndex;
+       currentIndex = _shortestPathTree[currentIndex])
+  {
+    ++length;
+  }
+  return length;
+}
+
+void AnytimePathfinder::convertToOutput(const int length)
+{
+  if (length > _outBufferSize) { return; }
+  const int startIndex  = _map.coordinatesToIndex(_start);
+  int currentIndex = _map.coordinatesToIndex(_target);
+  for (int cursor = length - 1; currentIndex != startIndex; --cursor)
+  {
+    _outBuffer[cursor] = currentIndex;
+    currentIndex = _shortestPathTree[currentIndex];
+  }
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <vector>
+#include "preparedmap.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Anytime search
+// ############################################################################
+
+// AnytimePathfinder implements ARA* (Likhachev, Gordon and Thrun, 2003) : a first search
+// with an inflated heuristics weight w * Map::distance() returns a path at most w times longer
+// than the shortest one, quickly. Then the weight is decreased and the search resumes,
+// re-expanding only the cells whose cost improved, until the weight reaches 1 (the path is the
+// shortest) or the budget is spent. The best path found so far is always kept.
+
+/*! \brief Weights and budget of an anytime search */
+struct AnytimeOptions
+{
+  double initialWeight = 2.5;  //!< weight of the heuristics for the first path, at least 1
+  double weightStep = 0.5;     //!< decrease of the weight after each path
+  long long maxExpansions = 0; //!< budget in expanded cells, 0 for no limit
+};
+
+/*! \brief A path found by an anytime search, and when it was found */
+struct AnytimeSolution
+{
+  int length;
+  double weight;         //!< heuristics weight of the search which found it
+  double bound;          //!< length is at most bound times the shortest length
+  long long nodesExpanded;
+  double microseconds;   //!< since the beginning of the search
+};
+
+/*! \brief ARA* search, returning the best path found within its budget.
+ *
+ *  The time budget is given by a StopCondition, the expansion budget by AnytimeOptions.
+ *  ex: AnytimePathfinder pathfinder(0, 0, 99, 99, pMap, 100, 100, pOutBuffer, nOutBufferSize);
+ *      StopCondition oneMillisecond;
+ *      oneMillisecond.deadline = chrono::steady_clock::now() + chrono::milliseconds(1);
+ *      pathfinder.setStopCondition(&oneMillisecond);
+ *      int length = pathfinder.findPath();  // length <= pathfinder.bound() * shortest length
+ */
+class AnytimePathfinder
+{
+  public:
+  /*! \brief Weights are rounded up to multiples of 1/MAX_WEIGHT_SCALE (coarser on huge maps) */
+  static const int MAX_WEIGHT_SCALE = 16;
+
+  /*! \throw BadInputException on the same inputs as FindPath() */
+  AnytimePathfinder(const int nStartX, const int nStartY,
+                    const int nTargetX, const int nTargetY,
+                    const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                    int* pOutBuffer, const int nOutBufferSize,
+                    const AnytimeOptions& options = AnytimeOptions());
+  /*! \brief Search on a PreparedMap, using its preprocessed arrays
+   *  \throw BadInputException on the same inputs as PreparedMap::findPath()
+   */
+  AnytimePathfinder(const int nStartX, const int nStartY,
+                    const int nTargetX, const int nTargetY,
+                    const PreparedMap& preparedMap,
+                    int* pOutBuffer, const int nOutBufferSize,
+                    const AnytimeOptions& options = AnytimeOptions());
+
+  /*! \brief Search until the shortest path is proven or the budget is spent.
+   *
+   *  \return length of the best path found, -1 if there is none or if none was found
+   *          within the budget. The output buffer is filled as by FindPath().
+   */
+  int findPath(SearchStats* pStats = nullptr);
+
+  /*! \brief Suboptimality bound of the returned path : 1 when it is the shortest one
+   *         (or when there is proven to be no path), infinity when no bound was reached.
+   */
+  double bound() const { return _bound; }
+  /*! \brief Every improved path found by the last findPath(), in order */
+  const vector<AnytimeSolution>& solutions() const { return _solutions; }
+
+  /*! \brief Stop the search when the condition is met, keeping the best path so far.
+   *         nullptr (default) for no condition. The condition must outlive the search.
+   */
+  void setStopCondition(const StopCondition* stopCondition) { _stopCondition = stopCondition; }
+
+  private:
+  void chooseWeightScale();
+  template<class Collector>
+  int search(Collector& collector);
+  template<class Collector>
+  bool improvePath(Collector& collector);
+  int priority(const int index, const int costFromStart) const;
+  void publishSolution(const double microseconds, const long long nodesExpanded);
+  int backtrackLength() const;
+  void convertToOutput(const int length);
+
+  Coordinates _start, _target;
+  QueryMap _map;
+  int* _outBuffer;
+  int _outBufferSize;
+  AnytimeOptions _options;
+  const StopCondition* _stopCondition;
+
+  // Priorities are integers : the weight is a fraction _weight / _weightScale,
+  // and priority = _weightScale * g + _weight * h has the same order as g + w * h.
+  int _weightScale;
+  int _initialWeight;
+  int _weight;
+
+  // search state, kept from one weight to the next
+  vector<int> _shortestPathTree;
+  vector<int> _costFromStart;
+  vector<bool> _closed;        // expanded with the current weight
+  vector<bool> _expanded;      // expanded with any weight, to count re-expansions
+  vector<bool> _inconsistent;  // in _inconsistentList : improved after being expanded with the current weight
+  vector<int> _inconsistentList;
+  IndexedHeap _openList;
+  long long _nodesExpanded;
+  long long _expansionsLeft;
+  int _expansionsBeforeCheck;
+
+  double _bound;
+  vector<AnytimeSolution> _solutions;
+};
@@ -0,0 +1,75 @@
+#include "arena.hpp"
+#include <algorithm>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+const size_t Arena::DEFAULT_BLOCK_SIZE;
+
+// innermost ArenaScope of each thread
+static thread_local Arena* currentArena = nullptr;
+
+void* Arena::allocate(const size_t bytes, const size_t alignment)
+{
+  while (true)
+  {
+    if (_block < _blocks.size())
+    {
+      // blocks are allocated with operator new[] : their data is aligned for any type
+      const size_t offset = (_offset + alignment - 1) & ~(alignment - 1);
+      if (offset + bytes <= _blocks[_block].size)
+      {
+        _offset = offset + bytes;
+        return _blocks[_block].data.get() + offset;
+      }
+      // does not fit : go on in the next block, if it is large enough
+      ++_block;
+      _offset = 0;
+      if (_block < _blocks.size() && _blocks[_block].size >= bytes) { continue; }
+      // a next block too small is replaced, as it is free after a rewind
+      if (_block < _blocks.size()) { _blocks.erase(_blocks.begin() + _block, _blocks.end()); }
+    }
+    // new block, larger than the request : an oversized request gets a block of its own
+    const size_t size = max(_blockSize, bytes);
+    _blocks.push_back(Block{unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+    ++_systemAllocations;
+    _block = _blocks.size() - 1;
+    _offset = 0;
+  }
+}
+
+void Arena::release()
+{
+  _blocks.clear();
+  reset();
+}
+
+size_t Arena::bytesReserved() const
+{
+  size_t bytes = 0;
+  for (const Block& block : _blocks) { bytes += block.size; }
+  return bytes;
+}
+
+Arena& Arena::forThisThread()
+{
+  static thread_local Arena arena;
+  return arena;
+}
+
+Arena* Arena::current()
+{
+  return currentArena;
+}
+
+ArenaScope::ArenaScope(Arena& arena): _arena(arena), _mark(arena.mark()), _previous(currentArena)
+{
+  currentArena = &_arena;
+}
+
+ArenaScope::~ArenaScope()
+{
+  _arena.rewind(_mark);
+  currentArena = _previous;
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// ############################################################################
+// ### Arena
+// ############################################################################
+
+// The memory of a query - open list, per cell arrays - lives only during the query.
+// An Arena hands it out by bumping a pointer in large blocks, and takes it all back
+// at once at the end of the query : no malloc nor free per query once the blocks are
+// large enough, so threads running queries do not contend on the global allocator.
+// Each thread has its own arena (Arena::forThisThread()), used by the searches run
+// inside an ArenaScope.
+
+/*! \brief Bump allocator : memory is only given back all at once, by rewind() or reset().
+ *
+ *  Not thread safe : an arena belongs to one thread.
+ *  ex: Arena arena;
+ *      const Arena::Mark mark = arena.mark();
+ *      int* cells = static_cast<int*>(arena.allocate(1000 * sizeof(int), alignof(int)));
+ *      arena.rewind(mark);  // cells is released
+ */
+class Arena
+{
+  public:
+  static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+  /*! \brief Position in the arena, to rewind to */
+  struct Mark
+  {
+    size_t block;
+    size_t offset;
+  };
+
+  explicit Arena(const size_t blockSize = DEFAULT_BLOCK_SIZE): _blockSize(blockSize), _block(0), _offset(0), _systemAllocations(0) {}
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /*! \throw std::bad_alloc if a new block cannot be allocated */
+  void* allocate(const size_t bytes, const size_t alignment);
+
+  Mark mark() const { return Mark{_block, _offset}; }
+  /*! \brief Release everything allocated since the mark, in O(1). The blocks are kept for the next allocations */
+  void rewind(const Mark& mark) { _block = mark.block; _offset = mark.offset; }
+  /*! \brief Release everything, in O(1) */
+  void reset() { rewind(Mark{0, 0}); }
+  /*! \brief Give the blocks back to the system. Nothing must be allocated */
+  void release();
+
+  /*! \brief Memory held by the blocks */
+  size_t bytesReserved() const;
+  /*! \brief Number of blocks allocated from the system since the construction */
+  long long systemAllocations() const { return _systemAllocations; }
+
+  /*! \brief Arena of the calling thread */
+  static Arena& forThisThread();
+  /*! \brief Arena of the innermost ArenaScope of the calling thread, nullptr outside any scope */
+  static Arena* current();
+
+  private:
+  struct Block
+  {
+    unique_ptr<unsigned char[]> data;
+    size_t size;
+  };
+
+  size_t _blockSize;
+  vector<Block> _blocks;
+  size_t _block;   // block being filled
+  size_t _offset;  // first free byte in it
+  long long _systemAllocations;
+};
+
+/*! \brief Makes an arena the current one of the thread while in scope, and releases
+ *         everything allocated in it at the end of the scope.
+ *
+ *  Scopes can be nested : an inner scope only releases its own allocations.
+ *  ex: { ArenaScope scope; FindPath(...); }  // the search state is taken from the thread's arena
+ */
+class ArenaScope
+{
+  public:
+  ArenaScope(): ArenaScope(Arena::forThisThread()) {}
+  explicit ArenaScope(Arena& arena);
+  ~ArenaScope();
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+  private:
+  Arena& _arena;
+  Arena::Mark _mark;
+  Arena* _previous;
+};
+
+/*! \brief Standard allocator drawing from an arena, or from the heap when the arena is nullptr.
+ *
+ *  deallocate() does nothing with an arena : the memory comes back when the arena is rewound,
+ *  so a container using it must not outlive its ArenaScope.
+ */
+template<typename T>
+class ArenaAllocator
+{
+  public:
+  typedef T value_type;
+  typedef true_type propagate_on_container_copy_assignment;
+  typedef true_type propagate_on_container_move_assignment;
+  typedef true_type propagate_on_container_swap;
+
+  ArenaAllocator(Arena* arena = nullptr): _arena(arena) {}
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other): _arena(other.arena()) {}
+
+  T* allocate(const size_t n)
+  {
+    if (_arena == nullptr) { return static_cast<T*>(::operator new(n * sizeof(T))); }
+    return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* p, const size_t)
+  {
+    if (_arena == nullptr) { ::operator delete(p); }
+  }
+
+  Arena* arena() const { return _arena; }
+
+  private:
+  Arena* _arena;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) { return lhs.arena() == rhs.arena(); }
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) { return lhs.arena() != rhs.arena(); }
+
+/*! \brief vector whose memory comes from an arena, or from the heap by default */
+template<typename T>
+using ArenaVector = vector<T, ArenaAllocator<T>>;
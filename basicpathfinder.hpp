@@ -0,0 +1,527 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <queue>
+#include "pathfinder.hpp"
+#include "sparsesearchstate.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Policy-based search
+// ############################################################################
+
+// Pathfinder chooses its tie-break and its search state at runtime, and its moves, costs and
+// heuristic are fixed. BasicPathfinder is A* with all of these as compile-time policies :
+// - Connectivity : the moves of its BasicMap (FourConnected, EightConnected),
+// - CostModel    : the cost of a move (UnitCost, OctileCost),
+// - Heuristic    : the estimate to Target in the units of the cost model (ManhattanHeuristic, OctileHeuristic, ZeroHeuristic),
+// - OpenList     : the priority queue and its tie-break (IndexedOpenList, LazyOpenList),
+// - StateLayout  : the cost and parent of the cells reached (DenseState, SparseState),
+// - SearchMap    : the map it reads, BasicMap<Connectivity> by default.
+// Each combination is compiled into its own search loop, where the policies are inlined :
+// no branch is left for the choices made at compile time. It is all in this header, so that
+// any combination - including policies written by the caller - can be instantiated.
+// The dense and sparse layouts of Pathfinder are instantiations of it, on the map of Pathfinder
+// (the preprocessed arrays of a PreparedMap) with its IndexedHeap (HeapOpenList). The default
+// instantiation BasicPathfinder<> expands the same cells in the same order, and returns the same path.
+// A policy is a type with static functions, or an object when it depends on runtime data :
+// the policy objects are given at construction, and the static ones take no room.
+
+// ### Cost models : cost of the moves, in integer units
+
+/*! \brief Every move costs 1 : the path length */
+struct UnitCost
+{
+  static constexpr int straight() { return 1; }
+  static constexpr int diagonal() { return 1; }
+  static int moveCost(const Coordinates&, const Coordinates&) { return 1; }
+};
+
+/*! \brief Diagonal moves cost about sqrt(2) times more : 5 for straight moves, 7 for diagonal ones */
+struct OctileCost
+{
+  static constexpr int straight() { return 5; }
+  static constexpr int diagonal() { return 7; }
+  static int moveCost(const Coordinates& from, const Coordinates& to)
+  {
+    return (from.X != to.X && from.Y != to.Y) ? diagonal() : straight();
+  }
+};
+
+// ### Heuristics : lower bound of the cost to Target, for the cost model of the search
+
+/*! \brief Orthogonal moves only : consistent on 4-connected maps, not admissible with diagonal moves */
+struct ManhattanHeuristic
+{
+  template<class CostModel>
+  static int estimate(const CostModel& costModel, const Coordinates& from, const Coordinates& to)
+  {
+    return costModel.straight() * (abs(from.X - to.X) + abs(from.Y - to.Y));
+  }
+};
+
+/*! \brief Diagonal moves, then straight ones : consistent on 4 and 8-connected maps */
+struct OctileHeuristic
+{
+  template<class CostModel>
+  static int estimate(const CostModel& costModel, const Coordinates& from, const Coordinates& to)
+  {
+    const int dx = abs(from.X - to.X), dy = abs(from.Y - to.Y);
+    return costModel.straight() * (max(dx, dy) - min(dx, dy)) + costModel.diagonal() * min(dx, dy);
+  }
+};
+
+/*! \brief No estimate : Dijkstra's algorithm */
+struct ZeroHeuristic
+{
+  template<class CostModel>
+  static int estimate(const CostModel&, const Coordinates&, const Coordinates&) { return 0; }
+};
+
+// ### Open lists : the slots of the state to expand, lowest priority first
+
+/*! \brief Order of the open cells of equal priority, as QueueKey for TieBreak, resolved at compile time */
+template<TieBreak Policy>
+struct OpenKey
+{
+  int priority;
+  int tiebreak;
+  long long order;
+
+  OpenKey(const int priority, const int costFromStart, const long long counter):
+    priority(priority),
+    tiebreak((Policy == TieBreak::HigherG) ? -costFromStart : (Policy == TieBreak::LowerH) ? priority - costFromStart : 0),
+    order((Policy == TieBreak::Lifo) ? -counter : counter) {}
+
+  bool operator<(const OpenKey& other) const
+  {
+    if (priority != other.priority) { return priority < other.priority; }
+    if (tiebreak != other.tiebreak) { return tiebreak < other.tiebreak; }
+    return order < other.order;
+  }
+};
+
+/*! \brief Indexed 4-ary heap, with in-place decrease-key : a slot is at most once in the list.
+ *
+ *  Same structure and order as IndexedHeap, with the tie-break resolved at compile time.
+ */
+template<TieBreak Policy = TieBreak::HigherG>
+class IndexedOpenList
+{
+  public:
+  static const bool MAY_HOLD_STALE = false;
+  static const int ARITY = 4;
+
+  void reset(const int expectedSlots, Arena* arena)
+  {
+    _elements = ArenaVector<Element>(ArenaAllocator<Element>(arena));
+    _positions = ArenaVector<int>(expectedSlots, -1, ArenaAllocator<int>(arena));
+    _counter = 0;
+  }
+  bool empty() const { return _elements.empty(); }
+  size_t size() const { return _elements.size(); }
+  /*! \brief Is a slot put before still in the list ? */
+  bool contains(const int slot) const { return _positions[slot] >= 0; }
+  size_t bytesAllocated() const { return _elements.capacity()*sizeof(Element) + _positions.capacity()*sizeof(int); }
+
+  void put(const int slot, const int priority, const int costFromStart)
+  {
+    if (slot >= (int)_positions.size()) { _positions.resize(max((size_t)slot + 1, 2*_positions.size()), -1); }
+    const OpenKey<Policy> key(priority, costFromStart, _counter++);
+    int position = _positions[slot];
+    if (position < 0)
+    {
+      position = (int)_elements.size();
+      _elements.push_back(Element{key, slot});
+    }
+    else
+    {
+      _elements[position].key = key;
+    }
+    siftUp(position);
+  }
+  /*! \brief Remove the slot with the lowest priority. The cost it was queued with is not tracked : -1 */
+  int pop(int* pQueuedCost)
+  {
+    const int bestSlot = _elements.front().slot;
+    _positions[bestSlot] = -1;
+    const Element last = _elements.back();
+    _elements.pop_back();
+    if (!_elements.empty())
+    {
+      place(last, 0);
+      siftDown(0);
+    }
+    *pQueuedCost = -1;
+    return bestSlot;
+  }
+
+  private:
+  struct Element
+  {
+    OpenKey<Policy> key;
+    int slot;
+  };
+
+  void siftUp(int position)
+  {
+    const Element element = _elements[position];
+    while (position > 0)
+    {
+      const int parent = (position - 1) / ARITY;
+      if (!(element.key < _elements[parent].key)) { break; }
+      place(_elements[parent], position);
+      position = parent;
+    }
+    place(element, position);
+  }
+  void siftDown(int position)
+  {
+    const Element element = _elements[position];
+    const int size = (int)_elements.size();
+    while (true)
+    {
+      const int firstChild = position * ARITY + 1;
+      if (firstChild >= size) { break; }
+      const int lastChild = min(firstChild + ARITY, size);
+      int bestChild = firstChild;
+      for (int child = firstChild + 1; child < lastChild; ++child)
+      {
+        if (_elements[child].key < _elements[bestChild].key) { bestChild = child; }
+      }
+      if (!(_elements[bestChild].key < element.key)) { break; }
+      place(_elements[bestChild], position);
+      position = bestChild;
+    }
+    place(element, position);
+  }
+  void place(const Element& element, const int position)
+  {
+    _elements[position] = element;
+    _positions[element.slot] = position;
+  }
+
+  ArenaVector<Element> _elements;
+  ArenaVector<int> _positions;  // position of each slot in _elements, -1 if not in the list
+  long long _counter = 0;
+};
+
+/*! \brief Binary heap without decrease-key : an improved slot is queued again, and its stale entries
+ *         are skipped by the search. No per slot array, a larger heap.
+ */
+template<TieBreak Policy = TieBreak::HigherG>
+class LazyOpenList
+{
+  public:
+  static const bool MAY_HOLD_STALE = true;
+
+  void reset(const int, Arena* arena)
+  {
+    _elements = Heap(Later(), ArenaVector<Element>(ArenaAllocator<Element>(arena)));
+    _counter = 0;
+    _peakSize = 0;
+  }
+  bool empty() const { return _elements.empty(); }
+  size_t size() const { return _elements.size(); }
+  /*! \brief Not tracked : any slot may still be in the list */
+  bool contains(const int) const { return true; }
+  size_t bytesAllocated() const { return _peakSize*sizeof(Element); }
+
+  void put(const int slot, const int priority, const int costFromStart)
+  {
+    _elements.push(Element{OpenKey<Policy>(priority, costFromStart, _counter++), slot, costFromStart});
+    _peakSize = max(_peakSize, _elements.size());
+  }
+  /*! \brief Remove the slot with the lowest priority, and give the cost it was queued with */
+  int pop(int* pQueuedCost)
+  {
+    const Element best = _elements.top();
+    _elements.pop();
+    *pQueuedCost = best.costFromStart;
+    return best.slot;
+  }
+
+  private:
+  struct Element
+  {
+    OpenKey<Policy> key;
+    int slot;
+    int costFromStart;
+  };
+  struct Later
+  {
+    bool operator()(const Element& lhs, const Element& rhs) const { return rhs.key < lhs.key; }
+  };
+  typedef priority_queue<Element, ArenaVector<Element>, Later> Heap;
+
+  Heap _elements{Later(), ArenaVector<Element>()};
+  long long _counter = 0;
+  size_t _peakSize = 0;
+};
+
+/*! \brief IndexedHeap, the open list of Pathfinder : its tie-break is chosen at runtime, its operations are out of line */
+struct HeapOpenList
+{
+  static const bool MAY_HOLD_STALE = false;
+  TieBreak tieBreak;
+  IndexedHeap heap{0};
+
+  void reset(const int expectedSlots, Arena* arena) { heap = IndexedHeap(expectedSlots, tieBreak, arena); }
+  bool empty() const { return heap.empty(); }
+  size_t size() const { return heap.size(); }
+  bool contains(const int slot) const { return heap.contains(slot); }
+  size_t bytesAllocated() const { return heap.bytesAllocated(); }
+  void put(const int slot, const int priority, const int costFromStart)
+  {
+    heap.growCapacity(slot + 1);
+    heap.put(slot, priority, costFromStart);
+  }
+  int pop(int* pQueuedCost)
+  {
+    *pQueuedCost = -1;
+    return heap.dequeue();
+  }
+};
+
+// ### State layouts : cost from Start and parent of the cells reached, by slot
+
+/*! \brief One slot per cell of the map, the cell index : the fastest when the search reaches a large part of the map */
+class DenseState
+{
+  public:
+  void reset(const int cellCount, const int, Arena* arena)
+  {
+    _costFromStart = ArenaVector<int>(cellCount, INT_MAX, ArenaAllocator<int>(arena));
+    _parents = ArenaVector<int>(cellCount, -1, ArenaAllocator<int>(arena));
+  }
+  static int expectedSlots(const int cellCount, const int) { return cellCount; }
+  /*! \brief Slot of a cell, with a cost of INT_MAX if it was not reached yet */
+  int reach(const int cell) { return cell; }
+  int cell(const int slot) const { return slot; }
+  int costFromStart(const int slot) const { return _costFromStart[slot]; }
+  int parent(const int slot) const { return _parents[slot]; }
+  void update(const int slot, const int costFromStart, const int parent)
+  {
+    _costFromStart[slot] = costFromStart;
+    _parents[slot] = parent;
+  }
+  size_t bytesAllocated() const { return (_costFromStart.capacity() + _parents.capacity())*sizeof(int); }
+
+  private:
+  ArenaVector<int> _costFromStart;
+  ArenaVector<int> _parents;  // slot of the parent, -1 if none
+};
+
+/*! \brief Slots for the cells reached only, in a SparseSearchState : for short queries on large maps */
+class SparseState
+{
+  public:
+  void reset(const int, const int expectedNodes, Arena* arena) { _state = SparseSearchState(expectedNodes, arena); }
+  static int expectedSlots(const int, const int expectedNodes) { return expectedNodes; }
+  int reach(const int cell)
+  {
+    const int node = _state.find(cell);
+    return (node >= 0) ? node : _state.insert(cell, INT_MAX, -1);
+  }
+  int cell(const int slot) const { return _state.node(slot).cell; }
+  int costFromStart(const int slot) const { return _state.node(slot).costFromStart; }
+  int parent(const int slot) const { return _state.node(slot).parent; }
+  void update(const int slot, const int costFromStart, const int parent)
+  {
+    SparseSearchState::Node& node = _state.node(slot);
+    node.costFromStart = costFromStart;
+    node.parent = parent;
+  }
+  size_t bytesAllocated() const { return _state.bytesAllocated(); }
+
+  private:
+  SparseSearchState _state;
+};
+
+// ### Search
+
+/*! \brief A* on a BasicMap, with compile-time policies.
+ *
+ *  Same contract as FindPath() : the return value is the number of moves of the path, and the output
+ *  buffer gets its cells. cost() gives its cost in the units of the cost model.
+ *  The path is the cheapest if the heuristic is admissible for the connectivity and the cost model.
+ *  A SearchMap other than BasicMap has its interface : the search state and the output are indexed
+ *  by its coordinatesToIndex().
+ *  ex: BasicPathfinder<EightConnected, OctileCost, OctileHeuristic> pathfinder(0, 0, 99, 99,
+ *          BasicMap<EightConnected>(pMap, 100, 100), pOutBuffer, nOutBufferSize);
+ *      int length = pathfinder.findPath();
+ */
+template<class Connectivity = FourConnected, class CostModel = UnitCost, class Heuristic = ManhattanHeuristic,
+         class OpenList = IndexedOpenList<TieBreak::HigherG>, class StateLayout = DenseState,
+         class SearchMap = BasicMap<Connectivity>>
+class BasicPathfinder
+{
+  public:
+  /*! \throw BadInputException on the same inputs as FindPath() */
+  BasicPathfinder(const int nStartX, const int nStartY,
+                  const int nTargetX, const int nTargetY,
+                  const SearchMap& map,
+                  int* pOutBuffer, const int nOutBufferSize,
+                  const CostModel& costModel = CostModel(), const Heuristic& heuristic = Heuristic(),
+                  const OpenList& openList = OpenList()):
+    _start(nStartX, nStartY), _target(nTargetX, nTargetY), _map(map),
+    _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+    _costModel(costModel), _heuristic(heuristic), _openList(openList), _cost(-1),
+    _stopCondition(nullptr), _stopStatus(FindPathStatus::Ok)
+  {
+    throwIfBadInput(checkMapInput(map.width(), map.height()));
+    throwIfBadInput(checkQueryInput(nStartX, nStartY, nTargetX, nTargetY, map.width(), map.height(), nOutBufferSize));
+    if (!_map.isCellOk(_start))  { throwIfBadInput(FindPathStatus::StartNotPassable); }
+    if (!_map.isCellOk(_target)) { throwIfBadInput(FindPathStatus::TargetNotPassable); }
+  }
+
+  /*! \brief Find the cheapest path and fill the output buffer.
+   *
+   *  \return number of moves of the path, or -1 if none can be found.
+   */
+  int findPath(SearchStats* pStats = nullptr)
+  {
+    if (pStats == nullptr)
+    {
+      NoStatsCollector collector;
+      return search(collector);
+    }
+    StatsCollector collector(*pStats);
+    return search(collector);
+  }
+
+  /*! \brief Same as findPath(), the statistics in a collector of pathfinder.hpp */
+  template<class Collector>
+  int search(Collector& collector)
+  {
+    _cost = -1;
+    _stopStatus = FindPathStatus::Ok;
+    // Easy case : Target and Start are the same location
+    if (_start == _target)
+    {
+      _cost = 0;
+      return 0;
+    }
+
+    // Inside an ArenaScope, the search state is taken from its arena, and given back at the end of the query
+    Arena* arena = Arena::current();
+    if (arena != nullptr)
+    {
+      ArenaScope queryScope(*arena);
+      return runSearch(collector, arena);
+    }
+    return runSearch(collector, nullptr);
+  }
+
+  /*! \brief Cost of the path found by the last findPath(), -1 if none */
+  int cost() const { return _cost; }
+
+  /*! \brief Abandon the search when the condition is met, as Pathfinder::setStopCondition() : findPath()
+   *         then returns -1, and stopStatus() tells why. nullptr (default) for no condition.
+   */
+  void setStopCondition(const StopCondition* stopCondition) { _stopCondition = stopCondition; }
+  /*! \brief Why the last search was stopped, Ok if it was not */
+  FindPathStatus stopStatus() const { return _stopStatus; }
+
+  private:
+  template<class Collector>
+  int runSearch(Collector& collector, Arena* arena)
+  {
+    collector.startSearch();
+    StateLayout state;
+    OpenList openList(_openList);
+    const int startIndex  = _map.coordinatesToIndex(_start);
+    const int targetIndex = _map.coordinatesToIndex(_target);
+    // as Pathfinder's SearchLayout::Automatic : A* reaches about distance^2 / 4 cells on open maps
+    const long long distance = _map.distance(_start, _target) + 1;
+    const int expectedNodes = (int)min<long long>(distance * distance / 4, _map.cellCount());
+    state.reset(_map.cellCount(), expectedNodes, arena);
+    openList.reset(StateLayout::expectedSlots(_map.cellCount(), expectedNodes), arena);
+
+    const int startSlot = state.reach(startIndex);
+    state.update(startSlot, 0, -1);
+    openList.put(startSlot, _heuristic.estimate(_costModel, _start, _target), 0);
+    collector.openListSize(openList.size());
+
+    int targetSlot = -1;
+    int expansionsBeforeCheck = StopCondition::CHECK_PERIOD;
+    while (!openList.empty())
+    {
+      // abandon the search if cancelled or out of time - checked periodically only
+      if (_stopCondition != nullptr && --expansionsBeforeCheck == 0)
+      {
+        expansionsBeforeCheck = StopCondition::CHECK_PERIOD;
+        _stopStatus = _stopCondition->check();
+        if (_stopStatus != FindPathStatus::Ok) { break; }
+      }
+
+      int queuedCost;
+      const int slot = openList.pop(&queuedCost);
+      // a lazy open list still holds the entries of the cells since reached by a cheaper path
+      if (OpenList::MAY_HOLD_STALE && queuedCost != state.costFromStart(slot)) { continue; }
+      if (state.cell(slot) == targetIndex)
+      {
+        targetSlot = slot;
+        break;
+      }
+      collector.expanded();
+
+      const Coordinates cell = _map.indexToCoordinates(state.cell(slot));
+      const int costFromStart = state.costFromStart(slot);
+      Coordinates neighbors[SearchMap::MAX_NEIGHBORS];
+      const int nbNeighbors = _map.findNeighbors(cell, neighbors);
+      for (int i = 0; i < nbNeighbors; ++i)
+      {
+        const Coordinates& neighbor = neighbors[i];
+        const int newCost = costFromStart + _costModel.moveCost(cell, neighbor);
+        const int neighborSlot = state.reach(_map.coordinatesToIndex(neighbor));
+        // the closed cells, reached and out of the open list, are not counted (a lazy open list cannot tell)
+        const bool reached = state.costFromStart(neighborSlot) != INT_MAX;
+        if (!reached || openList.contains(neighborSlot)) { collector.generated(); }
+        if (newCost < state.costFromStart(neighborSlot))
+        {
+          state.update(neighborSlot, newCost, slot);
+          openList.put(neighborSlot, newCost + _heuristic.estimate(_costModel, neighbor, _target), newCost);
+        }
+      }
+      collector.openListSize(openList.size());
+    }
+    collector.allocated(state.bytesAllocated() + openList.bytesAllocated());
+    collector.endSearch();
+
+    collector.startOutput();
+    const int length = convertToOutput(state, targetSlot);
+    collector.endOutput();
+    return length;
+  }
+
+  int convertToOutput(const StateLayout& state, const int targetSlot)
+  {
+    if (targetSlot < 0) { return -1; }
+    _cost = state.costFromStart(targetSlot);
+    int length = 0;
+    for (int slot = targetSlot; state.parent(slot) >= 0; slot = state.parent(slot)) { ++length; }
+    if (length <= _outBufferSize)
+    {
+      int cursor = length;
+      for (int slot = targetSlot; state.parent(slot) >= 0; slot = state.parent(slot))
+      {
+        _outBuffer[--cursor] = state.cell(slot);
+      }
+    }
+    return length;
+  }
+
+  Coordinates _start, _target;
+  SearchMap _map;
+  int* _outBuffer;
+  int _outBufferSize;
+  CostModel _costModel;
+  Heuristic _heuristic;
+  OpenList _openList;  // the policy object : each search works on a copy
+  int _cost;
+  const StopCondition* _stopCondition;
+  FindPathStatus _stopStatus;
+};
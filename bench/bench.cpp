@@ -0,0 +1,1698 @@
+#include "movingai.hpp"
+#include "mapgenerator.hpp"
+#include "heapcounter.hpp"
+#include "../pathfinder.hpp"
+#include "../preparedmap.hpp"
+#include "../findpathasync.hpp"
+#include "../incrementalpathfinder.hpp"
+#include "../anytimepathfinder.hpp"
+#include "../focalpathfinder.hpp"
+#include "../memoryboundedpathfinder.hpp"
+#include "../mappedmap.hpp"
+#include "../compressedmap.hpp"
+#include "../largemap.hpp"
+#include "../externalsearch.hpp"
+#include "../frontierpathfinder.hpp"
+#include "../basicpathfinder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <queue>
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// ############################################################################
+// ### Benchmark
+// ############################################################################
+
+// Runs Moving AI scenarios through FindPath and the alternative engines,
+// checks the returned lengths and reports latency percentiles and expansions per bucket.
+//
+// usage : bench [options] file.scen [file.scen ...]
+//   --map-dir DIR   directory of the .map files (default : directory of the .scen file)
+//   --engine NAME   engine to run, can be repeated (default : all engines)
+//   --repeat N      run each query N times, keep the fastest (default : 1)
+//   --no-verify     do not compute reference lengths
+//
+// or, on generated maps, one line per engine, size and density :
+//        bench [options] --sweep KIND
+//   --sizes LIST       comma separated map sizes, square maps (default : 256,1024)
+//   --densities LIST   comma separated densities (default : 0.2)
+//   --queries N        queries per map (default : 100)
+//   --seed S           random seed (default : 1)
+//
+// or, to compare the cost of rejecting bad queries with exceptions and with status codes :
+//        bench --reject N
+//
+// or, load test of FindPathAsync() : N queries on a generated map, with and without cancellations
+//        bench --async N [--sweep KIND] [--sizes SIZE] [--densities D] [--cancel RATIO] [--seed S]
+//
+// or, path length of the anytime engine against time, compared with the shortest length :
+//        bench --anytime [--sweep KIND] [--sizes SIZE] [--densities D] [--queries N] [--seed S]
+//
+// or, path length ratio and expansions of focal search for several suboptimality factors :
+//        bench --focal EPSILONS [--sweep KIND] [--sizes SIZE] [--densities D] [--queries N] [--seed S]
+//
+// or, peak memory and latency of A* and of the memory-bounded engine under several caps (in KB) :
+//        bench --memory CAPS [--sweep KIND] [--sizes SIZE] [--densities D] [--queries N] [--seed S]
+//
+// or, throughput of N threads running queries, with the search state on the heap or in per-thread arenas :
+//        bench --threads N [--sweep KIND] [--sizes SIZE] [--densities D] [--queries N] [--seed S]
+//
+// or, peak memory and latency of the dense and sparse search states, and of a std::map state, per query radius :
+//        bench --state RADII [--sweep KIND] [--sizes SIZE] [--densities D] [--queries N] [--seed S]
+//
+// or, latency and hardware cache and TLB misses of the row-major and tiled layouts, SIZE being WIDTHxHEIGHT or WIDTH :
+//        bench --cache [--sweep KIND] [--sizes SIZE] [--densities D] [--queries N] [--seed S]
+//
+// or, startup time from a Moving AI .map file and from a memory-mapped prepared map file, cold and warm,
+// unchecked and checked against the map, and the rebuild of a stale file :
+//        bench --startup [--sweep KIND] [--sizes SIZE] [--densities D] [--seed S]
+//
+// or, disk read and latency of queries of the given radius on a flat map file and on a compressed one, cold and warm :
+//        bench --compressed RADIUS [--sweep KIND] [--sizes SIZE] [--densities D] [--queries N] [--seed S]
+//
+// or, time, memory and disk I/O of the in-memory and external-memory searches, per map size, under a cap in KB :
+//        bench --external CAP [--sweep KIND] [--sizes LIST] [--densities D] [--queries N] [--seed S]
+//
+// or, peak resident memory, expansions and latency of A* in its dense and compact layouts and of frontier search :
+//        bench --frontier [--sweep KIND] [--sizes SIZE] [--densities D] [--queries N] [--seed S]
+//
+// or, latency of BasicPathfinder with compile-time policies and with the same policies chosen at runtime :
+//        bench --policies [--sweep KIND] [--sizes SIZE] [--densities D] [--queries N] [--seed S]
+//
+// or, latency of FindPath() on small maps, searched by FixedPathfinder, against Pathfinder, on the maps of
+// test/testFindPath.cpp scaled up by each factor (each cell becomes a FACTOR x FACTOR block) :
+//        bench --fixed FACTORS [--queries N] [--seed S]
+
+/*! \brief Hardware event counter of the calling thread, user space only (Linux perf events).
+ *
+ *  Not available on other systems, nor in virtual machines without a virtual PMU : valid() is then false.
+ */
+class PerfCounter
+{
+  public:
+  PerfCounter(const uint32_t type, const uint64_t config): _fd(-1)
+  {
+#ifdef __linux__
+    perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    _fd = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+#else
+    (void)type; (void)config;
+#endif
+  }
+  ~PerfCounter()
+  {
+#ifdef __linux__
+    if (_fd >= 0) { close(_fd); }
+#endif
+  }
+  PerfCounter(const PerfCounter&) = delete;
+  PerfCounter& operator=(const PerfCounter&) = delete;
+
+  bool valid() const { return _fd >= 0; }
+  long long read() const
+  {
+    long long value = 0;
+#ifdef __linux__
+    if (_fd >= 0 && ::read(_fd, &value, sizeof(value)) != (ssize_t)sizeof(value)) { value = 0; }
+#endif
+    return value;
+  }
+
+  private:
+  int _fd;
+};
+
+/*! \brief A map under benchmark, with the preprocessed data engines may need.
+ *
+ *  Preprocessing is done by prepare(), before any timing.
+ */
+struct BenchMap
+{
+  GridMap grid;
+  unique_ptr<PreparedMap> prepared;  //!< with every preprocessing option
+  vector<unsigned char> image;       //!< the map in the last channel of a larger RGBA image, 0 or 255
+  vector<int64_t> largeOutBuffer;    //!< output of the engines with 64-bit indexes, copied to the int output
+
+  static const int IMAGE_CHANNELS = 4;
+  static const int IMAGE_MARGIN = 16;
+
+  void prepare()
+  {
+    if (prepared) { return; }
+    PrepareOptions options;
+    options.padding = options.components = options.neighborMasks = true;
+    prepared.reset(new PreparedMap(grid.cells.data(), grid.width, grid.height, options));
+    largeOutBuffer.resize(grid.cells.size());
+    image.assign((size_t)(grid.width + 2*IMAGE_MARGIN) * (grid.height + 2*IMAGE_MARGIN) * IMAGE_CHANNELS, 0);
+    for (size_t index = 0; index < grid.cells.size(); ++index)
+    {
+      const size_t x = IMAGE_MARGIN + index % grid.width, y = IMAGE_MARGIN + index / grid.width;
+      image[(y*(grid.width + 2*IMAGE_MARGIN) + x)*IMAGE_CHANNELS + IMAGE_CHANNELS-1] = grid.cells[index] ? 255 : 0;
+    }
+  }
+  /*! \brief The map, read in place in the image */
+  MapView imageView() const
+  {
+    MapView view(image.data() + IMAGE_CHANNELS-1, grid.width + 2*IMAGE_MARGIN, grid.height + 2*IMAGE_MARGIN);
+    view.rowPitch = (ptrdiff_t)view.width * IMAGE_CHANNELS;
+    view.cellStride = IMAGE_CHANNELS;
+    view.threshold = 128;
+    return view.subView(IMAGE_MARGIN, IMAGE_MARGIN, grid.width, grid.height);
+  }
+};
+
+/*! \brief A search engine under benchmark, with the same contract as FindPath. */
+struct Engine
+{
+  const char* name;
+  int (*run)(const Scenario& scenario, BenchMap& map, int* pOutBuffer, const int nOutBufferSize, SearchStats* pStats);
+  double maxLengthRatio = 1;  //!< bound of the returned length over the shortest one : 1 for the optimal engines
+};
+
+static int runWithTieBreak(const Scenario& scenario, const GridMap& grid, int* pOutBuffer, const int nOutBufferSize,
+                           SearchStats* pStats, const TieBreak tieBreak, const SearchLayout layout = SearchLayout::Dense)
+{
+  Pathfinder pathfinder(scenario.start.X, scenario.start.Y, scenario.target.X, scenario.target.Y,
+                        grid.cells.data(), grid.width, grid.height, pOutBuffer, nOutBufferSize, tieBreak, layout);
+  return pathfinder.findPath(pStats);
+}
+
+/*! \brief The search in slices of INCREMENTAL_STEP expansions, to measure the cost of resuming. */
+static const int INCREMENTAL_STEP = 1024;
+static int runIncremental(const Scenario& scenario, const GridMap& grid, int* pOutBuffer, const int nOutBufferSize,
+                          SearchStats* pStats)
+{
+  IncrementalPathfinder search(scenario.start.X, scenario.start.Y, scenario.target.X, scenario.target.Y,
+                               grid.cells.data(), grid.width, grid.height, pOutBuffer, nOutBufferSize);
+  size_t bytesAllocated = search.bytesAllocated();
+  while (search.step(INCREMENTAL_STEP) == StepStatus::InProgress)
+  {
+    bytesAllocated = max(bytesAllocated, search.bytesAllocated());
+  }
+  if (pStats != nullptr)
+  {
+    *pStats = SearchStats();
+    pStats->nodesExpanded = search.nodesExpanded();
+    pStats->bytesAllocated = (long long)bytesAllocated;
+  }
+  return search.length();
+}
+
+/*! \brief Bound of the bounded-suboptimal engine, and caps of the memory-bounded ones */
+static const double FOCAL_EPSILON = 0.2;
+static const size_t MEMORY_BOUNDED_BYTES = 4 << 20;
+static const size_t EXTERNAL_BYTES = 1 << 20;
+
+/*! \brief A search with 64-bit indexes : its output is copied to the int output buffer */
+template<class Search>
+static int runLarge(BenchMap& map, int* pOutBuffer, const int nOutBufferSize, const Search& search)
+{
+  const int length = (int)search(map.largeOutBuffer.data(), (int64_t)min((size_t)nOutBufferSize, map.largeOutBuffer.size()));
+  if (length > 0 && length <= nOutBufferSize) { copy(map.largeOutBuffer.begin(), map.largeOutBuffer.begin() + length, pOutBuffer); }
+  return length;
+}
+
+static const Engine ENGINES[] =
+{
+  {"astar", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    return FindPath(s.start.X, s.start.Y, s.target.X, s.target.Y, m.grid.cells.data(), m.grid.width, m.grid.height, out, size, stats); }},
+  {"astar-view", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    return FindPath(s.start.X, s.start.Y, s.target.X, s.target.Y, m.imageView(), out, size, stats); }},
+  {"astar-fifo", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    return runWithTieBreak(s, m.grid, out, size, stats, TieBreak::Fifo); }},
+  {"astar-lifo", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    return runWithTieBreak(s, m.grid, out, size, stats, TieBreak::Lifo); }},
+  {"astar-lowerh", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    return runWithTieBreak(s, m.grid, out, size, stats, TieBreak::LowerH); }},
+  {"astar-compact", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    return runWithTieBreak(s, m.grid, out, size, stats, TieBreak::HigherG, SearchLayout::Compact); }},
+  {"astar-sparse", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    return runWithTieBreak(s, m.grid, out, size, stats, TieBreak::HigherG, SearchLayout::Sparse); }},
+  {"prepared", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    return m.prepared->findPath(s.start.X, s.start.Y, s.target.X, s.target.Y, out, size, stats); }},
+  {"incremental", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    return runIncremental(s, m.grid, out, size, stats); }},
+  {"anytime", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    AnytimePathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, m.grid.cells.data(), m.grid.width, m.grid.height, out, size);
+    return pathfinder.findPath(stats); }},
+  {"focal", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    FocalOptions options;
+    options.epsilon = FOCAL_EPSILON;
+    FocalPathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, m.grid.cells.data(), m.grid.width, m.grid.height, out, size, options);
+    return pathfinder.findPath(stats); }, 1 + FOCAL_EPSILON},
+  {"memory-bounded", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    // out of memory or stalled : counted as an error
+    MemoryBoundedPathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, m.grid.cells.data(), m.grid.width, m.grid.height,
+                                       out, size, MEMORY_BOUNDED_BYTES);
+    int length = -1;
+    return (pathfinder.findPathNoExcept(&length, stats) == FindPathStatus::Ok) ? length : -1; }},
+  {"large", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    const LargeMap map = LargeMap::bytes(m.grid.cells.data(), m.grid.width, m.grid.height);
+    return runLarge(m, out, size, [&](int64_t* largeOut, const int64_t largeSize) {
+      return FindPathLarge(s.start.X, s.start.Y, s.target.X, s.target.Y, map, largeOut, largeSize, stats); }); }},
+  {"external", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    const LargeMap map = LargeMap::bytes(m.grid.cells.data(), m.grid.width, m.grid.height);
+    ExternalSearchStats externalStats;
+    const int length = runLarge(m, out, size, [&](int64_t* largeOut, const int64_t largeSize) {
+      return FindPathExternal(s.start.X, s.start.Y, s.target.X, s.target.Y, map, largeOut, largeSize, EXTERNAL_BYTES, &externalStats); });
+    if (stats != nullptr)
+    {
+      *stats = SearchStats();
+      stats->nodesExpanded = externalStats.cellsReached;
+      stats->bytesAllocated = externalStats.bytesAllocated;
+    }
+    return length; }},
+  {"frontier", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    FrontierPathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, m.grid.cells.data(), m.grid.width, m.grid.height, out, size);
+    return pathfinder.findPath(stats); }},
+  {"basic", [](const Scenario& s, BenchMap& m, int* out, const int size, SearchStats* stats) {
+    const Map map(m.grid.cells.data(), m.grid.width, m.grid.height);
+    BasicPathfinder<> pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, map, out, size);
+    return pathfinder.findPath(stats); }},
+};
+
+/*! \brief Shortest 4-connected path length by breadth-first search, -1 if none. */
+static int referenceLength(const GridMap& grid, const Coordinates& start, const Coordinates& target)
+{
+  vector<int> distance(grid.cells.size(), -1);
+  queue<Coordinates> frontier;
+  distance[(size_t)start.Y*grid.width + start.X] = 0;
+  frontier.push(start);
+  const Map gridMap(grid.cells.data(), grid.width, grid.height);
+  while (!frontier.empty())
+  {
+    const Coordinates cell = frontier.front();
+    frontier.pop();
+    const int cellDistance = distance[(size_t)cell.Y*grid.width + cell.X];
+    if (cell == target) { return cellDistance; }
+    Coordinates neighbors[4];
+    const int nbNeighbors = gridMap.findNeighbors(cell, neighbors);
+    for (int i = 0; i < nbNeighbors; ++i)
+    {
+      int& neighborDistance = distance[(size_t)neighbors[i].Y*grid.width + neighbors[i].X];
+      if (neighborDistance < 0)
+      {
+        neighborDistance = cellDistance + 1;
+        frontier.push(neighbors[i]);
+      }
+    }
+  }
+  return -1;
+}
+
+/*! \brief Check the output buffer holds a contiguous path of passable cells from Start to Target. */
+static bool isValidPath(const GridMap& grid, const Scenario& scenario, const int* pPath, const int length)
+{
+  Coordinates previous = scenario.start;
+  for (int i = 0; i < length; ++i)
+  {
+    const Coordinates cell(pPath[i] % grid.width, pPath[i] / grid.width);
+    if (pPath[i] < 0 || pPath[i] >= (int)grid.cells.size() || grid.cells[pPath[i]] == 0) { return false; }
+    if (abs(cell.X - previous.X) + abs(cell.Y - previous.Y) != 1) { return false; }
+    previous = cell;
+  }
+  return previous == scenario.target;
+}
+
+/*! \brief Measurements of one engine on one query */
+struct Sample
+{
+  int bucket;
+  double microseconds;
+  long long expansions;
+  bool ok;
+};
+
+static double percentile(const vector<double>& sorted, const double ratio)
+{
+  if (sorted.empty()) { return 0; }
+  const size_t rank = min(sorted.size()-1, (size_t)(ratio*(sorted.size()-1) + 0.5));
+  return sorted[rank];
+}
+
+static const char* SUMMARY_HEADER = "%8s %10s %10s %10s %10s %12s %7s\n";
+
+/*! \brief Print queries count, latency percentiles, mean expansions and errors of samples */
+static void printSummary(const vector<const Sample*>& samples)
+{
+  vector<double> latencies;
+  long long expansions = 0;
+  int errors = 0;
+  for (const Sample* sample : samples)
+  {
+    latencies.push_back(sample->microseconds);
+    expansions += sample->expansions;
+    errors += sample->ok ? 0 : 1;
+  }
+  sort(latencies.begin(), latencies.end());
+  printf("%8zu %10.1f %10.1f %10.1f %10.1f %12.1f %7d\n", latencies.size(),
+         percentile(latencies, 0.5), percentile(latencies, 0.9), percentile(latencies, 0.99),
+         latencies.empty() ? 0 : latencies.back(), latencies.empty() ? 0 : (double)expansions / latencies.size(), errors);
+}
+
+static void report(const char* engineName, const vector<Sample>& samples)
+{
+  map<int, vector<const Sample*>> buckets;
+  for (const Sample& sample : samples) { buckets[sample.bucket].push_back(&sample); }
+
+  printf("\n%s\n", engineName);
+  printf("%8s ", "bucket");
+  printf(SUMMARY_HEADER, "queries", "p50 us", "p90 us", "p99 us", "max us", "expansions", "errors");
+  for (const auto& bucket : buckets)
+  {
+    printf("%8d ", bucket.first);
+    printSummary(bucket.second);
+  }
+}
+
+typedef vector<pair<BenchMap*, Scenario>> Queries;
+
+/*! \brief Reference lengths, checked against the optimal lengths of the scenarios (lower bounds for us) */
+static vector<int> computeReferences(const Queries& queries)
+{
+  vector<int> references(queries.size());
+  for (size_t q = 0; q < queries.size(); ++q)
+  {
+    const Scenario& scenario = queries[q].second;
+    references[q] = referenceLength(queries[q].first->grid, scenario.start, scenario.target);
+    if (references[q] >= 0 && references[q] + 1e-6 < scenario.optimalLength)
+    {
+      fprintf(stderr, "scenario %zu : 4-connected length %d is below optimal %.3f, wrong map ?\n",
+              q, references[q], scenario.optimalLength);
+    }
+  }
+  return references;
+}
+
+/*! \brief Run all queries through an engine. An empty references vector skips verification. */
+static vector<Sample> runEngine(const Engine& engine, const Queries& queries, const vector<int>& references, const int repeat)
+{
+  vector<Sample> samples;
+  for (size_t q = 0; q < queries.size(); ++q)
+  {
+    BenchMap& benchMap = *queries[q].first;
+    const GridMap& grid = benchMap.grid;
+    const Scenario& scenario = queries[q].second;
+    vector<int> outBuffer(grid.cells.size());
+    benchMap.prepare();
+    Sample sample = {scenario.bucket, 0, 0, true};
+
+    int length = -1;
+    for (int r = 0; r < repeat; ++r)
+    {
+      const auto startTime = chrono::steady_clock::now();
+      length = engine.run(scenario, benchMap, outBuffer.data(), (int)outBuffer.size(), nullptr);
+      const double microseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count();
+      sample.microseconds = (r == 0) ? microseconds : min(sample.microseconds, microseconds);
+    }
+    SearchStats stats;
+    engine.run(scenario, benchMap, outBuffer.data(), (int)outBuffer.size(), &stats);
+    sample.expansions = stats.nodesExpanded;
+
+    if (!references.empty())
+    {
+      // the bounded-suboptimal engines may return longer paths, up to their bound
+      const bool lengthOk = (references[q] < 0) ? (length < 0)
+                                                : (length >= references[q] && length <= references[q] * engine.maxLengthRatio + 1e-9);
+      sample.ok = lengthOk && (length < 0 || isValidPath(grid, scenario, outBuffer.data(), length));
+    }
+    samples.push_back(sample);
+  }
+  return samples;
+}
+
+static vector<string> splitList(const string& list)
+{
+  vector<string> items;
+  size_t begin = 0;
+  while (begin <= list.size())
+  {
+    const size_t end = min(list.find(',', begin), list.size());
+    if (end > begin) { items.push_back(list.substr(begin, end - begin)); }
+    begin = end + 1;
+  }
+  return items;
+}
+
+/*! \brief Sweep map sizes and densities on generated maps, one summary line per engine */
+static void sweep(const vector<const Engine*>& engines, MapGenParams params, const vector<string>& sizes,
+                  const vector<string>& densities, const int nbQueries, const int repeat, const bool verify)
+{
+  printf("%-10s %6s %8s %-14s ", "kind", "size", "density", "engine");
+  printf(SUMMARY_HEADER, "queries", "p50 us", "p90 us", "p99 us", "max us", "expansions", "errors");
+  for (const string& size : sizes)
+  {
+    for (const string& density : densities)
+    {
+      params.width = params.height = atoi(size.c_str());
+      params.density = atof(density.c_str());
+      BenchMap benchMap;
+      benchMap.grid = generateMap(params);
+      Queries queries;
+      for (const Scenario& scenario : generateScenarios(benchMap.grid, "generated", nbQueries, params.seed))
+      {
+        queries.emplace_back(&benchMap, scenario);
+      }
+      const vector<int> references = verify ? computeReferences(queries) : vector<int>();
+      for (const Engine* engine : engines)
+      {
+        const vector<Sample> samples = runEngine(*engine, queries, references, repeat);
+        vector<const Sample*> all;
+        for (const Sample& sample : samples) { all.push_back(&sample); }
+        printf("%-10s %6d %8.3f %-14s ", mapKindName(params.kind), params.width, params.density, engine->name);
+        printSummary(all);
+      }
+    }
+  }
+}
+
+static string directoryOf(const string& path)
+{
+  const size_t slash = path.find_last_of('/');
+  return (slash == string::npos) ? string(".") : path.substr(0, slash);
+}
+
+static string fileNameOf(const string& path)
+{
+  const size_t slash = path.find_last_of('/');
+  return (slash == string::npos) ? path : path.substr(slash + 1);
+}
+
+/*! \brief Time the rejection of queries with bad coordinates : BadInputException against FindPathNoExcept() */
+static void benchmarkRejects(const int count)
+{
+  const unsigned char pMap[] = {1, 1,
+                                1, 1};
+  int outBuffer[4];
+  int rejected = 0;
+
+  auto startTime = chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i)
+  {
+    try
+    {
+      FindPath(0, 0, 2 + (i & 1), 0, pMap, 2, 2, outBuffer, 4);
+    }
+    catch (const BadInputException&)
+    {
+      ++rejected;
+    }
+  }
+  const double throwingNs = chrono::duration<double, nano>(chrono::steady_clock::now() - startTime).count() / count;
+
+  startTime = chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i)
+  {
+    int length;
+    if (FindPathNoExcept(0, 0, 2 + (i & 1), 0, pMap, 2, 2, outBuffer, 4, &length) != FindPathStatus::Ok)
+    {
+      ++rejected;
+    }
+  }
+  const double statusNs = chrono::duration<double, nano>(chrono::steady_clock::now() - startTime).count() / count;
+
+  printf("%d rejected queries\n", rejected);
+  printf("%-20s %10.1f ns per reject\n", "BadInputException", throwingNs);
+  printf("%-20s %10.1f ns per reject\n", "FindPathNoExcept", statusNs);
+}
+
+/*! \brief Submit all queries to FindPathAsync(), cancelling a ratio of them just after submission.
+ *
+ *  Completion times are taken when each future is read, in submission order : as the executor
+ *  runs queries in that order too, this is close to their actual completion.
+ */
+static void loadTestAsync(const GridMap& grid, const vector<Scenario>& scenarios, const double cancelRatio)
+{
+  PrepareOptions options;
+  options.components = true;
+  const PreparedMap prepared(grid.cells.data(), grid.width, grid.height, options);
+  vector<vector<int>> outBuffers(scenarios.size(), vector<int>(grid.cells.size()));
+  vector<CancellationToken> tokens(scenarios.size());
+  vector<future<FindPathResult>> results;
+  vector<chrono::steady_clock::time_point> submitTimes;
+
+  const auto startTime = chrono::steady_clock::now();
+  const int cancelPeriod = (cancelRatio > 0) ? max(1, (int)(1 / cancelRatio + 0.5)) : 0;
+  for (size_t q = 0; q < scenarios.size(); ++q)
+  {
+    const Scenario& s = scenarios[q];
+    submitTimes.push_back(chrono::steady_clock::now());
+    results.push_back(FindPathAsync(prepared, s.start.X, s.start.Y, s.target.X, s.target.Y,
+                                    outBuffers[q].data(), (int)outBuffers[q].size(), tokens[q]));
+  }
+  for (size_t q = 0; q < scenarios.size(); ++q)
+  {
+    if (cancelPeriod > 0 && q % cancelPeriod == 0) { tokens[q].cancel(); }
+  }
+
+  vector<double> latencies;
+  int cancelled = 0;
+  for (size_t q = 0; q < results.size(); ++q)
+  {
+    const FindPathResult result = results[q].get();
+    if (result.status == FindPathStatus::Cancelled) { ++cancelled; continue; }
+    latencies.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - submitTimes[q]).count());
+  }
+  const double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+  sort(latencies.begin(), latencies.end());
+  printf("%-8.2f %9zu %9d %12.1f %10.2f %10.2f %10.2f\n", cancelRatio, latencies.size(), cancelled,
+         latencies.size() / seconds, percentile(latencies, 0.5), percentile(latencies, 0.99), seconds * 1000);
+}
+
+/*! \brief Every thread runs all the scenarios : with useArena, inside an ArenaScope on its own arena.
+ *
+ *  Prints the throughput, its scaling from one thread, and the heap allocations per query.
+ */
+static double loadTestThreads(const GridMap& grid, const vector<Scenario>& scenarios, const int nbThreads,
+                              const bool useArena, const double singleThreadRate)
+{
+  const PreparedMap prepared(grid.cells.data(), grid.width, grid.height);
+  atomic<long long> allocations(0);
+  auto work = [&]() {
+    vector<int> outBuffer(grid.cells.size());
+    // warm up : the arena reaches the size of the largest query
+    unique_ptr<ArenaScope> scope(useArena ? new ArenaScope() : nullptr);
+    for (const Scenario& s : scenarios)
+    {
+      prepared.findPath(s.start.X, s.start.Y, s.target.X, s.target.Y, outBuffer.data(), (int)outBuffer.size());
+    }
+    const long long allocationsBefore = threadHeapAllocations();
+    for (const Scenario& s : scenarios)
+    {
+      prepared.findPath(s.start.X, s.start.Y, s.target.X, s.target.Y, outBuffer.data(), (int)outBuffer.size());
+    }
+    allocations += threadHeapAllocations() - allocationsBefore;
+  };
+
+  const auto startTime = chrono::steady_clock::now();
+  vector<thread> threads;
+  for (int t = 0; t < nbThreads; ++t) { threads.emplace_back(work); }
+  for (thread& worker : threads) { worker.join(); }
+  const double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+  // the warm up is timed too : it is the same number of queries
+  const double rate = 2.0 * nbThreads * scenarios.size() / seconds;
+  const double scaling = (singleThreadRate > 0) ? rate / (singleThreadRate * nbThreads) : 1;
+  printf("%-8s %8d %12.1f %10.2f %14.2f\n", useArena ? "arena" : "heap", nbThreads, rate, scaling,
+         (double)allocations / (nbThreads * scenarios.size()));
+  return rate;
+}
+
+/*! \brief Best anytime path available at increasing time budgets, compared with the shortest path.
+ *
+ *  Each query runs once without budget, recording when each improved path was found :
+ *  the path available at a budget is the last one found before it.
+ */
+static void anytimeProfile(const GridMap& grid, const vector<Scenario>& scenarios)
+{
+  static const double BUDGETS_US[] = {50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000};
+  vector<int> outBuffer(grid.cells.size());
+  vector<int> shortest;
+  vector<vector<AnytimeSolution>> timelines;
+  vector<double> astarLatencies;
+  for (const Scenario& s : scenarios)
+  {
+    const auto startTime = chrono::steady_clock::now();
+    shortest.push_back(FindPath(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height,
+                                outBuffer.data(), (int)outBuffer.size()));
+    astarLatencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count());
+    AnytimePathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height,
+                                 outBuffer.data(), (int)outBuffer.size());
+    pathfinder.findPath();
+    timelines.push_back(pathfinder.solutions());
+  }
+  sort(astarLatencies.begin(), astarLatencies.end());
+  printf("astar : p50 %.1f us, p90 %.1f us\n", percentile(astarLatencies, 0.5), percentile(astarLatencies, 0.9));
+
+  printf("%10s %8s %12s %12s %12s\n", "budget us", "solved", "mean ratio", "max ratio", "mean bound");
+  for (const double budget : BUDGETS_US)
+  {
+    int solved = 0;
+    double sumRatio = 0, maxRatio = 0, sumBound = 0;
+    for (size_t q = 0; q < scenarios.size(); ++q)
+    {
+      if (shortest[q] <= 0) { continue; } // nothing to improve
+      const AnytimeSolution* best = nullptr;
+      for (const AnytimeSolution& solution : timelines[q])
+      {
+        if (solution.microseconds <= budget) { best = &solution; }
+      }
+      if (best == nullptr) { continue; }
+      ++solved;
+      const double ratio = (double)best->length / shortest[q];
+      sumRatio += ratio;
+      maxRatio = max(maxRatio, ratio);
+      sumBound += best->bound;
+    }
+    printf("%10.0f %8d %12.4f %12.4f %12.4f\n", budget, solved,
+           solved ? sumRatio / solved : 0, maxRatio, solved ? sumBound / solved : 0);
+  }
+}
+
+/*! \brief Path length ratio to the shortest path, expansions and latency of focal search per epsilon */
+static void focalProfile(const GridMap& grid, const vector<Scenario>& scenarios, const vector<string>& epsilons)
+{
+  vector<int> outBuffer(grid.cells.size());
+  vector<int> shortest;
+  for (const Scenario& s : scenarios)
+  {
+    shortest.push_back(FindPath(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height,
+                                outBuffer.data(), (int)outBuffer.size()));
+  }
+
+  printf("%-8s %-14s %12s %12s %12s %10s %10s\n", "epsilon", "heuristics", "mean ratio", "max ratio", "expansions", "p50 us", "p90 us");
+  for (const string& epsilon : epsilons)
+  {
+    for (const FocalHeuristic heuristic : {FocalHeuristic::DistanceToGo, FocalHeuristic::Deepest})
+    {
+      FocalOptions options;
+      options.epsilon = atof(epsilon.c_str());
+      options.heuristic = heuristic;
+      int nbPaths = 0;
+      double sumRatio = 0, maxRatio = 0, sumExpansions = 0;
+      vector<double> latencies;
+      for (size_t q = 0; q < scenarios.size(); ++q)
+      {
+        const Scenario& s = scenarios[q];
+        FocalPathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height,
+                                   outBuffer.data(), (int)outBuffer.size(), options);
+        SearchStats stats;
+        const auto startTime = chrono::steady_clock::now();
+        const int length = pathfinder.findPath(&stats);
+        latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count());
+        sumExpansions += stats.nodesExpanded;
+        if (shortest[q] <= 0) { continue; }
+        ++nbPaths;
+        sumRatio += (double)length / shortest[q];
+        maxRatio = max(maxRatio, (double)length / shortest[q]);
+      }
+      sort(latencies.begin(), latencies.end());
+      printf("%-8.3f %-14s %12.4f %12.4f %12.1f %10.1f %10.1f\n", options.epsilon,
+             (heuristic == FocalHeuristic::DistanceToGo) ? "distance-to-go" : "deepest",
+             nbPaths ? sumRatio / nbPaths : 0, maxRatio, sumExpansions / scenarios.size(),
+             percentile(latencies, 0.5), percentile(latencies, 0.9));
+    }
+  }
+}
+
+/*! \brief Peak memory, expansions and latency of A*, in both search layouts, and of the memory-bounded engine per cap */
+static void memoryProfile(const GridMap& grid, const vector<Scenario>& scenarios, const vector<string>& capsInKB)
+{
+  vector<int> outBuffer(grid.cells.size());
+  printf("%-16s %12s %12s %12s %10s %10s %8s %8s %8s\n", "engine", "cap KB", "peak KB", "expansions", "p50 us", "p90 us", "no mem", "stalled", "errors");
+
+  auto profile = [&](const char* name, const size_t maxBytes, const SearchLayout layout) {
+    vector<double> latencies;
+    long long peakBytes = 0;
+    double sumExpansions = 0;
+    int outOfMemory = 0;
+    int stalled = 0;
+    int errors = 0;
+    for (const Scenario& s : scenarios)
+    {
+      SearchStats stats;
+      const auto startTime = chrono::steady_clock::now();
+      int length = -1;
+      if (maxBytes == 0)
+      {
+        Pathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height,
+                              outBuffer.data(), (int)outBuffer.size(), TieBreak::HigherG, layout);
+        length = pathfinder.findPath(&stats);
+      }
+      else
+      {
+        MemoryBoundedPathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height,
+                                           outBuffer.data(), (int)outBuffer.size(), maxBytes);
+        const FindPathStatus status = pathfinder.findPathNoExcept(&length, &stats);
+        if (status == FindPathStatus::OutOfMemory) { ++outOfMemory; }
+        if (status == FindPathStatus::Stalled)     { ++stalled; }
+      }
+      latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count());
+      peakBytes = max(peakBytes, stats.bytesAllocated);
+      sumExpansions += stats.nodesExpanded;
+      if (length >= 0 && length != referenceLength(grid, s.start, s.target)) { ++errors; }
+    }
+    sort(latencies.begin(), latencies.end());
+    printf("%-16s %12.0f %12.1f %12.1f %10.1f %10.1f %8d %8d %8d\n", name, maxBytes / 1024.0, peakBytes / 1024.0,
+           sumExpansions / scenarios.size(), percentile(latencies, 0.5), percentile(latencies, 0.9), outOfMemory, stalled, errors);
+  };
+
+  profile("astar", 0, SearchLayout::Dense);
+  profile("astar-compact", 0, SearchLayout::Compact);
+  for (const string& cap : capsInKB)
+  {
+    profile("memory-bounded", (size_t)atof(cap.c_str()) * 1024, SearchLayout::Dense);
+  }
+}
+
+/*! \brief A* keeping its per cell state in a std::map, as a baseline for the sparse state. Returns the length.
+ *
+ *  The memory is estimated : map entries plus the rebalancing tree overhead of each node.
+ */
+static int mapStateAstar(const GridMap& grid, const Coordinates& start, const Coordinates& target, long long* pBytes)
+{
+  struct CellState
+  {
+    int costFromStart;
+    bool closed;
+  };
+  const Map gridMap(grid.cells.data(), grid.width, grid.height);
+  map<int, CellState> states;
+  PriorityQueue<int> q(TieBreak::HigherG);
+  states[gridMap.coordinatesToIndex(start)] = CellState{0, false};
+  q.put(gridMap.coordinatesToIndex(start), 0, 0);
+  size_t peakOpenListSize = 1;
+  int length = -1;
+  while (!q.empty())
+  {
+    const int index = q.dequeue();
+    CellState& current = states[index];
+    if (current.closed) { continue; }
+    current.closed = true;
+    const Coordinates cell = gridMap.indexToCoordinates(index);
+    if (cell == target) { length = current.costFromStart; break; }
+    const int newCost = current.costFromStart + 1;
+    Coordinates neighbors[4];
+    const int nbNeighbors = gridMap.findNeighbors(cell, neighbors);
+    for (int i = 0; i < nbNeighbors; ++i)
+    {
+      const int nextIndex = gridMap.coordinatesToIndex(neighbors[i]);
+      auto inserted = states.insert(make_pair(nextIndex, CellState{newCost, false}));
+      if (!inserted.second)
+      {
+        if (inserted.first->second.closed || inserted.first->second.costFromStart <= newCost) { continue; }
+        inserted.first->second.costFromStart = newCost;
+      }
+      q.put(nextIndex, newCost + gridMap.distance(neighbors[i], target), newCost);
+    }
+    peakOpenListSize = max(peakOpenListSize, q.size());
+  }
+  *pBytes = (long long)(states.size() * (sizeof(pair<const int, CellState>) + 4*sizeof(void*)) +
+                        peakOpenListSize * sizeof(PriorityQueue<int>::PQElement));
+  return length;
+}
+
+/*! \brief Peak memory and latency of the search states per query radius, with the layout chosen by SearchLayout::Automatic */
+static void stateProfile(const GridMap& grid, const vector<string>& radii, const int nbQueries, const uint64_t seed)
+{
+  vector<int> outBuffer(grid.cells.size());
+  SplitMix64 rng(seed);
+  printf("%-8s %-10s %12s %10s %10s %8s\n", "radius", "state", "peak KB", "p50 us", "p90 us", "errors");
+  for (const string& radiusText : radii)
+  {
+    // targets at the given Manhattan distance from random starts, reachable
+    const int radius = atoi(radiusText.c_str());
+    vector<Scenario> scenarios;
+    for (int attempt = 0; attempt < 100 * nbQueries && (int)scenarios.size() < nbQueries; ++attempt)
+    {
+      Scenario s;
+      s.start = Coordinates((int)rng.below(grid.width), (int)rng.below(grid.height));
+      const int dx = (int)rng.below(radius + 1);
+      s.target = Coordinates(s.start.X + (rng.below(2) ? dx : -dx), s.start.Y + (rng.below(2) ? radius - dx : dx - radius));
+      if (s.target.X < 0 || s.target.X >= grid.width || s.target.Y < 0 || s.target.Y >= grid.height) { continue; }
+      if (!grid.cells[(size_t)s.start.Y*grid.width + s.start.X] || !grid.cells[(size_t)s.target.Y*grid.width + s.target.X]) { continue; }
+      if (runWithTieBreak(s, grid, outBuffer.data(), (int)outBuffer.size(), nullptr, TieBreak::HigherG, SearchLayout::Compact) < 0) { continue; }
+      scenarios.push_back(s);
+    }
+    const Pathfinder automatic(0, 0, radius, 0, grid.cells.data(), grid.width, grid.height, outBuffer.data(), (int)outBuffer.size());
+    const char* chosen = (automatic.layout() == SearchLayout::Sparse) ? "sparse" : "dense";
+
+    auto profile = [&](const char* name, const int layout) {
+      vector<double> latencies;
+      long long peakBytes = 0;
+      int errors = 0;
+      for (const Scenario& s : scenarios)
+      {
+        SearchStats stats;
+        const int reference = runWithTieBreak(s, grid, outBuffer.data(), (int)outBuffer.size(), nullptr, TieBreak::HigherG, SearchLayout::Compact);
+        const auto startTime = chrono::steady_clock::now();
+        const int length = (layout < 0) ? mapStateAstar(grid, s.start, s.target, &stats.bytesAllocated)
+                                        : runWithTieBreak(s, grid, outBuffer.data(), (int)outBuffer.size(), &stats, TieBreak::HigherG, (SearchLayout)layout);
+        latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count());
+        peakBytes = max(peakBytes, stats.bytesAllocated);
+        if (length != reference) { ++errors; }
+      }
+      sort(latencies.begin(), latencies.end());
+      printf("%-8d %-10s %12.1f %10.1f %10.1f %8d\n", radius, name, peakBytes / 1024.0,
+             percentile(latencies, 0.5), percentile(latencies, 0.9), errors);
+    };
+    profile("dense", (int)SearchLayout::Dense);
+    profile("sparse", (int)SearchLayout::Sparse);
+    profile("std::map", -1);
+    printf("%-8d automatic : %s\n", radius, chosen);
+  }
+}
+
+/*! \brief Latency, cache misses and TLB misses per query of the dense and compact searches, row-major and tiled */
+static void cacheProfile(const GridMap& grid, const vector<Scenario>& scenarios)
+{
+#ifdef __linux__
+  const PerfCounter cacheMisses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+  const PerfCounter tlbMisses(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#else
+  const PerfCounter cacheMisses(0, 0), tlbMisses(0, 0);
+#endif
+  if (!cacheMisses.valid()) { printf("hardware counters not available : latency only\n"); }
+
+  vector<int> outBuffer(grid.cells.size());
+  printf("%-10s %-8s %10s %10s %14s %14s %8s\n", "layout", "state", "p50 us", "p90 us", "cache misses", "dTLB misses", "errors");
+  for (const bool tiled : {false, true})
+  {
+    PrepareOptions options;
+    options.neighborMasks = true;
+    options.tiledLayout = tiled;
+    const PreparedMap prepared(grid.cells.data(), grid.width, grid.height, options);
+    for (const SearchLayout layout : {SearchLayout::Dense, SearchLayout::Compact})
+    {
+      vector<double> latencies;
+      double sumCacheMisses = 0, sumTlbMisses = 0;
+      int errors = 0;
+      for (const Scenario& s : scenarios)
+      {
+        Pathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, prepared,
+                              outBuffer.data(), (int)outBuffer.size(), TieBreak::HigherG, layout);
+        const long long cacheMissesBefore = cacheMisses.read(), tlbMissesBefore = tlbMisses.read();
+        const auto startTime = chrono::steady_clock::now();
+        const int length = pathfinder.findPath();
+        latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count());
+        sumCacheMisses += cacheMisses.read() - cacheMissesBefore;
+        sumTlbMisses += tlbMisses.read() - tlbMissesBefore;
+        if (length >= 0 && !isValidPath(grid, s, outBuffer.data(), length)) { ++errors; }
+      }
+      sort(latencies.begin(), latencies.end());
+      char cacheText[32] = "n/a", tlbText[32] = "n/a";
+      if (cacheMisses.valid()) { snprintf(cacheText, sizeof(cacheText), "%.0f", sumCacheMisses / scenarios.size()); }
+      if (tlbMisses.valid())   { snprintf(tlbText, sizeof(tlbText), "%.0f", sumTlbMisses / scenarios.size()); }
+      printf("%-10s %-8s %10.1f %10.1f %14s %14s %8d\n", tiled ? "tiled" : "row-major",
+             (layout == SearchLayout::Dense) ? "dense" : "compact",
+             percentile(latencies, 0.5), percentile(latencies, 0.9), cacheText, tlbText, errors);
+    }
+  }
+}
+
+/*! \brief Drop the pages of a file from the page cache, for a cold start. Linux only */
+static bool evictFromPageCache(const string& path)
+{
+#ifdef __linux__
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) { return false; }
+  // dirty pages cannot be dropped : write them first
+  const bool evicted = fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+  close(fd);
+  return evicted;
+#else
+  (void)path;
+  return false;
+#endif
+}
+
+/*! \brief Time to load a map and answer its first query : from the .map text, and from a prepared map file */
+static void startupProfile(const GridMap& grid, const Scenario& firstQuery)
+{
+  const string textPath = "bench-startup.map";
+  const string mappedPath = "bench-startup.pfmap";
+  PrepareOptions options;
+  options.padding = options.components = options.neighborMasks = true;
+  saveMovingAIMap(grid, textPath);
+  savePreparedMap(PreparedMap(grid.cells.data(), grid.width, grid.height, options), mappedPath);
+
+  vector<int> outBuffer(grid.cells.size());
+  printf("%-14s %-6s %12s %12s %12s\n", "source", "cache", "ready ms", "query ms", "owned MB");
+  auto milliseconds = [](const chrono::steady_clock::time_point& since) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - since).count();
+  };
+  for (const bool cold : {true, false})
+  {
+    if (cold && !(evictFromPageCache(textPath) && evictFromPageCache(mappedPath)))
+    {
+      printf("cannot drop the files from the page cache : warm only\n");
+      continue;
+    }
+    // what the service does today : parse the text map, then preprocess it
+    auto startTime = chrono::steady_clock::now();
+    const GridMap loaded = loadMovingAIMap(textPath);
+    const PreparedMap prepared(loaded.cells.data(), loaded.width, loaded.height, options);
+    const double readyText = milliseconds(startTime);
+    startTime = chrono::steady_clock::now();
+    prepared.findPath(firstQuery.start.X, firstQuery.start.Y, firstQuery.target.X, firstQuery.target.Y,
+                      outBuffer.data(), (int)outBuffer.size());
+    printf("%-14s %-6s %12.1f %12.1f %12.1f\n", ".map + prepare", cold ? "cold" : "warm", readyText, milliseconds(startTime),
+           (loaded.cells.size() + prepared.bytesAllocated()) / 1e6);
+
+    startTime = chrono::steady_clock::now();
+    const MappedMap mapped(mappedPath);
+    const double readyMapped = milliseconds(startTime);
+    startTime = chrono::steady_clock::now();
+    mapped.prepared().findPath(firstQuery.start.X, firstQuery.start.Y, firstQuery.target.X, firstQuery.target.Y,
+                               outBuffer.data(), (int)outBuffer.size());
+    printf("%-14s %-6s %12.1f %12.1f %12.1f\n", mapped.isMapped() ? "mmap" : "read", cold ? "cold" : "warm",
+           readyMapped, milliseconds(startTime), mapped.prepared().bytesAllocated() / 1e6);
+
+    // a restart which checks the file against the map it serves : fingerprint and checksums read everything
+    startTime = chrono::steady_clock::now();
+    const unique_ptr<MappedMap> checked = openOrBuildPreparedMap(mappedPath, grid.cells.data(), grid.width, grid.height, options);
+    const double readyChecked = milliseconds(startTime);
+    startTime = chrono::steady_clock::now();
+    checked->prepared().findPath(firstQuery.start.X, firstQuery.start.Y, firstQuery.target.X, firstQuery.target.Y,
+                                 outBuffer.data(), (int)outBuffer.size());
+    printf("%-14s %-6s %12.1f %12.1f %12.1f\n", "mmap + checks", cold ? "cold" : "warm",
+           readyChecked, milliseconds(startTime), checked->prepared().bytesAllocated() / 1e6);
+  }
+
+  // the map changed since the file was written : the restart rebuilds it
+  vector<unsigned char> changed = grid.cells;
+  changed[0] = !changed[0];
+  auto startTime = chrono::steady_clock::now();
+  bool rebuilt = false;
+  const unique_ptr<MappedMap> stale = openOrBuildPreparedMap(mappedPath, changed.data(), grid.width, grid.height, options, &rebuilt);
+  printf("%-14s %-6s %12.1f %12s %12.1f\n", rebuilt ? "stale, rebuilt" : "stale, kept", "warm", milliseconds(startTime), "",
+         stale->prepared().bytesAllocated() / 1e6);
+  remove(textPath.c_str());
+  remove(mappedPath.c_str());
+}
+
+/*! \brief Bytes of a file in the page cache, i.e. read from disk since it was evicted. Linux only, -1 elsewhere */
+static long long residentBytes(const string& path)
+{
+#ifdef __linux__
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) { return -1; }
+  struct stat status;
+  long long resident = -1;
+  if (fstat(fd, &status) == 0 && status.st_size > 0)
+  {
+    void* file = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (file != MAP_FAILED)
+    {
+      const long pageSize = sysconf(_SC_PAGESIZE);
+      vector<unsigned char> pages((size_t)((status.st_size + pageSize - 1) / pageSize));
+      if (mincore(file, (size_t)status.st_size, pages.data()) == 0)
+      {
+        resident = 0;
+        for (const unsigned char page : pages) { resident += (page & 1) ? pageSize : 0; }
+      }
+      munmap(file, (size_t)status.st_size);
+    }
+  }
+  close(fd);
+  return resident;
+#else
+  (void)path;
+  return -1;
+#endif
+}
+
+/*! \brief Disk read and latency of queries of a given radius, on the flat map file and on the compressed one */
+static void compressedProfile(const GridMap& grid, const int radius, const int nbQueries, const uint64_t seed)
+{
+#ifndef __linux__
+  (void)grid; (void)radius; (void)nbQueries; (void)seed;
+  printf("the flat file is mapped with mmap, and evicted from the page cache : Linux only\n");
+#else
+  // reachable targets at the given Manhattan distance from random starts, as stateProfile()
+  SplitMix64 rng(seed);
+  vector<Scenario> scenarios;
+  vector<int64_t> outBuffer(grid.cells.size());
+  const LargeMap flatMap = LargeMap::bytes(grid.cells.data(), grid.width, grid.height);
+  vector<int64_t> references;
+  for (int attempt = 0; attempt < 100 * nbQueries && (int)scenarios.size() < nbQueries; ++attempt)
+  {
+    Scenario s;
+    s.start = Coordinates((int)rng.below(grid.width), (int)rng.below(grid.height));
+    const int dx = (int)rng.below(radius + 1);
+    s.target = Coordinates(s.start.X + (rng.below(2) ? dx : -dx), s.start.Y + (rng.below(2) ? radius - dx : dx - radius));
+    if (s.target.X < 0 || s.target.X >= grid.width || s.target.Y < 0 || s.target.Y >= grid.height) { continue; }
+    if (!grid.cells[(size_t)s.start.Y*grid.width + s.start.X] || !grid.cells[(size_t)s.target.Y*grid.width + s.target.X]) { continue; }
+    const int64_t length = FindPathLarge(s.start.X, s.start.Y, s.target.X, s.target.Y, flatMap, outBuffer.data(), (int64_t)outBuffer.size());
+    if (length < 0) { continue; }
+    scenarios.push_back(s);
+    references.push_back(length);
+  }
+
+  const string flatPath = "bench-compressed.cells";
+  const string compressedPath = "bench-compressed.pftiles";
+  {
+    FILE* file = fopen(flatPath.c_str(), "wb");
+    if (file == nullptr || fwrite(grid.cells.data(), 1, grid.cells.size(), file) != grid.cells.size()) { printf("cannot write %s\n", flatPath.c_str()); }
+    if (file != nullptr) { fclose(file); }
+  }
+  const auto startTime = chrono::steady_clock::now();
+  CompressedMap(grid.cells.data(), grid.width, grid.height).save(compressedPath);
+  printf("%zu queries, compressed in %.0f ms\n", scenarios.size(),
+         chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count());
+
+  printf("%-12s %-6s %10s %10s %10s %10s %12s %8s\n", "format", "cache", "file MB", "read MB", "p50 us", "p90 us", "tiles/query", "errors");
+  for (const bool cold : {true, false})
+  {
+    // flat files mapped as MappedMap does, and without readahead as CompressedMap does
+    for (const char* format : {"flat", "flat random", "compressed"})
+    {
+      const bool compressed = !strcmp(format, "compressed");
+      const string& path = compressed ? compressedPath : flatPath;
+      if (cold && !evictFromPageCache(path))
+      {
+        printf("cannot drop %s from the page cache\n", path.c_str());
+        continue;
+      }
+      unique_ptr<CompressedMap> compressedMap;
+      unique_ptr<TileCache> cache;
+      const unsigned char* cells = nullptr;
+      size_t fileSize = grid.cells.size();
+      if (compressed)
+      {
+        compressedMap.reset(new CompressedMap(path));
+        cache.reset(new TileCache(*compressedMap));
+        fileSize = compressedMap->compressedSize();
+      }
+      else
+      {
+        const int fd = open(path.c_str(), O_RDONLY);
+        void* file = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (file == MAP_FAILED) { printf("cannot map %s\n", path.c_str()); return; }
+        if (!strcmp(format, "flat random")) { madvise(file, fileSize, MADV_RANDOM); }
+        cells = static_cast<const unsigned char*>(file);
+      }
+      const LargeMap map = compressed ? LargeMap::compressed(*cache) : LargeMap::bytes(cells, grid.width, grid.height);
+
+      vector<double> latencies;
+      int errors = 0;
+      for (size_t q = 0; q < scenarios.size(); ++q)
+      {
+        const Scenario& s = scenarios[q];
+        const auto queryStart = chrono::steady_clock::now();
+        const int64_t length = FindPathLarge(s.start.X, s.start.Y, s.target.X, s.target.Y, map, outBuffer.data(), (int64_t)outBuffer.size());
+        latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - queryStart).count());
+        if (length != references[q]) { ++errors; }
+      }
+      sort(latencies.begin(), latencies.end());
+      const long long resident = residentBytes(path);
+      char readText[32] = "n/a", tilesText[32] = "";
+      if (cold && resident >= 0) { snprintf(readText, sizeof(readText), "%.2f", resident / 1e6); }
+      if (compressed) { snprintf(tilesText, sizeof(tilesText), "%.1f", (double)cache->decompressions() / max<size_t>(1, scenarios.size())); }
+      printf("%-12s %-6s %10.2f %10s %10.1f %10.1f %12s %8d\n", format, cold ? "cold" : "warm",
+             fileSize / 1e6, readText, percentile(latencies, 0.5), percentile(latencies, 0.9), tilesText, errors);
+      if (!compressed) { munmap(const_cast<unsigned char*>(cells), fileSize); }
+    }
+  }
+  remove(flatPath.c_str());
+  remove(compressedPath.c_str());
+#endif
+}
+
+/*! \brief FindPathLarge() against FindPathExternal() under a memory cap, for each map size */
+static void externalProfile(MapGenParams params, const vector<string>& sizes, const size_t capBytes, const int nbQueries)
+{
+  printf("%-8s %-10s %10s %10s %12s %12s %12s %8s\n", "size", "engine", "mean ms", "max ms", "memory MB", "written MB", "read MB", "errors");
+  for (const string& size : sizes)
+  {
+    params.width = params.height = atoi(size.c_str());
+    const GridMap grid = generateMap(params);
+    const vector<Scenario> scenarios = generateScenarios(grid, "generated", nbQueries, params.seed);
+    const LargeMap map = LargeMap::bytes(grid.cells.data(), grid.width, grid.height);
+    vector<int64_t> outBuffer(grid.cells.size());
+    vector<int64_t> references;
+
+    double sumMs = 0, maxMs = 0;
+    long long peakBytes = 0;
+    for (const Scenario& s : scenarios)
+    {
+      SearchStats stats;
+      const auto startTime = chrono::steady_clock::now();
+      references.push_back(FindPathLarge(s.start.X, s.start.Y, s.target.X, s.target.Y, map, outBuffer.data(), (int64_t)outBuffer.size(), &stats));
+      const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+      sumMs += ms;
+      maxMs = max(maxMs, ms);
+      peakBytes = max(peakBytes, stats.bytesAllocated);
+    }
+    printf("%-8s %-10s %10.1f %10.1f %12.2f %12s %12s %8s\n", size.c_str(), "in-memory", sumMs / scenarios.size(), maxMs, peakBytes / 1e6, "", "", "");
+
+    sumMs = maxMs = 0;
+    peakBytes = 0;
+    long long written = 0, read = 0;
+    int errors = 0;
+    for (size_t q = 0; q < scenarios.size(); ++q)
+    {
+      const Scenario& s = scenarios[q];
+      ExternalSearchStats stats;
+      const auto startTime = chrono::steady_clock::now();
+      const int64_t length = FindPathExternal(s.start.X, s.start.Y, s.target.X, s.target.Y, map, outBuffer.data(), (int64_t)outBuffer.size(),
+                                              capBytes, &stats);
+      const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+      sumMs += ms;
+      maxMs = max(maxMs, ms);
+      peakBytes = max(peakBytes, stats.bytesAllocated);
+      written += stats.bytesWritten;
+      read += stats.bytesRead;
+      if (length != references[q]) { ++errors; }
+    }
+    printf("%-8s %-10s %10.1f %10.1f %12.2f %12.1f %12.1f %8d\n", size.c_str(), "external", sumMs / scenarios.size(), maxMs,
+           peakBytes / 1e6, written / 1e6 / scenarios.size(), read / 1e6 / scenarios.size(), errors);
+  }
+}
+
+/*! \brief Restart the peak resident memory of the process from its current resident memory. Linux only */
+static void resetPeakResident()
+{
+#ifdef __linux__
+  FILE* file = fopen("/proc/self/clear_refs", "w");
+  if (file != nullptr)
+  {
+    fputs("5", file);
+    fclose(file);
+  }
+#endif
+}
+
+/*! \brief Peak resident memory of the process (VmHWM) in bytes, since the last resetPeakResident(). -1 if unknown */
+static long long peakResidentBytes()
+{
+  long long peak = -1;
+#ifdef __linux__
+  FILE* file = fopen("/proc/self/status", "r");
+  if (file == nullptr) { return -1; }
+  char line[256];
+  while (fgets(line, sizeof(line), file) != nullptr)
+  {
+    if (!strncmp(line, "VmHWM:", 6)) { peak = atoll(line + 6) * 1024; }
+  }
+  fclose(file);
+#endif
+  return peak;
+}
+
+/*! \brief Peak memory of A* and of FrontierPathfinder : resident, above the map, and as reported by their statistics */
+static void frontierProfile(const GridMap& grid, const vector<Scenario>& scenarios)
+{
+  // the path only : a buffer of the map size would dwarf the search states
+  vector<int> outBuffer(8 * (grid.width + grid.height));
+  printf("%-14s %12s %12s %14s %10s %10s %8s\n", "engine", "peak RSS MB", "alloc MB", "expansions", "mean ms", "max ms", "errors");
+  vector<int> references;  // lengths found by the first engine, checked against the others
+
+  auto profile = [&](const char* name, const bool frontier, const SearchLayout layout) {
+    long long peakResident = 0, peakBytes = 0;
+    double sumExpansions = 0, sumMs = 0, maxMs = 0;
+    int errors = 0;
+    for (size_t q = 0; q < scenarios.size(); ++q)
+    {
+      const Scenario& s = scenarios[q];
+      SearchStats stats;
+      int length = -1;
+      // right after the reset, the peak is the resident memory before the query : the map, mostly
+      resetPeakResident();
+      const long long baseline = peakResidentBytes();
+      const auto startTime = chrono::steady_clock::now();
+      if (frontier)
+      {
+        FrontierPathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height,
+                                      outBuffer.data(), (int)outBuffer.size());
+        length = pathfinder.findPath(&stats);
+      }
+      else
+      {
+        Pathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height,
+                              outBuffer.data(), (int)outBuffer.size(), TieBreak::HigherG, layout);
+        length = pathfinder.findPath(&stats);
+      }
+      const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+      const long long resident = peakResidentBytes();
+      if (resident >= 0 && baseline >= 0) { peakResident = max(peakResident, resident - min(baseline, resident)); }
+      peakBytes = max(peakBytes, stats.bytesAllocated);
+      sumExpansions += stats.nodesExpanded;
+      sumMs += ms;
+      maxMs = max(maxMs, ms);
+      if (references.size() <= q) { references.push_back(length); }
+      else if (length != references[q]) { ++errors; }
+    }
+    printf("%-14s %12.1f %12.1f %14.0f %10.1f %10.1f %8d\n", name, peakResident / 1e6, peakBytes / 1e6,
+           sumExpansions / scenarios.size(), sumMs / scenarios.size(), maxMs, errors);
+  };
+
+  profile("astar", false, SearchLayout::Dense);
+  profile("astar-compact", false, SearchLayout::Compact);
+  profile("frontier", true, SearchLayout::Automatic);
+}
+
+// The policies of BasicPathfinder chosen at runtime, as runtime switches in the search loop would :
+// the same search, with a branch or an out-of-line call where the static policies are inlined.
+
+/*! \brief 4 or 8-connected */
+struct RuntimeConnectivity
+{
+  static const int MAX_NEIGHBORS = EightConnected::MAX_NEIGHBORS;
+  bool eightConnected;
+
+  int directionCount() const { return eightConnected ? 8 : 4; }
+  static int dx(const int direction) { return EightConnected::DX[direction]; }
+  static int dy(const int direction) { return EightConnected::DY[direction]; }
+  static bool isDiagonal(const int direction) { return direction >= 4; }
+};
+
+/*! \brief Costs of the straight and diagonal moves */
+struct RuntimeCost
+{
+  int straightCost, diagonalCost;
+
+  int straight() const { return straightCost; }
+  int diagonal() const { return diagonalCost; }
+  int moveCost(const Coordinates& from, const Coordinates& to) const
+  {
+    return (from.X != to.X && from.Y != to.Y) ? diagonalCost : straightCost;
+  }
+};
+
+/*! \brief One of the heuristics of basicpathfinder.hpp */
+struct RuntimeHeuristic
+{
+  enum Kind { Manhattan, Octile, Zero } kind;
+
+  int estimate(const RuntimeCost& costModel, const Coordinates& from, const Coordinates& to) const
+  {
+    switch (kind)
+    {
+      case Manhattan: return ManhattanHeuristic::estimate(costModel, from, to);
+      case Octile:    return OctileHeuristic::estimate(costModel, from, to);
+      default:        return ZeroHeuristic::estimate(costModel, from, to);
+    }
+  }
+};
+
+// the open list : Pathfinder's HeapOpenList, tie-break chosen at runtime, out-of-line operations
+typedef BasicPathfinder<RuntimeConnectivity, RuntimeCost, RuntimeHeuristic, HeapOpenList> RuntimePathfinder;
+
+/*! \brief Mean latency in us of a search over the scenarios, in one round, and its expansions and costs */
+template<class Search>
+static double timeRound(const vector<Scenario>& scenarios, const Search& search, double* pExpansions, vector<int>* pCosts)
+{
+  pCosts->clear();
+  *pExpansions = 0;
+  const auto startTime = chrono::steady_clock::now();
+  for (const Scenario& s : scenarios)
+  {
+    SearchStats stats;
+    pCosts->push_back(search(s, &stats));
+    *pExpansions += stats.nodesExpanded;
+  }
+  *pExpansions /= scenarios.size();
+  return chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count() / scenarios.size();
+}
+
+/*! \brief Print the fastest of POLICY_ROUNDS rounds of a static and a runtime search, alternated so that both see the same machine */
+static const int POLICY_ROUNDS = 7;
+template<class StaticSearch, class RuntimeSearch>
+static void comparePolicies(const char* name, const vector<Scenario>& scenarios,
+                            const StaticSearch& staticSearch, const RuntimeSearch& runtimeSearch)
+{
+  double staticUs = 1e300, runtimeUs = 1e300, expansions = 0;
+  vector<int> staticCosts, runtimeCosts;
+  for (int round = 0; round < POLICY_ROUNDS; ++round)
+  {
+    staticUs = min(staticUs, timeRound(scenarios, staticSearch, &expansions, &staticCosts));
+    runtimeUs = min(runtimeUs, timeRound(scenarios, runtimeSearch, &expansions, &runtimeCosts));
+  }
+  int errors = 0;
+  for (size_t q = 0; q < staticCosts.size(); ++q) { errors += (staticCosts[q] != runtimeCosts[q]) ? 1 : 0; }
+  printf("%-32s %12.1f %12.1f %10.2f %12.0f %8d\n", name, staticUs, runtimeUs, runtimeUs / staticUs, expansions, errors);
+}
+
+/*! \brief Compile-time policies against the same policies chosen at runtime, for a few combinations */
+static void policyProfile(const GridMap& grid, const vector<Scenario>& scenarios)
+{
+  vector<int> outBuffer(grid.cells.size());
+  int* out = outBuffer.data();
+  const int size = (int)outBuffer.size();
+  printf("%-32s %12s %12s %10s %12s %8s\n", "policies", "static us", "runtime us", "ratio", "expansions", "errors");
+
+  const Map map(grid.cells.data(), grid.width, grid.height);
+  const BasicMap<RuntimeConnectivity> fourMap(grid.cells.data(), grid.width, grid.height, RuntimeConnectivity{false});
+  auto defaultSearch = [&](const Scenario& s, SearchStats* stats) {
+    BasicPathfinder<> pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, map, out, size);
+    pathfinder.findPath(stats);
+    return pathfinder.cost(); };
+  comparePolicies("4-connected, unit, Manhattan", scenarios, defaultSearch, [&](const Scenario& s, SearchStats* stats) {
+    RuntimePathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, fourMap, out, size,
+                                 RuntimeCost{1, 1}, RuntimeHeuristic{RuntimeHeuristic::Manhattan}, HeapOpenList{TieBreak::HigherG});
+    pathfinder.findPath(stats);
+    return pathfinder.cost(); });
+  // the same search in Pathfinder, whose tie-break and layout are runtime options
+  comparePolicies("  Pathfinder, dense", scenarios, defaultSearch, [&](const Scenario& s, SearchStats* stats) {
+    Pathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height, out, size,
+                          TieBreak::HigherG, SearchLayout::Dense);
+    return pathfinder.findPath(stats); });
+
+  const BasicMap<EightConnected> eightMap(grid.cells.data(), grid.width, grid.height);
+  const BasicMap<RuntimeConnectivity> runtimeEightMap(grid.cells.data(), grid.width, grid.height, RuntimeConnectivity{true});
+  comparePolicies("8-connected, octile, octile", scenarios, [&](const Scenario& s, SearchStats* stats) {
+    BasicPathfinder<EightConnected, OctileCost, OctileHeuristic> pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y,
+                                                                           eightMap, out, size);
+    pathfinder.findPath(stats);
+    return pathfinder.cost(); }, [&](const Scenario& s, SearchStats* stats) {
+    RuntimePathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, runtimeEightMap, out, size,
+                                 RuntimeCost{5, 7}, RuntimeHeuristic{RuntimeHeuristic::Octile}, HeapOpenList{TieBreak::HigherG});
+    pathfinder.findPath(stats);
+    return pathfinder.cost(); });
+
+  comparePolicies("4-connected, unit, zero (fifo)", scenarios, [&](const Scenario& s, SearchStats* stats) {
+    BasicPathfinder<FourConnected, UnitCost, ZeroHeuristic, IndexedOpenList<TieBreak::Fifo>> pathfinder(s.start.X, s.start.Y,
+                                                                                                      s.target.X, s.target.Y, map, out, size);
+    pathfinder.findPath(stats);
+    return pathfinder.cost(); }, [&](const Scenario& s, SearchStats* stats) {
+    RuntimePathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, fourMap, out, size,
+                                 RuntimeCost{1, 1}, RuntimeHeuristic{RuntimeHeuristic::Zero}, HeapOpenList{TieBreak::Fifo});
+    pathfinder.findPath(stats);
+    return pathfinder.cost(); });
+}
+
+// The 10x10 maps of test/testFindPath.cpp : "Complex path" and "Several paths, only one is the shortest path"
+static const unsigned char COMPLEX_PATH_MAP[] = {0, 1, 0, 1, 1, 1, 1, 1, 0, 1,
+                                                 0, 1, 0, 1, 0, 0, 0, 0, 0, 1,
+                                                 1, 1, 0, 1, 0, 1, 1, 1, 0, 1,
+                                                 1, 1, 0, 1, 1, 1, 0, 1, 0, 1,
+                                                 1, 1, 0, 1, 0, 0, 0, 1, 0, 1,
+                                                 1, 1, 0, 1, 1, 0, 1, 1, 0, 1,
+                                                 1, 1, 0, 0, 1, 0, 1, 1, 0, 1,
+                                                 1, 1, 1, 0, 1, 1, 0, 1, 1, 1,
+                                                 1, 0, 1, 1, 0, 1, 0, 0, 0, 1,
+                                                 1, 1, 0, 1, 1, 1, 0, 0, 0, 1};
+static const unsigned char SEVERAL_PATHS_MAP[] = {1, 1, 1, 1, 1, 1, 0, 1, 1, 1,
+                                                  1, 0, 0, 0, 0, 1, 1, 1, 0, 1,
+                                                  1, 0, 0, 0, 0, 1, 0, 0, 0, 1,
+                                                  1, 1, 1, 1, 0, 1, 1, 1, 0, 1,
+                                                  0, 0, 0, 1, 0, 1, 1, 1, 0, 1,
+                                                  1, 1, 1, 1, 0, 1, 1, 1, 0, 1,
+                                                  1, 0, 0, 1, 0, 1, 1, 1, 0, 1,
+                                                  1, 0, 1, 1, 1, 1, 1, 1, 0, 1,
+                                                  1, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+                                                  1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+
+/*! \brief A 10x10 map with each cell as a factor x factor block */
+static GridMap scaleMap(const unsigned char* pCells, const int factor)
+{
+  GridMap grid;
+  grid.width = grid.height = 10 * factor;
+  grid.cells.resize((size_t)grid.width * grid.height);
+  for (int y = 0; y < grid.height; ++y)
+  {
+    for (int x = 0; x < grid.width; ++x) { grid.cells[(size_t)y*grid.width + x] = pCells[(y / factor)*10 + x / factor]; }
+  }
+  return grid;
+}
+
+/*! \brief FindPath(), on a FixedPathfinder when the map fits in 64x64, against Pathfinder in its automatic and dense layouts */
+static void fixedProfile(const vector<string>& factors, const int nbQueries, const uint64_t seed)
+{
+  printf("%-16s %8s %14s %12s %12s %10s %18s %16s %12s %8s\n", "map", "size", "pathfinder us", "dense us", "findpath us",
+         "speedup", "pathfinder allocs", "findpath allocs", "expansions", "errors");
+  const pair<const char*, const unsigned char*> maps[] = {{"complex path", COMPLEX_PATH_MAP}, {"several paths", SEVERAL_PATHS_MAP}};
+  for (const auto& map : maps)
+  {
+    for (const string& factor : factors)
+    {
+      const GridMap grid = scaleMap(map.second, max(1, atoi(factor.c_str())));
+      const vector<Scenario> scenarios = generateScenarios(grid, "scaled", nbQueries, seed);
+      vector<int> outBuffer(grid.cells.size());
+      int* out = outBuffer.data();
+      const int size = (int)outBuffer.size();
+      auto searchWith = [&](const SearchLayout layout) {
+        return [&, layout](const Scenario& s, SearchStats* stats) {
+          Pathfinder pathfinder(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height,
+                                out, size, TieBreak::HigherG, layout);
+          return pathfinder.findPath(stats); }; };
+      const auto automaticSearch = searchWith(SearchLayout::Automatic);
+      const auto denseSearch = searchWith(SearchLayout::Dense);
+      auto findPathSearch = [&](const Scenario& s, SearchStats* stats) {
+        return FindPath(s.start.X, s.start.Y, s.target.X, s.target.Y, grid.cells.data(), grid.width, grid.height, out, size, stats); };
+
+      // without statistics, as the callers of FindPath() : the rounds alternate, the fastest is kept
+      auto noStats = [](const auto& search) { return [&search](const Scenario& s, SearchStats*) { return search(s, nullptr); }; };
+      double automaticUs = 1e300, denseUs = 1e300, findPathUs = 1e300, expansions = 0;
+      vector<int> automaticLengths, denseLengths, findPathLengths;
+      for (int round = 0; round < POLICY_ROUNDS; ++round)
+      {
+        automaticUs = min(automaticUs, timeRound(scenarios, noStats(automaticSearch), &expansions, &automaticLengths));
+        denseUs = min(denseUs, timeRound(scenarios, noStats(denseSearch), &expansions, &denseLengths));
+        findPathUs = min(findPathUs, timeRound(scenarios, noStats(findPathSearch), &expansions, &findPathLengths));
+      }
+      // heap allocations per query : the costs vectors already have their capacity
+      long long before = threadHeapAllocations();
+      timeRound(scenarios, noStats(automaticSearch), &expansions, &automaticLengths);
+      const double automaticAllocations = (double)(threadHeapAllocations() - before) / scenarios.size();
+      before = threadHeapAllocations();
+      timeRound(scenarios, noStats(findPathSearch), &expansions, &findPathLengths);
+      const double findPathAllocations = (double)(threadHeapAllocations() - before) / scenarios.size();
+      timeRound(scenarios, findPathSearch, &expansions, &findPathLengths);
+      int errors = 0;
+      for (size_t q = 0; q < scenarios.size(); ++q)
+      {
+        errors += (findPathLengths[q] != automaticLengths[q] || denseLengths[q] != automaticLengths[q]) ? 1 : 0;
+      }
+      const string dimensions = to_string(grid.width) + "x" + to_string(grid.height);
+      printf("%-16s %8s %14.2f %12.2f %12.2f %10.2f %18.1f %16.1f %12.0f %8d\n", map.first, dimensions.c_str(), automaticUs, denseUs,
+             findPathUs, automaticUs / findPathUs, automaticAllocations, findPathAllocations, expansions, errors);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  vector<string> scenarioFiles;
+  vector<const Engine*> engines;
+  string mapDirectory;
+  int repeat = 1;
+  bool verify = true;
+  bool sweepMode = false;
+  MapGenParams sweepParams;
+  vector<string> sizes = {"256", "1024"};
+  vector<string> densities = {"0.2"};
+  int nbQueries = 100;
+  int nbAsyncQueries = 0;
+  int nbThreads = 0;
+  double cancelRatio = 0.5;
+  bool anytimeMode = false;
+  vector<string> focalEpsilons;
+  vector<string> memoryCaps;
+  vector<string> stateRadii;
+  bool cacheMode = false;
+  bool startupMode = false;
+  int compressedRadius = 0;
+  int externalCap = 0;
+  bool frontierMode = false;
+  bool policiesMode = false;
+  vector<string> fixedFactors;
+  try
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      if      (!strcmp(argv[i], "--map-dir") && i+1 < argc)   { mapDirectory = argv[++i]; }
+      else if (!strcmp(argv[i], "--repeat") && i+1 < argc)    { repeat = max(1, atoi(argv[++i])); }
+      else if (!strcmp(argv[i], "--no-verify"))               { verify = false; }
+      else if (!strcmp(argv[i], "--sweep") && i+1 < argc)     { sweepMode = true; sweepParams.kind = mapKindFromName(argv[++i]); }
+      else if (!strcmp(argv[i], "--sizes") && i+1 < argc)     { sizes = splitList(argv[++i]); }
+      else if (!strcmp(argv[i], "--densities") && i+1 < argc) { densities = splitList(argv[++i]); }
+      else if (!strcmp(argv[i], "--queries") && i+1 < argc)   { nbQueries = atoi(argv[++i]); }
+      else if (!strcmp(argv[i], "--seed") && i+1 < argc)      { sweepParams.seed = strtoull(argv[++i], nullptr, 10); }
+      else if (!strcmp(argv[i], "--reject") && i+1 < argc)    { benchmarkRejects(max(1, atoi(argv[++i]))); return 0; }
+      else if (!strcmp(argv[i], "--async") && i+1 < argc)     { nbAsyncQueries = max(1, atoi(argv[++i])); }
+      else if (!strcmp(argv[i], "--threads") && i+1 < argc)   { nbThreads = max(1, atoi(argv[++i])); }
+      else if (!strcmp(argv[i], "--cancel") && i+1 < argc)    { cancelRatio = atof(argv[++i]); }
+      else if (!strcmp(argv[i], "--anytime"))                 { anytimeMode = true; }
+      else if (!strcmp(argv[i], "--focal") && i+1 < argc)     { focalEpsilons = splitList(argv[++i]); }
+      else if (!strcmp(argv[i], "--memory") && i+1 < argc)    { memoryCaps = splitList(argv[++i]); }
+      else if (!strcmp(argv[i], "--state") && i+1 < argc)     { stateRadii = splitList(argv[++i]); }
+      else if (!strcmp(argv[i], "--cache"))                   { cacheMode = true; }
+      else if (!strcmp(argv[i], "--startup"))                 { startupMode = true; }
+      else if (!strcmp(argv[i], "--compressed") && i+1 < argc) { compressedRadius = atoi(argv[++i]); }
+      else if (!strcmp(argv[i], "--external") && i+1 < argc)  { externalCap = atoi(argv[++i]); }
+      else if (!strcmp(argv[i], "--frontier"))                { frontierMode = true; }
+      else if (!strcmp(argv[i], "--policies"))                { policiesMode = true; }
+      else if (!strcmp(argv[i], "--fixed") && i+1 < argc)     { fixedFactors = splitList(argv[++i]); }
+      else if (!strcmp(argv[i], "--engine") && i+1 < argc)
+      {
+        const char* name = argv[++i];
+        const Engine* found = nullptr;
+        for (const Engine& engine : ENGINES) { if (!strcmp(engine.name, name)) { found = &engine; } }
+        if (found == nullptr) { fprintf(stderr, "unknown engine %s\n", name); return 1; }
+        engines.push_back(found);
+      }
+      else if (argv[i][0] == '-') { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+      else { scenarioFiles.push_back(argv[i]); }
+    }
+    if (nbAsyncQueries > 0)
+    {
+      sweepParams.width = sweepParams.height = atoi(sizes.back().c_str());
+      sweepParams.density = atof(densities.front().c_str());
+      const GridMap grid = generateMap(sweepParams);
+      const vector<Scenario> scenarios = generateScenarios(grid, "generated", nbAsyncQueries, sweepParams.seed);
+      printf("%d queries on %s %dx%d, %u threads\n", nbAsyncQueries, mapKindName(sweepParams.kind),
+             grid.width, grid.height, max(1u, thread::hardware_concurrency()));
+      printf("%-8s %9s %9s %12s %10s %10s %10s\n", "cancel", "completed", "cancelled", "queries/s", "p50 ms", "p99 ms", "total ms");
+      loadTestAsync(grid, scenarios, 0);
+      loadTestAsync(grid, scenarios, cancelRatio);
+      return 0;
+    }
+    if (nbThreads > 0)
+    {
+      sweepParams.width = sweepParams.height = atoi(sizes.back().c_str());
+      sweepParams.density = atof(densities.front().c_str());
+      const GridMap grid = generateMap(sweepParams);
+      const vector<Scenario> scenarios = generateScenarios(grid, "generated", nbQueries, sweepParams.seed);
+      printf("%d queries per thread on %s %dx%d\n", nbQueries, mapKindName(sweepParams.kind), grid.width, grid.height);
+      printf("%-8s %8s %12s %10s %14s\n", "state", "threads", "queries/s", "scaling", "allocs/query");
+      for (const bool useArena : {false, true})
+      {
+        const double singleThreadRate = loadTestThreads(grid, scenarios, 1, useArena, 0);
+        loadTestThreads(grid, scenarios, nbThreads, useArena, singleThreadRate);
+      }
+      return 0;
+    }
+    if (startupMode)
+    {
+      sweepParams.width = sweepParams.height = atoi(sizes.back().c_str());
+      sweepParams.density = atof(densities.front().c_str());
+      const GridMap grid = generateMap(sweepParams);
+      const vector<Scenario> scenarios = generateScenarios(grid, "generated", 1, sweepParams.seed);
+      printf("startup on %s %dx%d\n", mapKindName(sweepParams.kind), grid.width, grid.height);
+      startupProfile(grid, scenarios.front());
+      return 0;
+    }
+    if (externalCap > 0)
+    {
+      sweepParams.density = atof(densities.front().c_str());
+      printf("%d queries per size on %s maps, external search capped at %d KB\n", nbQueries, mapKindName(sweepParams.kind), externalCap);
+      externalProfile(sweepParams, sizes, (size_t)externalCap * 1024, nbQueries);
+      return 0;
+    }
+    if (!fixedFactors.empty())
+    {
+      printf("%d queries per map\n", nbQueries);
+      fixedProfile(fixedFactors, nbQueries, sweepParams.seed);
+      return 0;
+    }
+    if (policiesMode)
+    {
+      sweepParams.width = sweepParams.height = atoi(sizes.back().c_str());
+      sweepParams.density = atof(densities.front().c_str());
+      const GridMap grid = generateMap(sweepParams);
+      const vector<Scenario> scenarios = generateScenarios(grid, "generated", nbQueries, sweepParams.seed);
+      printf("%d queries on %s %dx%d\n", nbQueries, mapKindName(sweepParams.kind), grid.width, grid.height);
+      policyProfile(grid, scenarios);
+      return 0;
+    }
+    if (frontierMode)
+    {
+      sweepParams.width = sweepParams.height = atoi(sizes.back().c_str());
+      sweepParams.density = atof(densities.front().c_str());
+      const GridMap grid = generateMap(sweepParams);
+      const vector<Scenario> scenarios = generateScenarios(grid, "generated", nbQueries, sweepParams.seed);
+      printf("%d queries on %s %dx%d\n", nbQueries, mapKindName(sweepParams.kind), grid.width, grid.height);
+      frontierProfile(grid, scenarios);
+      return 0;
+    }
+    if (compressedRadius > 0)
+    {
+      sweepParams.width = sweepParams.height = atoi(sizes.back().c_str());
+      sweepParams.density = atof(densities.front().c_str());
+      const GridMap grid = generateMap(sweepParams);
+      printf("queries of radius %d on %s %dx%d\n", compressedRadius, mapKindName(sweepParams.kind), grid.width, grid.height);
+      compressedProfile(grid, compressedRadius, nbQueries, sweepParams.seed);
+      return 0;
+    }
+    if (cacheMode)
+    {
+      // WIDTHxHEIGHT : wide maps show the cost of the row stride
+      const string& size = sizes.back();
+      sweepParams.width = atoi(size.c_str());
+      sweepParams.height = (size.find('x') != string::npos) ? atoi(size.c_str() + size.find('x') + 1) : sweepParams.width;
+      sweepParams.density = atof(densities.front().c_str());
+      const GridMap grid = generateMap(sweepParams);
+      const vector<Scenario> scenarios = generateScenarios(grid, "generated", nbQueries, sweepParams.seed);
+      printf("%d queries on %s %dx%d\n", nbQueries, mapKindName(sweepParams.kind), grid.width, grid.height);
+      cacheProfile(grid, scenarios);
+      return 0;
+    }
+    if (!stateRadii.empty())
+    {
+      sweepParams.width = sweepParams.height = atoi(sizes.back().c_str());
+      sweepParams.density = atof(densities.front().c_str());
+      const GridMap grid = generateMap(sweepParams);
+      printf("%d queries per radius on %s %dx%d\n", nbQueries, mapKindName(sweepParams.kind), grid.width, grid.height);
+      stateProfile(grid, stateRadii, nbQueries, sweepParams.seed);
+      return 0;
+    }
+    if (anytimeMode || !focalEpsilons.empty() || !memoryCaps.empty())
+    {
+      sweepParams.width = sweepParams.height = atoi(sizes.back().c_str());
+      sweepParams.density = atof(densities.front().c_str());
+      const GridMap grid = generateMap(sweepParams);
+      const vector<Scenario> scenarios = generateScenarios(grid, "generated", nbQueries, sweepParams.seed);
+      printf("%d queries on %s %dx%d\n", nbQueries, mapKindName(sweepParams.kind), grid.width, grid.height);
+      if (anytimeMode)                 { anytimeProfile(grid, scenarios); }
+      else if (!focalEpsilons.empty()) { focalProfile(grid, scenarios, focalEpsilons); }
+      else                             { memoryProfile(grid, scenarios, memoryCaps); }
+      return 0;
+    }
+    if (scenarioFiles.empty() && !sweepMode)
+    {
+      fprintf(stderr, "usage : bench [--map-dir DIR] [--engine NAME]... [--repeat N] [--no-verify] file.scen...\n"
+                      "        bench [--engine NAME]... [--repeat N] [--no-verify] --sweep KIND [--sizes LIST] [--densities LIST] [--queries N] [--seed S]\n");
+      return 1;
+    }
+    if (engines.empty())
+    {
+      for (const Engine& engine : ENGINES) { engines.push_back(&engine); }
+    }
+
+    if (sweepMode)
+    {
+      sweep(engines, sweepParams, sizes, densities, nbQueries, repeat, verify);
+      return 0;
+    }
+
+    map<string, BenchMap> benchMaps;
+    Queries queries;
+    for (const string& scenarioFile : scenarioFiles)
+    {
+      for (const Scenario& scenario : loadMovingAIScenarios(scenarioFile))
+      {
+        const string mapPath = (mapDirectory.empty() ? directoryOf(scenarioFile) : mapDirectory) + "/" + fileNameOf(scenario.mapFile);
+        BenchMap& benchMap = benchMaps[mapPath];
+        if (benchMap.grid.cells.empty()) { benchMap.grid = loadMovingAIMap(mapPath); }
+        queries.emplace_back(&benchMap, scenario);
+      }
+    }
+    const vector<int> references = verify ? computeReferences(queries) : vector<int>();
+
+    printf("%zu queries on %zu maps\n", queries.size(), benchMaps.size());
+    for (const Engine* engine : engines)
+    {
+      report(engine->name, runEngine(*engine, queries, references, repeat));
+    }
+  }
+  catch (const exception& e)
+  {
+    fprintf(stderr, "%s", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,47 @@
+#include "heapcounter.hpp"
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+// Counted per thread : a shared counter would itself be a contention point.
+static thread_local long long heapAllocations = 0;
+
+long long threadHeapAllocations() noexcept
+{
+  return heapAllocations;
+}
+
+// Every replaceable allocation function is replaced, so that each deallocation matches its allocation.
+// They live in their own translation unit : inlined in their callers, the compiler would pair the
+// operator new calls with the free() of the operator delete bodies (-Wmismatched-new-delete).
+static void* countedMalloc(const size_t size) noexcept
+{
+  ++heapAllocations;
+  return malloc(size ? size : 1);
+}
+
+void* operator new(size_t size)
+{
+  void* p = countedMalloc(size);
+  if (p == nullptr) { throw bad_alloc(); }
+  return p;
+}
+void* operator new[](size_t size)
+{
+  void* p = countedMalloc(size);
+  if (p == nullptr) { throw bad_alloc(); }
+  return p;
+}
+void* operator new(size_t size, const nothrow_t&) noexcept   { return countedMalloc(size); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return countedMalloc(size); }
+void operator delete(void* p) noexcept                        { free(p); }
+void operator delete[](void* p) noexcept                      { free(p); }
+void operator delete(void* p, size_t) noexcept                { free(p); }
+void operator delete[](void* p, size_t) noexcept              { free(p); }
+void operator delete(void* p, const nothrow_t&) noexcept      { free(p); }
+void operator delete[](void* p, const nothrow_t&) noexcept    { free(p); }
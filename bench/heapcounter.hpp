@@ -0,0 +1,12 @@
+#pragma once
+
+// ############################################################################
+// ### Heap allocation counter
+// ############################################################################
+
+// heapcounter.cpp replaces the global allocation functions to count the heap allocations
+// of each thread, to show how often the threads go through the global allocator.
+// Link it only in the programs which read the counter.
+
+/*! \brief Heap allocations made by the calling thread since it started */
+long long threadHeapAllocations() noexcept;
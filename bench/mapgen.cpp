@@ -0,0 +1,63 @@
+#include "mapgenerator.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// ############################################################################
+// ### Map generator command line
+// ############################################################################
+
+// Writes a generated map in Moving AI format (NAME.map), with random queries (NAME.map.scen)
+// which can be run by the bench executable.
+//
+// usage : mapgen [options] NAME
+//   --kind KIND      random, maze, rooms or warehouse (default : random)
+//   --size WxH       map size, up to 32768x32768 (default : 256x256)
+//   --density D      obstacle density for random, pallet density for warehouse (default : 0.2)
+//   --room-size N    room size for rooms (default : 16)
+//   --seed S         random seed (default : 1)
+//   --queries N      number of queries in the .scen file (default : 100)
+
+int main(int argc, char** argv)
+{
+  MapGenParams params;
+  int queries = 100;
+  string name;
+  try
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      if      (!strcmp(argv[i], "--kind") && i+1 < argc)      { params.kind = mapKindFromName(argv[++i]); }
+      else if (!strcmp(argv[i], "--size") && i+1 < argc)
+      {
+        if (sscanf(argv[++i], "%dx%d", &params.width, &params.height) != 2) { fprintf(stderr, "bad size %s\n", argv[i]); return 1; }
+      }
+      else if (!strcmp(argv[i], "--density") && i+1 < argc)   { params.density = atof(argv[++i]); }
+      else if (!strcmp(argv[i], "--room-size") && i+1 < argc) { params.roomSize = atoi(argv[++i]); }
+      else if (!strcmp(argv[i], "--seed") && i+1 < argc)      { params.seed = strtoull(argv[++i], nullptr, 10); }
+      else if (!strcmp(argv[i], "--queries") && i+1 < argc)   { queries = atoi(argv[++i]); }
+      else if (argv[i][0] == '-') { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+      else { name = argv[i]; }
+    }
+    if (name.empty())
+    {
+      fprintf(stderr, "usage : mapgen [--kind KIND] [--size WxH] [--density D] [--room-size N] [--seed S] [--queries N] NAME\n");
+      return 1;
+    }
+
+    const GridMap grid = generateMap(params);
+    const string mapFile = name + ".map";
+    saveMovingAIMap(grid, mapFile);
+    saveMovingAIScenarios(generateScenarios(grid, mapFile, queries, params.seed), mapFile + ".scen");
+    printf("%s : %s %dx%d, seed %llu\n", mapFile.c_str(), mapKindName(params.kind), grid.width, grid.height,
+           (unsigned long long)params.seed);
+  }
+  catch (const exception& e)
+  {
+    fprintf(stderr, "%s", e.what());
+    return 1;
+  }
+  return 0;
+}
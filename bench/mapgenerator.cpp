@@ -0,0 +1,216 @@
+#include "mapgenerator.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+static void generateRandom(GridMap& grid, const MapGenParams& params, SplitMix64& rng)
+{
+  for (unsigned char& cell : grid.cells)
+  {
+    cell = (rng.uniform() < params.density) ? 0 : 1;
+  }
+}
+
+static void generateMaze(GridMap& grid, SplitMix64& rng)
+{
+  // Recursive division, with an explicit stack of chambers so that huge maps do not overflow the call stack.
+  // Chambers always start at even coordinates, walls are put at odd offsets and gaps at even offsets :
+  // a gap can never be closed by a later perpendicular wall, so every cell stays reachable.
+  struct Chamber { int x0, y0, x1, y1; };
+  vector<Chamber> chambers = {{0, 0, grid.width-1, grid.height-1}};
+  fill(grid.cells.begin(), grid.cells.end(), 1);
+  while (!chambers.empty())
+  {
+    const Chamber c = chambers.back();
+    chambers.pop_back();
+    const int w = c.x1 - c.x0 + 1;
+    const int h = c.y1 - c.y0 + 1;
+    if (w < 3 && h < 3) { continue; }
+
+    const bool horizontalWall = (h > w) || (h == w && rng.below(2) == 0) || w < 3;
+    if (horizontalWall && h >= 3)
+    {
+      const int wallY = c.y0 + 1 + 2*(int)rng.below((h-1)/2);
+      const int gapX  = c.x0 + 2*(int)rng.below((w+1)/2);
+      for (int x = c.x0; x <= c.x1; ++x)
+      {
+        if (x != gapX) { grid.cells[(size_t)wallY*grid.width + x] = 0; }
+      }
+      chambers.push_back({c.x0, c.y0, c.x1, wallY-1});
+      chambers.push_back({c.x0, wallY+1, c.x1, c.y1});
+    }
+    else if (w >= 3)
+    {
+      const int wallX = c.x0 + 1 + 2*(int)rng.below((w-1)/2);
+      const int gapY  = c.y0 + 2*(int)rng.below((h+1)/2);
+      for (int y = c.y0; y <= c.y1; ++y)
+      {
+        if (y != gapY) { grid.cells[(size_t)y*grid.width + wallX] = 0; }
+      }
+      chambers.push_back({c.x0, c.y0, wallX-1, c.y1});
+      chambers.push_back({wallX+1, c.y0, c.x1, c.y1});
+    }
+  }
+}
+
+static void generateRooms(GridMap& grid, const MapGenParams& params, SplitMix64& rng)
+{
+  // walls on every row and column multiple of roomSize, then one door per wall segment between two rooms
+  const int roomSize = params.roomSize;
+  for (int y = 0; y < grid.height; ++y)
+  {
+    for (int x = 0; x < grid.width; ++x)
+    {
+      const bool wall = (x % roomSize == 0 && x > 0) || (y % roomSize == 0 && y > 0);
+      grid.cells[(size_t)y*grid.width + x] = wall ? 0 : 1;
+    }
+  }
+  for (int roomY = 0; roomY*roomSize < grid.height; ++roomY)
+  {
+    for (int roomX = 0; roomX*roomSize < grid.width; ++roomX)
+    {
+      const int left = roomX*roomSize + 1;
+      const int top  = roomY*roomSize + 1;
+      const int right  = min(grid.width,  (roomX+1)*roomSize);  // column of the right wall
+      const int bottom = min(grid.height, (roomY+1)*roomSize);  // row of the bottom wall
+      // door in the right wall
+      if (right < grid.width && bottom > top)
+      {
+        const int doorY = top + (int)rng.below(bottom - top);
+        grid.cells[(size_t)doorY*grid.width + right] = 1;
+      }
+      // door in the bottom wall
+      if (bottom < grid.height && right > left)
+      {
+        const int doorX = left + (int)rng.below(right - left);
+        grid.cells[(size_t)bottom*grid.width + doorX] = 1;
+      }
+    }
+  }
+}
+
+static void generateWarehouse(GridMap& grid, const MapGenParams& params, SplitMix64& rng)
+{
+  // Pattern, repeated : 2 rows of racks, then 2 rows of aisle.
+  // Racks are 10 cells long separated by 2-cell cross aisles, and the map border is left open.
+  const int rackLength = 10;
+  for (int y = 0; y < grid.height; ++y)
+  {
+    for (int x = 0; x < grid.width; ++x)
+    {
+      const bool border = (x == 0 || y == 0 || x == grid.width-1 || y == grid.height-1);
+      const bool rackRow = ((y - 1) % 4) < 2 && y > 0;
+      const bool rackColumn = ((x - 1) % (rackLength + 2)) < rackLength && x > 0;
+      bool obstacle = !border && rackRow && rackColumn;
+      if (!obstacle && !border && rng.uniform() < params.density)
+      {
+        obstacle = true; // pallet left in an aisle
+      }
+      grid.cells[(size_t)y*grid.width + x] = obstacle ? 0 : 1;
+    }
+  }
+}
+
+GridMap generateMap(const MapGenParams& params)
+{
+  if (params.width < 1 || params.width > MAX_GENERATED_SIZE)   { throw BadInputException("in generateMap(), width must be between 1 and 32768.\n"); }
+  if (params.height < 1 || params.height > MAX_GENERATED_SIZE) { throw BadInputException("in generateMap(), height must be between 1 and 32768.\n"); }
+  if (params.density < 0 || params.density > 1)                { throw BadInputException("in generateMap(), density must be between 0 and 1.\n"); }
+  if (params.roomSize < 3)                                     { throw BadInputException("in generateMap(), room size must be at least 3.\n"); }
+
+  GridMap grid;
+  grid.width = params.width;
+  grid.height = params.height;
+  grid.cells.resize((size_t)params.width*params.height);
+  SplitMix64 rng(params.seed);
+  switch (params.kind)
+  {
+    case MapKind::Random:    generateRandom(grid, params, rng);    break;
+    case MapKind::Maze:      generateMaze(grid, rng);              break;
+    case MapKind::Rooms:     generateRooms(grid, params, rng);     break;
+    case MapKind::Warehouse: generateWarehouse(grid, params, rng); break;
+  }
+  return grid;
+}
+
+vector<Scenario> generateScenarios(const GridMap& grid, const string& mapFile, const int count, const uint64_t seed)
+{
+  vector<Scenario> scenarios;
+  if (find(grid.cells.begin(), grid.cells.end(), 1) == grid.cells.end()) { return scenarios; }
+
+  SplitMix64 rng(seed);
+  const uint64_t cellCount = grid.cells.size();
+  auto randomPassableCell = [&]() {
+    uint64_t index;
+    do { index = rng.below(cellCount); } while (grid.cells[index] == 0);
+    return Coordinates((int)(index % grid.width), (int)(index / grid.width));
+  };
+  for (int i = 0; i < count; ++i)
+  {
+    Scenario scenario;
+    scenario.mapFile = mapFile;
+    scenario.mapWidth = grid.width;
+    scenario.mapHeight = grid.height;
+    scenario.start = randomPassableCell();
+    scenario.target = randomPassableCell();
+    const int manhattan = abs(scenario.start.X - scenario.target.X) + abs(scenario.start.Y - scenario.target.Y);
+    scenario.bucket = min(9, 10*manhattan / (grid.width + grid.height));
+    scenario.optimalLength = manhattan;
+    scenarios.push_back(scenario);
+  }
+  return scenarios;
+}
+
+void saveMovingAIMap(const GridMap& grid, const string& path)
+{
+  ofstream output(path);
+  if (!output) { throw FormatException("in saveMovingAIMap(), cannot open " + path + ".\n"); }
+  output << "type octile\nheight " << grid.height << "\nwidth " << grid.width << "\nmap\n";
+  string line(grid.width, '.');
+  for (int y = 0; y < grid.height; ++y)
+  {
+    for (int x = 0; x < grid.width; ++x)
+    {
+      line[x] = grid.cells[(size_t)y*grid.width + x] ? '.' : '@';
+    }
+    output << line << '\n';
+  }
+}
+
+void saveMovingAIScenarios(const vector<Scenario>& scenarios, const string& path)
+{
+  ofstream output(path);
+  if (!output) { throw FormatException("in saveMovingAIScenarios(), cannot open " + path + ".\n"); }
+  output << "version 1\n";
+  for (const Scenario& s : scenarios)
+  {
+    output << s.bucket << '\t' << s.mapFile << '\t' << s.mapWidth << '\t' << s.mapHeight << '\t'
+           << s.start.X << '\t' << s.start.Y << '\t' << s.target.X << '\t' << s.target.Y << '\t'
+           << s.optimalLength << '\n';
+  }
+}
+
+MapKind mapKindFromName(const string& name)
+{
+  if (name == "random")    { return MapKind::Random; }
+  if (name == "maze")      { return MapKind::Maze; }
+  if (name == "rooms")     { return MapKind::Rooms; }
+  if (name == "warehouse") { return MapKind::Warehouse; }
+  throw BadInputException("in mapKindFromName(), unknown map kind " + name + ".\n");
+}
+
+const char* mapKindName(const MapKind kind)
+{
+  switch (kind)
+  {
+    case MapKind::Random:    return "random";
+    case MapKind::Maze:      return "maze";
+    case MapKind::Rooms:     return "rooms";
+    case MapKind::Warehouse: return "warehouse";
+  }
+  return "";
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "movingai.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Synthetic map generator
+// ############################################################################
+
+// Generates maps of any size up to MAX_GENERATED_SIZE x MAX_GENERATED_SIZE,
+// with the topologies the unit tests never reach. Generation only depends on
+// the seed : the same parameters always give the same map, on every platform.
+
+const int MAX_GENERATED_SIZE = 32768;
+
+/*! \brief Topology of a generated map */
+enum class MapKind
+{
+  Random,     //!< obstacles placed independently, with probability 'density'
+  Maze,       //!< perfect maze by recursive division : 1-cell corridors, a single path between two cells
+  Rooms,      //!< square rooms of 'roomSize' cells, connected by a door in each wall
+  Warehouse   //!< racks 2 cells deep separated by aisles, pallets dropped in aisles with probability 'density'
+};
+
+/*! \brief Parameters of a generated map */
+struct MapGenParams
+{
+  MapKind kind = MapKind::Random;
+  int width = 256;
+  int height = 256;
+  double density = 0.2;   //!< used by Random and Warehouse
+  int roomSize = 16;      //!< used by Rooms
+  uint64_t seed = 1;
+};
+
+/*! \brief Small portable random generator (SplitMix64).
+ *
+ *  std::uniform_*_distribution are implementation defined :
+ *  this one gives the same sequence with every standard library.
+ */
+class SplitMix64
+{
+  public:
+  SplitMix64(const uint64_t seed): _state(seed) {}
+
+  uint64_t next()
+  {
+    uint64_t z = (_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+  //! uniform integer in [0, bound)
+  uint64_t below(const uint64_t bound) { return next() % bound; }
+  //! uniform real in [0, 1)
+  double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+  private:
+  uint64_t _state;
+};
+
+/*! \brief Generate a map.
+ *
+ *  \throw BadInputException if the size is not in [1, MAX_GENERATED_SIZE],
+ *         density not in [0, 1] or roomSize < 3.
+ */
+GridMap generateMap(const MapGenParams& params);
+
+/*! \brief Pick 'count' random queries between passable cells of the map.
+ *
+ *  Buckets go from 0 to 9, by Manhattan distance relative to the map size.
+ *  The optimal length is not computed (it would cost a full search on huge maps) :
+ *  the Manhattan distance is stored instead, which is a lower bound.
+ */
+vector<Scenario> generateScenarios(const GridMap& grid, const string& mapFile, const int count, const uint64_t seed);
+
+/*! \brief Save a map in Moving AI .map format, and scenarios in .scen format */
+void saveMovingAIMap(const GridMap& grid, const string& path);
+void saveMovingAIScenarios(const vector<Scenario>& scenarios, const string& path);
+
+MapKind mapKindFromName(const string& name);
+const char* mapKindName(const MapKind kind);
@@ -0,0 +1,85 @@
+#include "movingai.hpp"
+#include <fstream>
+#include <sstream>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+GridMap loadMovingAIMap(istream& input)
+{
+  // header : "type octile", "height H", "width W", "map" - height and width in any order
+  GridMap grid;
+  string keyword;
+  if (!(input >> keyword) || keyword != "type") { throw FormatException("in loadMovingAIMap(), missing 'type' header.\n"); }
+  input >> keyword; // type of the map, not used
+  while (input >> keyword && keyword != "map")
+  {
+    if      (keyword == "height") { input >> grid.height; }
+    else if (keyword == "width")  { input >> grid.width; }
+    else { throw FormatException("in loadMovingAIMap(), unknown header '" + keyword + "'.\n"); }
+  }
+  if (keyword != "map")                    { throw FormatException("in loadMovingAIMap(), missing 'map' header.\n"); }
+  if (grid.width < 1 || grid.height < 1)   { throw FormatException("in loadMovingAIMap(), width and height must be greater than 0.\n"); }
+
+  // grid : one line of 'width' characters per row
+  grid.cells.resize((size_t)grid.width*grid.height);
+  string line;
+  for (int y = 0; y < grid.height; ++y)
+  {
+    if (!(input >> line) || (int)line.size() != grid.width)
+    {
+      throw FormatException("in loadMovingAIMap(), row " + to_string(y) + " does not match the map width.\n");
+    }
+    for (int x = 0; x < grid.width; ++x)
+    {
+      const char terrain = line[x];
+      grid.cells[(size_t)y*grid.width + x] = (terrain == '.' || terrain == 'G' || terrain == 'S') ? 1 : 0;
+    }
+  }
+  return grid;
+}
+
+GridMap loadMovingAIMap(const string& path)
+{
+  ifstream input(path);
+  if (!input) { throw FormatException("in loadMovingAIMap(), cannot open " + path + ".\n"); }
+  return loadMovingAIMap(input);
+}
+
+vector<Scenario> loadMovingAIScenarios(istream& input)
+{
+  string keyword;
+  double version = 0;
+  if (!(input >> keyword >> version) || keyword != "version")
+  {
+    throw FormatException("in loadMovingAIScenarios(), missing 'version' header.\n");
+  }
+
+  // one scenario per line, tab separated :
+  // bucket  map  map-width  map-height  start-x  start-y  goal-x  goal-y  optimal-length
+  vector<Scenario> scenarios;
+  string line;
+  getline(input, line); // end of the version line
+  while (getline(input, line))
+  {
+    if (line.find_first_not_of(" \t\r") == string::npos) { continue; }
+    istringstream fields(line);
+    Scenario scenario;
+    if (!(fields >> scenario.bucket >> scenario.mapFile >> scenario.mapWidth >> scenario.mapHeight
+                 >> scenario.start.X >> scenario.start.Y >> scenario.target.X >> scenario.target.Y
+                 >> scenario.optimalLength))
+    {
+      throw FormatException("in loadMovingAIScenarios(), cannot read scenario " + to_string(scenarios.size()) + ".\n");
+    }
+    scenarios.push_back(scenario);
+  }
+  return scenarios;
+}
+
+vector<Scenario> loadMovingAIScenarios(const string& path)
+{
+  ifstream input(path);
+  if (!input) { throw FormatException("in loadMovingAIScenarios(), cannot open " + path + ".\n"); }
+  return loadMovingAIScenarios(input);
+}
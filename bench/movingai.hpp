@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <istream>
+#include <exception>
+#include "../pathfinder.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Moving AI benchmark formats
+// ############################################################################
+
+// Loader for the standard grid benchmarks of the Moving AI lab :
+// https://movingai.com/benchmarks/formats.html
+// - .map files describe the grid,
+// - .scen files list queries on a map, grouped by buckets of similar length.
+// Scenario optimal lengths are computed for 8-connected (octile) movement,
+// while FindPath works on 4-connected grids : they are lower bounds for us.
+
+/*! \brief Grid loaded from a .map file, in the format expected by FindPath
+ *         (1 for passable cells, 0 for impassable ones, row-major).
+ */
+struct GridMap
+{
+  int width = 0;
+  int height = 0;
+  vector<unsigned char> cells;
+};
+
+/*! \brief One query of a .scen file */
+struct Scenario
+{
+  int bucket;
+  string mapFile;
+  int mapWidth, mapHeight;
+  Coordinates start, target;
+  double optimalLength;  //!< octile optimal length
+};
+
+/*! \brief Load a .map file.
+ *
+ *  '.', 'G' and 'S' are passable, every other terrain is impassable.
+ *  \throw FormatException if the content is not a valid .map file
+ */
+GridMap loadMovingAIMap(istream& input);
+GridMap loadMovingAIMap(const string& path);
+
+/*! \brief Load a .scen file (version 1).
+ *
+ *  \throw FormatException if the content is not a valid .scen file
+ */
+vector<Scenario> loadMovingAIScenarios(istream& input);
+vector<Scenario> loadMovingAIScenarios(const string& path);
+
+/*! \brief Exception to return if a benchmark file cannot be read */
+class FormatException : public exception
+{
+    string _msg;
+public:
+    FormatException(const string& msg) : _msg(msg){}
+
+    virtual const char* what() const noexcept override
+    {
+        return _msg.c_str();
+    }
+};
@@ -0,0 +1,261 @@
+#include "compressedmap.hpp"
+#include <climits>
+#include <cstring>
+#include <fstream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PATHFINDER_HAS_MMAP 1
+#endif
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+const int CompressedMap::TILE_BITS;
+const int CompressedMap::TILE_SIZE;
+
+static const char MAGIC[8] = {'P', 'F', 'T', 'I', 'L', 'E', 'S', '\x1a'};
+static const uint32_t VERSION = 1;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+static const int TILE_CELLS = CompressedMap::TILE_SIZE * CompressedMap::TILE_SIZE;
+
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrderMark;
+  int32_t width, height;
+  uint32_t tileBits;
+  uint32_t reserved;
+  uint64_t dataSize;
+  unsigned char padding[64 - 40];
+};
+static_assert(sizeof(FileHeader) == 64, "the header is part of the file format");
+
+// the offsets follow the kinds, aligned on 8 bytes
+static uint64_t offsetsPosition(const int tileCount) { return (sizeof(FileHeader) + tileCount + 7) / 8 * 8; }
+
+static BadInputException fileError(const string& path, const char* reason)
+{
+  return BadInputException("in CompressedMap, " + path + " " + reason + ".\n");
+}
+
+static void appendVarint(vector<unsigned char>& data, int value)
+{
+  while (value >= 0x80)
+  {
+    data.push_back((unsigned char)(value | 0x80));
+    value >>= 7;
+  }
+  data.push_back((unsigned char)value);
+}
+
+void CompressedMap::initSize(const int nMapWidth, const int nMapHeight)
+{
+  // as FindPathLarge() : no limit on the number of cells, but on the number of tiles
+  if (nMapWidth < 1)  { throwIfBadInput(FindPathStatus::MapWidthTooSmall); }
+  if (nMapHeight < 1) { throwIfBadInput(FindPathStatus::MapHeightTooSmall); }
+  _mapWidth = nMapWidth;
+  _mapHeight = nMapHeight;
+  _tilesPerRow = (int)(((int64_t)nMapWidth + TILE_SIZE - 1) >> TILE_BITS);
+  _tilesPerColumn = (int)(((int64_t)nMapHeight + TILE_SIZE - 1) >> TILE_BITS);
+  if ((int64_t)_tilesPerRow * _tilesPerColumn > INT_MAX) { throwIfBadInput(FindPathStatus::MapTooLarge); }
+}
+
+CompressedMap::CompressedMap(const unsigned char* pMap, const int nMapWidth, const int nMapHeight):
+  _file(nullptr), _fileSize(0), _mapped(false)
+{
+  initSize(nMapWidth, nMapHeight);
+  _ownKinds.resize(tileCount());
+  _ownOffsets.resize(tileCount() + 1);
+  for (int tile = 0; tile < tileCount(); ++tile)
+  {
+    _ownOffsets[tile] = _ownData.size();
+    const int left = (tile % _tilesPerRow) << TILE_BITS, top = (tile / _tilesPerRow) << TILE_BITS;
+    const int tileWidth = min(TILE_SIZE, nMapWidth - left), tileHeight = min(TILE_SIZE, nMapHeight - top);
+
+    // runs of the cells of the tile, row-major, those beyond the map impassable
+    const size_t runsStart = _ownData.size();
+    bool passable = false;
+    int runLength = 0, nbPassable = 0;
+    for (int y = 0; y < TILE_SIZE; ++y)
+    {
+      const unsigned char* row = (y < tileHeight) ? pMap + (int64_t)(top + y) * nMapWidth + left : nullptr;
+      for (int x = 0; x < TILE_SIZE; ++x)
+      {
+        const bool cellPassable = (row != nullptr && x < tileWidth && row[x] != 0);
+        if (cellPassable != passable)
+        {
+          appendVarint(_ownData, runLength);
+          passable = cellPassable;
+          runLength = 0;
+        }
+        ++runLength;
+        nbPassable += cellPassable ? 1 : 0;
+      }
+    }
+    appendVarint(_ownData, runLength);
+
+    if (nbPassable == 0 || nbPassable == TILE_CELLS)
+    {
+      _ownKinds[tile] = (nbPassable == 0) ? Impassable : Passable;
+      _ownData.resize(runsStart);
+    }
+    else
+    {
+      _ownKinds[tile] = Encoded;
+    }
+  }
+  _ownOffsets[tileCount()] = _ownData.size();
+  _kinds = _ownKinds.data();
+  _offsets = _ownOffsets.data();
+  _data = _ownData.data();
+  _dataSize = _ownData.size();
+}
+
+CompressedMap::CompressedMap(const string& path): _file(nullptr), _fileSize(0), _mapped(false)
+{
+#ifdef PATHFINDER_HAS_MMAP
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) { throw fileError(path, "cannot be opened"); }
+  struct stat status;
+  if (fstat(fd, &status) == 0 && status.st_size >= (off_t)sizeof(FileHeader))
+  {
+    void* file = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (file != MAP_FAILED)
+    {
+      _file = static_cast<const unsigned char*>(file);
+      _fileSize = (size_t)status.st_size;
+      _mapped = true;
+      // the searches read the tiles where they go : readahead would read the tiles around, which they do not need
+      madvise(file, _fileSize, MADV_RANDOM);
+    }
+  }
+  close(fd);
+#endif
+  if (!_mapped)
+  {
+    ifstream input(path, ios::binary);
+    if (!input) { throw fileError(path, "cannot be opened"); }
+    const vector<char> content((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    _copy.resize((content.size() + 7) / 8);
+    memcpy(_copy.data(), content.data(), content.size());
+    _file = reinterpret_cast<const unsigned char*>(_copy.data());
+    _fileSize = content.size();
+  }
+
+  try
+  {
+    FileHeader header;
+    if (_fileSize < sizeof(header)) { throw fileError(path, "is not a compressed map file"); }
+    memcpy(&header, _file, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) { throw fileError(path, "is not a compressed map file"); }
+    if (header.byteOrderMark != BYTE_ORDER_MARK)         { throw fileError(path, "was written with another byte order"); }
+    if (header.version != VERSION || header.tileBits != (uint32_t)TILE_BITS) { throw fileError(path, "has an unknown version"); }
+    try { initSize(header.width, header.height); }
+    catch (const BadInputException&) { throw fileError(path, "has a bad map size"); }
+
+    const uint64_t offsetsStart = offsetsPosition(tileCount());
+    const uint64_t dataStart = offsetsStart + ((uint64_t)tileCount() + 1) * sizeof(uint64_t);
+    if (dataStart > _fileSize || header.dataSize > _fileSize - dataStart) { throw fileError(path, "is truncated or corrupted"); }
+    _kinds = _file + sizeof(FileHeader);
+    _offsets = reinterpret_cast<const uint64_t*>(_file + offsetsStart);
+    _data = _file + dataStart;
+    _dataSize = header.dataSize;
+    if (_offsets[tileCount()] != _dataSize) { throw fileError(path, "is truncated or corrupted"); }
+  }
+  catch (...)
+  {
+#ifdef PATHFINDER_HAS_MMAP
+    if (_mapped) { munmap(const_cast<unsigned char*>(_file), _fileSize); }
+#endif
+    throw;
+  }
+}
+
+CompressedMap::~CompressedMap()
+{
+#ifdef PATHFINDER_HAS_MMAP
+  if (_mapped) { munmap(const_cast<unsigned char*>(_file), _fileSize); }
+#endif
+}
+
+void CompressedMap::save(const string& path) const
+{
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.byteOrderMark = BYTE_ORDER_MARK;
+  header.width = _mapWidth;
+  header.height = _mapHeight;
+  header.tileBits = TILE_BITS;
+  header.dataSize = _dataSize;
+
+  ofstream output(path, ios::binary | ios::trunc);
+  if (!output) { throw fileError(path, "cannot be written"); }
+  output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  output.write(reinterpret_cast<const char*>(_kinds), tileCount());
+  const vector<char> zeros((size_t)(offsetsPosition(tileCount()) - sizeof(header) - tileCount()), 0);
+  output.write(zeros.data(), (streamsize)zeros.size());
+  output.write(reinterpret_cast<const char*>(_offsets), ((streamsize)tileCount() + 1) * sizeof(uint64_t));
+  output.write(reinterpret_cast<const char*>(_data), (streamsize)_dataSize);
+  if (!output) { throw fileError(path, "cannot be written"); }
+}
+
+void CompressedMap::decompressTile(const int tile, uint64_t rows[TILE_SIZE]) const
+{
+  const uint64_t fill = (tileKind(tile) == Passable) ? ~0ull : 0;
+  for (int y = 0; y < TILE_SIZE; ++y) { rows[y] = fill; }
+  if (tileKind(tile) != Encoded) { return; }
+
+  // a damaged file gives a wrong tile, never a read out of the data
+  const uint64_t end = min(_offsets[tile+1], _dataSize);
+  uint64_t position = min(_offsets[tile], end);
+  bool passable = false;
+  int cell = 0;
+  while (position < end && cell < TILE_CELLS)
+  {
+    int runLength = 0;
+    for (int shift = 0; position < end && shift < 28; shift += 7)
+    {
+      const unsigned char byte = _data[position++];
+      runLength |= (byte & 0x7F) << shift;
+      if (!(byte & 0x80)) { break; }
+    }
+    runLength = min(runLength, TILE_CELLS - cell);
+    if (passable)
+    {
+      // set the bits of the run, a row of the tile at a time
+      for (int runEnd = cell + runLength; cell < runEnd; )
+      {
+        const int x = cell & (TILE_SIZE-1);
+        const int count = min(runEnd - cell, TILE_SIZE - x);
+        rows[cell >> TILE_BITS] |= ((count == 64) ? ~0ull : ((1ull << count) - 1)) << x;
+        cell += count;
+      }
+    }
+    else
+    {
+      cell += runLength;
+    }
+    passable = !passable;
+  }
+}
+
+size_t CompressedMap::compressedSize() const
+{
+  return (size_t)(offsetsPosition(tileCount()) - sizeof(FileHeader)) + ((size_t)tileCount() + 1) * sizeof(uint64_t) + _dataSize;
+}
+
+TileCache::TileCache(const CompressedMap& map, const int nbSlots): _map(map), _slotShift(32), _decompressions(0)
+{
+  int slotBits = 0;
+  while ((1 << slotBits) < nbSlots) { ++slotBits; }
+  _slots.resize((size_t)1 << slotBits);
+  for (Slot& slot : _slots) { slot.tile = -1; }
+  _slotShift = 32 - slotBits;
+}
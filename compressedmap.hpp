@@ -0,0 +1,138 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "pathfinder.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Compressed maps
+// ############################################################################
+
+// Our largest maps are mostly empty : stored flat, they fill the disk and the page cache
+// with runs of identical cells. CompressedMap cuts the map in TILE_SIZE x TILE_SIZE tiles,
+// each compressed on its own : a uniform tile (all passable or all impassable) has no data,
+// the others are run-length encoded. A TileCache decompresses the tiles a search reaches, on
+// demand, into a few slots : a search touching part of the map never decompresses - nor,
+// from a file, reads - the rest. FindPathLarge() searches it through LargeMap::compressed().
+// Map and PreparedMap do not read through a TileCache : they are const and shared between threads,
+// where a cache belongs to one thread and changes on every miss, and their cell read is an inlined
+// byte load in every engine, which a cache lookup would slow on all the uncompressed maps.
+//
+// File format, in the byte order of the machine which wrote it (checked when opened) :
+//   header, 64 bytes : magic "PFTILES\x1a", version, byte order mark 0x01020304, width, height,
+//                      TILE_BITS, size of the tiles data in bytes
+//   tile kinds       : 1 byte per tile, row-major, then padding to 8 bytes
+//   tile offsets     : (tile count + 1) 64-bit offsets of the tiles in their data
+//   tiles data       : run lengths of each Encoded tile, alternately impassable and passable
+//                      (first run impassable, may be 0), row-major in the tile, LEB128 varints
+
+/*! \brief Map of up to (2^31-1) x (2^31-1) cells, compressed by tiles. Read-only and shareable between threads.
+ *
+ *  ex: CompressedMap(pMap, width, height).save("site.pftiles");  // once, offline
+ *      const CompressedMap compressed("site.pftiles");            // at startup
+ *      TileCache cache(compressed);                               // one per thread
+ *      FindPathLarge(0, 0, 99, 99, LargeMap::compressed(cache), pOutBuffer, nOutBufferSize);
+ */
+class CompressedMap
+{
+  public:
+  static const int TILE_BITS = 6;
+  static const int TILE_SIZE = 1 << TILE_BITS;  // a row of a tile is a 64-bit word
+  enum TileKind : unsigned char { Impassable = 0, Passable = 1, Encoded = 2 };
+
+  /*! \brief Compress a map of bytes, 0 for impassable cells as in FindPath(). The map is not kept.
+   *  \throw BadInputException if 1≤nMapWidth,nMapHeight is not respected
+   */
+  CompressedMap(const unsigned char* pMap, const int nMapWidth, const int nMapHeight);
+  /*! \brief Map a file written by save() read-only : tiles are read from disk when first decompressed.
+   *  \throw BadInputException if the file cannot be read, or is not a valid compressed map file
+   */
+  explicit CompressedMap(const string& path);
+  ~CompressedMap();
+  CompressedMap(const CompressedMap&) = delete;
+  CompressedMap& operator=(const CompressedMap&) = delete;
+
+  /*! \throw BadInputException if the file cannot be written */
+  void save(const string& path) const;
+
+  int width() const { return _mapWidth; }
+  int height() const { return _mapHeight; }
+  int tileCount() const { return _tilesPerRow * _tilesPerColumn; }
+  int tileOf(const Coordinates& coordCell) const { return (coordCell.Y >> TILE_BITS) * _tilesPerRow + (coordCell.X >> TILE_BITS); }
+  TileKind tileKind(const int tile) const { return (TileKind)_kinds[tile]; }
+
+  /*! \brief Decompress a tile : bit x of rows[y] is set if cell (x, y) of the tile is passable.
+   *         Cells beyond the edges of the map are impassable.
+   */
+  void decompressTile(const int tile, uint64_t rows[TILE_SIZE]) const;
+
+  /*! \brief Bytes of the tile kinds, offsets and data : the file size, but for its header */
+  size_t compressedSize() const;
+  /*! \brief false where memory mapping is not available, or for a map compressed in memory */
+  bool isMapped() const { return _mapped; }
+
+  private:
+  void initSize(const int nMapWidth, const int nMapHeight);
+
+  int _mapWidth, _mapHeight;
+  int _tilesPerRow, _tilesPerColumn;
+  const unsigned char* _kinds;
+  const uint64_t* _offsets;
+  const unsigned char* _data;
+  uint64_t _dataSize;
+  // compressed in memory
+  vector<unsigned char> _ownKinds;
+  vector<uint64_t> _ownOffsets;
+  vector<unsigned char> _ownData;
+  vector<uint64_t> _copy;      // file content when it is not mapped, in words : the offsets are aligned
+  const unsigned char* _file;  // the whole file when mapped
+  size_t _fileSize;
+  bool _mapped;
+};
+
+/*! \brief Decompressed tiles of a CompressedMap, for the searches of one thread.
+ *
+ *  Direct-mapped : a tile has one slot, chosen by hashing its number, and evicts the tile
+ *  which was there. Uniform tiles are answered from their kind, without a slot.
+ */
+class TileCache
+{
+  public:
+  /*! \param nbSlots tiles kept decompressed, rounded up to a power of 2 (512 bytes each) */
+  explicit TileCache(const CompressedMap& map, const int nbSlots = 64);
+
+  const CompressedMap& map() const { return _map; }
+  /*! \brief Is a cell of the map passable ? The cell must be in the map */
+  bool isCellOk(const Coordinates& coordCell)
+  {
+    const int tile = _map.tileOf(coordCell);
+    const CompressedMap::TileKind kind = _map.tileKind(tile);
+    if (kind != CompressedMap::Encoded) { return kind == CompressedMap::Passable; }
+    // Fibonacci hashing, as SparseSearchState : tiles a row of tiles apart do not share a slot
+    Slot& slot = _slots[(uint64_t)((uint32_t)tile * 2654435769u) >> _slotShift];
+    if (slot.tile != tile)
+    {
+      _map.decompressTile(tile, slot.rows);
+      slot.tile = tile;
+      ++_decompressions;
+    }
+    return (slot.rows[coordCell.Y & (CompressedMap::TILE_SIZE-1)] >> (coordCell.X & (CompressedMap::TILE_SIZE-1))) & 1;
+  }
+
+  /*! \brief Tiles decompressed since construction */
+  long long decompressions() const { return _decompressions; }
+
+  private:
+  struct Slot
+  {
+    int tile;
+    uint64_t rows[CompressedMap::TILE_SIZE];
+  };
+
+  const CompressedMap& _map;
+  vector<Slot> _slots;
+  int _slotShift;
+  long long _decompressions;
+};
@@ -0,0 +1,338 @@
+#include "externalsearch.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <system_error>
+#include <vector>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+// cells read or written at once : 64 KB, or less for small caps
+static const int64_t MAX_BLOCK_CELLS = 8192;
+static const int64_t MIN_BLOCK_CELLS = 512;
+
+static void throwIoError(const char* what)
+{
+  throw system_error(errno, generic_category(), string("in FindPathExternal(), ") + what);
+}
+
+/*! \brief Sorted cells at [offset, offset+count[ in a TempFile, in cells */
+struct Run
+{
+  int64_t offset;
+  int64_t count;
+};
+
+/*! \brief Temporary file of cells, deleted when closed */
+class TempFile
+{
+  public:
+  explicit TempFile(ExternalSearchStats& stats): _file(tmpfile()), _size(0), _stats(stats)
+  {
+    if (_file == nullptr) { throwIoError("cannot create a temporary file"); }
+    // whole blocks, or single cells read by binary search : the stdio buffer would only copy them
+    setvbuf(_file, nullptr, _IONBF, 0);
+  }
+  ~TempFile() { fclose(_file); }
+  TempFile(const TempFile&) = delete;
+  TempFile& operator=(const TempFile&) = delete;
+
+  int64_t size() const { return _size; }
+
+  void append(const int64_t* cells, const int64_t count)
+  {
+    if (count == 0) { return; }
+    seek(_size);
+    if (fwrite(cells, sizeof(int64_t), (size_t)count, _file) != (size_t)count) { throwIoError("cannot write a temporary file"); }
+    _size += count;
+    _stats.bytesWritten += count * (int64_t)sizeof(int64_t);
+  }
+
+  void read(const int64_t position, int64_t* cells, const int64_t count)
+  {
+    if (count == 0) { return; }
+    seek(position);
+    if (fread(cells, sizeof(int64_t), (size_t)count, _file) != (size_t)count) { throwIoError("cannot read a temporary file"); }
+    _stats.bytesRead += count * (int64_t)sizeof(int64_t);
+  }
+
+  private:
+  void seek(const int64_t position)
+  {
+#ifdef _WIN32
+    const int result = _fseeki64(_file, position * (int64_t)sizeof(int64_t), SEEK_SET);
+#else
+    const int result = fseeko(_file, (off_t)(position * (int64_t)sizeof(int64_t)), SEEK_SET);
+#endif
+    if (result != 0) { throwIoError("cannot seek in a temporary file"); }
+  }
+
+  FILE* _file;
+  int64_t _size;
+  ExternalSearchStats& _stats;
+};
+
+/*! \brief Reads a run by blocks, or cells in memory */
+class RunReader
+{
+  public:
+  RunReader(TempFile& file, const Run& run, const int64_t blockCells):
+    _file(&file), _next(run.offset), _end(run.offset + run.count), _block((size_t)blockCells), _cursor(nullptr), _blockEnd(nullptr)
+  {
+    refill();
+  }
+  RunReader(const int64_t* cells, const int64_t count):
+    _file(nullptr), _next(0), _end(0), _cursor(cells), _blockEnd(cells + count) {}
+  RunReader(RunReader&&) = default;
+  RunReader(const RunReader&) = delete;
+
+  bool done() const { return _cursor == _blockEnd; }
+  int64_t value() const { return *_cursor; }
+  void next()
+  {
+    if (++_cursor == _blockEnd && _file != nullptr) { refill(); }
+  }
+  /*! \brief Skip the cells lower than cell : is cell in the run ? The cells asked must increase */
+  bool skipTo(const int64_t cell)
+  {
+    while (!done() && value() < cell) { next(); }
+    return !done() && value() == cell;
+  }
+
+  private:
+  void refill()
+  {
+    const int64_t count = min((int64_t)_block.size(), _end - _next);
+    _file->read(_next, _block.data(), count);
+    _next += count;
+    _cursor = _block.data();
+    _blockEnd = _cursor + count;
+  }
+
+  TempFile* _file;  // nullptr for cells in memory
+  int64_t _next, _end;
+  vector<int64_t> _block;
+  const int64_t* _cursor;
+  const int64_t* _blockEnd;
+};
+
+/*! \brief Appends a run at the end of a file, by blocks */
+class RunWriter
+{
+  public:
+  RunWriter(TempFile& file, const int64_t blockCells): _file(file), _start(file.size()), _count(0), _blockCells(blockCells)
+  {
+    _block.reserve((size_t)blockCells);
+  }
+
+  void push(const int64_t cell)
+  {
+    _block.push_back(cell);
+    ++_count;
+    if ((int64_t)_block.size() == _blockCells) { flush(); }
+  }
+  Run finish()
+  {
+    flush();
+    return Run{_start, _count};
+  }
+
+  private:
+  void flush()
+  {
+    _file.append(_block.data(), (int64_t)_block.size());
+    _block.clear();
+  }
+
+  TempFile& _file;
+  int64_t _start, _count;
+  int64_t _blockCells;
+  vector<int64_t> _block;
+};
+
+/*! \brief Merge sorted runs, calling output once per distinct cell, in increasing order */
+static void mergeRuns(vector<RunReader>& readers, const function<void(int64_t)>& output)
+{
+  typedef pair<int64_t, size_t> Head;  // next cell of a reader, and the reader
+  priority_queue<Head, vector<Head>, greater<Head>> heads;
+  for (size_t reader = 0; reader < readers.size(); ++reader)
+  {
+    if (!readers[reader].done()) { heads.push(Head(readers[reader].value(), reader)); }
+  }
+  bool first = true;
+  int64_t last = 0;
+  while (!heads.empty())
+  {
+    const Head head = heads.top();
+    heads.pop();
+    if (first || head.first != last) { output(head.first); }
+    first = false;
+    last = head.first;
+    RunReader& reader = readers[head.second];
+    reader.next();
+    if (!reader.done()) { heads.push(Head(reader.value(), head.second)); }
+  }
+}
+
+/*! \brief Is cell in a layer ? By dichotomy in the file */
+static bool layerContains(TempFile& layers, const Run& layer, const int64_t cell)
+{
+  int64_t low = 0, high = layer.count;
+  while (low < high)
+  {
+    const int64_t middle = low + (high - low) / 2;
+    int64_t value;
+    layers.read(layer.offset + middle, &value, 1);
+    if (value == cell) { return true; }
+    if (value < cell) { low = middle + 1; }
+    else              { high = middle; }
+  }
+  return false;
+}
+
+int64_t FindPathExternal(const int nStartX, const int nStartY,
+                         const int nTargetX, const int nTargetY,
+                         const LargeMap& map,
+                         int64_t* pOutBuffer, const int64_t nOutBufferSize,
+                         const size_t maxBytes, ExternalSearchStats* pStats)
+{
+  throwIfBadInput(checkLargeInput(nStartX, nStartY, nTargetX, nTargetY, map, nOutBufferSize));
+  ExternalSearchStats localStats;
+  ExternalSearchStats& stats = (pStats != nullptr) ? *pStats : localStats;
+  stats = ExternalSearchStats();
+  const Coordinates start(nStartX, nStartY), target(nTargetX, nTargetY);
+  if (start == target) { return 0; }
+  auto startTime = chrono::steady_clock::now();
+
+  // half of the memory collects the neighbors, the other half holds the blocks of the readers and writer :
+  // at least 16 blocks, so that most layers are merged in one pass
+  const size_t halfBytes = max(maxBytes, MIN_EXTERNAL_BYTES) / 2;
+  const size_t bufferCells = halfBytes / sizeof(int64_t);
+  const int64_t blockCells = min(MAX_BLOCK_CELLS, max(MIN_BLOCK_CELLS, (int64_t)(bufferCells / 16)));
+  const size_t blockBytes = (size_t)blockCells * sizeof(int64_t);
+  const size_t fanIn = max<size_t>(2, halfBytes / blockBytes - 3);  // but the current and previous layers, and the writer
+  stats.bytesAllocated = (long long)(bufferCells * sizeof(int64_t) + (fanIn + 3) * blockBytes);
+
+  const int64_t targetIndex = map.coordinatesToIndex(target);
+  TempFile layers(stats);
+  vector<Run> layerRuns;
+  {
+    const int64_t startIndex = map.coordinatesToIndex(start);
+    layers.append(&startIndex, 1);
+    layerRuns.push_back(Run{0, 1});
+  }
+
+  vector<int64_t> buffer;
+  buffer.reserve(bufferCells);
+  bool found = false;
+  while (!found)
+  {
+    // the neighbors of the current layer, in sorted runs when they do not fit in the buffer
+    unique_ptr<TempFile> runsFile;
+    vector<Run> runs;
+    auto spill = [&]() {
+      sort(buffer.begin(), buffer.end());
+      buffer.erase(unique(buffer.begin(), buffer.end()), buffer.end());
+      if (!runsFile) { runsFile.reset(new TempFile(stats)); }
+      runs.push_back(Run{runsFile->size(), (int64_t)buffer.size()});
+      runsFile->append(buffer.data(), (int64_t)buffer.size());
+      ++stats.runsWritten;
+      buffer.clear();
+    };
+    for (RunReader current(layers, layerRuns.back(), blockCells); !current.done(); current.next())
+    {
+      Coordinates neighbors[4];
+      const int nbNeighbors = map.findNeighbors(map.indexToCoordinates(current.value()), neighbors);
+      for (int i = 0; i < nbNeighbors; ++i) { buffer.push_back(map.coordinatesToIndex(neighbors[i])); }
+      if (buffer.size() + 4 > bufferCells) { spill(); }
+    }
+
+    vector<RunReader> readers;
+    if (runs.empty())
+    {
+      sort(buffer.begin(), buffer.end());
+      readers.emplace_back(buffer.data(), (int64_t)buffer.size());
+    }
+    else
+    {
+      if (!buffer.empty()) { spill(); }
+      // more runs than blocks : merge them by groups first
+      while (runs.size() > fanIn)
+      {
+        unique_ptr<TempFile> mergedFile(new TempFile(stats));
+        vector<Run> mergedRuns;
+        for (size_t group = 0; group < runs.size(); group += fanIn)
+        {
+          vector<RunReader> groupReaders;
+          for (size_t run = group; run < min(runs.size(), group + fanIn); ++run) { groupReaders.emplace_back(*runsFile, runs[run], blockCells); }
+          RunWriter writer(*mergedFile, blockCells);
+          mergeRuns(groupReaders, [&](const int64_t cell) { writer.push(cell); });
+          mergedRuns.push_back(writer.finish());
+        }
+        runsFile = move(mergedFile);
+        runs = mergedRuns;
+      }
+      for (const Run& run : runs) { readers.emplace_back(*runsFile, run, blockCells); }
+    }
+
+    // next layer : the neighbors, but those of the current and previous layers
+    RunReader current(layers, layerRuns.back(), blockCells);
+    RunReader previous = (layerRuns.size() >= 2) ? RunReader(layers, layerRuns[layerRuns.size() - 2], blockCells) : RunReader(nullptr, 0);
+    RunWriter next(layers, blockCells);
+    mergeRuns(readers, [&](const int64_t cell) {
+      if (current.skipTo(cell) || previous.skipTo(cell)) { return; }
+      next.push(cell);
+      found = found || (cell == targetIndex);
+    });
+    readers.clear();
+    buffer.clear();
+    const Run layer = next.finish();
+    if (layer.count == 0) { break; }  // every reachable cell was reached
+    layerRuns.push_back(layer);
+    ++stats.layers;
+    stats.cellsReached += layer.count;
+    stats.peakLayerCells = max(stats.peakLayerCells, (long long)layer.count);
+  }
+  stats.cellsReached += 1;  // Start
+  stats.searchMicroseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count();
+  if (!found) { return -1; }
+
+  // backwards from Target : a neighbor in the layer before, first in the order of findNeighbors()
+  startTime = chrono::steady_clock::now();
+  const int64_t length = (int64_t)layerRuns.size() - 1;
+  if (length <= nOutBufferSize)
+  {
+    int64_t cell = targetIndex;
+    for (int64_t distance = length; distance >= 1; --distance)
+    {
+      pOutBuffer[distance - 1] = cell;
+      // a layer of a block is read whole, a larger one searched in the file
+      const Run& layer = layerRuns[distance - 1];
+      if (layer.count <= blockCells)
+      {
+        buffer.resize((size_t)layer.count);
+        layers.read(layer.offset, buffer.data(), layer.count);
+      }
+      Coordinates neighbors[4];
+      const int nbNeighbors = map.findNeighbors(map.indexToCoordinates(cell), neighbors);
+      for (int i = 0; i < nbNeighbors; ++i)
+      {
+        const int64_t neighbor = map.coordinatesToIndex(neighbors[i]);
+        if ((layer.count <= blockCells) ? binary_search(buffer.begin(), buffer.end(), neighbor)
+                                         : layerContains(layers, layer, neighbor))
+        {
+          cell = neighbor;
+          break;
+        }
+      }
+    }
+  }
+  stats.outputMicroseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - startTime).count();
+  return length;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "largemap.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### External-memory search
+// ############################################################################
+
+// A search keeps every cell it reaches in memory : on maps larger than RAM - mapped from disk,
+// possibly compressed (CompressedMap) - a long query can reach more cells than memory holds.
+// FindPathExternal() is a breadth-first search with delayed duplicate detection (Munagala and
+// Ranade, 1999) : the layers of cells at distance 0, 1, 2... of Start are sorted runs in a
+// temporary file. The next layer is built from the current one only : its neighbors are
+// collected in a memory buffer, sorted and written as runs when it is full, then the runs are
+// merged, removing the duplicates and the cells of the current and previous layers (on a grid
+// the neighbors of a layer are in the layer before, the same layer or the next one).
+// Only the buffer and a block per run are in memory, whatever the number of cells reached.
+// The path is recovered backwards from Target : at each distance, a neighbor found in the
+// layer before, by binary search in the file.
+
+/*! \brief Statistics of FindPathExternal() */
+struct ExternalSearchStats
+{
+  long long layers = 0;          //!< layers built after Start's : the path length if Target was reached
+  long long cellsReached = 0;    //!< cells in all the layers
+  long long peakLayerCells = 0;  //!< cells in the largest layer
+  long long runsWritten = 0;     //!< sorted runs written, when the neighbors of a layer did not fit in memory
+  long long bytesWritten = 0;    //!< to the temporary files
+  long long bytesRead = 0;       //!< from the temporary files
+  long long bytesAllocated = 0;  //!< memory of the buffers
+  double searchMicroseconds = 0;
+  double outputMicroseconds = 0;
+};
+
+/*! \brief Smallest memory cap of FindPathExternal() : smaller caps are raised to it */
+const size_t MIN_EXTERNAL_BYTES = 16 << 10;
+
+/*! \brief Same contract as FindPathLarge(), keeping at most about maxBytes in memory and the rest in temporary files.
+ *
+ *  The temporary files are created with tmpfile(), and deleted when the search ends.
+ *  ex: int64_t length = FindPathExternal(0, 0, 99999, 99999, LargeMap::compressed(cache), pOutBuffer, nOutBufferSize, 64 << 20);
+ *  \param maxBytes memory of the buffers, at least MIN_EXTERNAL_BYTES
+ *  \throw BadInputException on the same inputs as FindPathLarge()
+ *  \throw std::system_error if the temporary files cannot be created or written (disk full)
+ */
+int64_t FindPathExternal(const int nStartX, const int nStartY,
+                         const int nTargetX, const int nTargetY,
+                         const LargeMap& map,
+                         int64_t* pOutBuffer, const int64_t nOutBufferSize,
+                         const size_t maxBytes, ExternalSearchStats* pStats = nullptr);
@@ -0,0 +1,125 @@
+#include "findpathasync.hpp"
+#include "preparedmap.hpp"
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+Executor::Executor(const unsigned int nbThreads): _stopping(false)
+{
+  const unsigned int count = (nbThreads > 0) ? nbThreads : max(1u, thread::hardware_concurrency());
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    _threads.emplace_back(&Executor::run, this);
+  }
+}
+
+Executor::~Executor()
+{
+  {
+    lock_guard<mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _wakeUp.notify_all();
+  for (thread& worker : _threads)
+  {
+    worker.join();
+  }
+}
+
+void Executor::submit(function<void()> task)
+{
+  {
+    lock_guard<mutex> lock(_mutex);
+    _tasks.push(move(task));
+  }
+  _wakeUp.notify_one();
+}
+
+Executor& Executor::instance()
+{
+  static Executor executor;
+  return executor;
+}
+
+void Executor::run()
+{
+  while (true)
+  {
+    function<void()> task;
+    {
+      unique_lock<mutex> lock(_mutex);
+      _wakeUp.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+      if (_tasks.empty()) { return; } // stopping, and nothing left to do
+      task = move(_tasks.front());
+      _tasks.pop();
+    }
+    // the searches of the task take their memory from the arena of this thread, given back after the task
+    ArenaScope scope;
+    task();
+  }
+}
+
+/*! \brief Run a query on a PreparedMap, stopping on cancellation or deadline */
+static FindPathResult runQuery(const PreparedMap& preparedMap,
+                               const int nStartX, const int nStartY,
+                               const int nTargetX, const int nTargetY,
+                               int* pOutBuffer, const int nOutBufferSize,
+                               const StopCondition& stopCondition)
+{
+  FindPathResult result = {stopCondition.check(), -1};
+  if (result.status != FindPathStatus::Ok) { return result; } // abandoned before starting
+
+  result.status = checkQueryInput(nStartX, nStartY, nTargetX, nTargetY,
+                                  preparedMap.width(), preparedMap.height(), nOutBufferSize);
+  if (result.status != FindPathStatus::Ok) { return result; }
+
+  Pathfinder pathfinder(nStartX, nStartY, nTargetX, nTargetY, preparedMap, pOutBuffer, nOutBufferSize);
+  pathfinder.setStopCondition(&stopCondition);
+  result.status = pathfinder.findPathNoExcept(&result.length);
+  return result;
+}
+
+future<FindPathResult> FindPathAsync(const int nStartX, const int nStartY,
+                                     const int nTargetX, const int nTargetY,
+                                     const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                     int* pOutBuffer, const int nOutBufferSize,
+                                     const CancellationToken& token,
+                                     const chrono::steady_clock::time_point deadline)
+{
+  auto promise = make_shared<std::promise<FindPathResult>>();
+  future<FindPathResult> result = promise->get_future();
+  Executor::instance().submit([=]() {
+    StopCondition stopCondition;
+    stopCondition.cancelled = token.flag();  // the lambda holds a copy of the token : the flag stays alive
+    stopCondition.deadline = deadline;
+
+    FindPathResult queryResult = {checkMapInput(nMapWidth, nMapHeight), -1};
+    if (queryResult.status == FindPathStatus::Ok)
+    {
+      const PreparedMap preparedMap(pMap, nMapWidth, nMapHeight);
+      queryResult = runQuery(preparedMap, nStartX, nStartY, nTargetX, nTargetY, pOutBuffer, nOutBufferSize, stopCondition);
+    }
+    promise->set_value(queryResult);
+  });
+  return result;
+}
+
+future<FindPathResult> FindPathAsync(const PreparedMap& preparedMap,
+                                     const int nStartX, const int nStartY,
+                                     const int nTargetX, const int nTargetY,
+                                     int* pOutBuffer, const int nOutBufferSize,
+                                     const CancellationToken& token,
+                                     const chrono::steady_clock::time_point deadline)
+{
+  auto promise = make_shared<std::promise<FindPathResult>>();
+  future<FindPathResult> result = promise->get_future();
+  const PreparedMap* pPreparedMap = &preparedMap;
+  Executor::instance().submit([=]() {
+    StopCondition stopCondition;
+    stopCondition.cancelled = token.flag();
+    stopCondition.deadline = deadline;
+    promise->set_value(runQuery(*pPreparedMap, nStartX, nStartY, nTargetX, nTargetY, pOutBuffer, nOutBufferSize, stopCondition));
+  });
+  return result;
+}
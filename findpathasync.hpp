@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "pathfinder.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Asynchronous queries
+// ############################################################################
+
+// FindPathAsync() submits a query to an internal pool of threads and returns at once.
+// The caller owns pMap (or the PreparedMap) and pOutBuffer, and must keep them alive
+// and untouched until the future is ready - exactly as for a FindPath() running in another thread.
+
+/*! \brief Result of an asynchronous query.
+ *
+ *  length is only meaningful when status is FindPathStatus::Ok.
+ */
+struct FindPathResult
+{
+  FindPathStatus status;
+  int length;
+};
+
+/*! \brief Shared flag to cancel one or several asynchronous queries.
+ *
+ *  Copies share the same flag. A cancelled query which has not started is never run,
+ *  a running one stops at its next StopCondition check.
+ */
+class CancellationToken
+{
+  public:
+  CancellationToken(): _cancelled(make_shared<atomic<bool>>(false)) {}
+
+  void cancel() { _cancelled->store(true); }
+  bool isCancelled() const { return _cancelled->load(); }
+  const atomic<bool>* flag() const { return _cancelled.get(); }
+
+  private:
+  shared_ptr<atomic<bool>> _cancelled;
+};
+
+/*! \brief Fixed pool of threads running tasks in submission order. */
+class Executor
+{
+  public:
+  /*! \param nbThreads number of threads, 0 for one per hardware thread */
+  explicit Executor(const unsigned int nbThreads = 0);
+  /*! \brief Finish the tasks already submitted, then join the threads */
+  ~Executor();
+
+  void submit(function<void()> task);
+
+  /*! \brief Executor used by FindPathAsync(), created on first use */
+  static Executor& instance();
+
+  private:
+  void run();
+
+  vector<thread> _threads;
+  queue<function<void()>> _tasks;
+  mutex _mutex;
+  condition_variable _wakeUp;
+  bool _stopping;
+};
+
+/*! \brief Same as FindPathNoExcept(), running in the internal executor.
+ *
+ *  \param token     cancel() stops the query, which then completes with FindPathStatus::Cancelled
+ *  \param deadline  past it, the query completes with FindPathStatus::DeadlineExceeded
+ */
+future<FindPathResult> FindPathAsync(const int nStartX, const int nStartY,
+                                     const int nTargetX, const int nTargetY,
+                                     const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                     int* pOutBuffer, const int nOutBufferSize,
+                                     const CancellationToken& token = CancellationToken(),
+                                     const chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max());
+
+/*! \brief Same as above, on a PreparedMap */
+future<FindPathResult> FindPathAsync(const PreparedMap& preparedMap,
+                                     const int nStartX, const int nStartY,
+                                     const int nTargetX, const int nTargetY,
+                                     int* pOutBuffer, const int nOutBufferSize,
+                                     const CancellationToken& token = CancellationToken(),
+                                     const chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max());
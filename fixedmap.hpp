@@ -0,0 +1,292 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "pathfinder.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Fixed-size small maps
+// ############################################################################
+
+// On small maps - rooms of 32x32 or 64x64 cells - a query expands a few hundred cells, and
+// setting the search up costs about as much as the search : the dense state and the open list
+// are allocated and initialized for each query, and every index goes through the runtime width.
+// FixedMap<W,H> fixes the dimensions at compile time : it is a copy of the map with a border of
+// impassable cells, whose row pitch W+2 is a constant. The 4 neighbor offsets are constants,
+// and the border removes the bounds checks.
+// FixedPathfinder<W,H> keeps the FixedMap and its whole search state on the stack, in 16-bit
+// arrays, with a 4-ary heap of 64-bit keys as open list : a query allocates nothing. The keys
+// order the cells as Pathfinder's IndexedHeap with TieBreak::HigherG does : FixedPathfinder
+// expands the same cells in the same order, and returns the same path.
+// FindPath() and the queries of a PreparedMap without preprocessing use it when the map fits
+// in 64x64 cells : about 16 KB of stack for a 32x32 map, 62 KB for a 64x64 one.
+
+/*! \brief Copy of a map of at most W x H cells, with a border of impassable cells, indexed with a constant row pitch.
+ *
+ *  ex: FixedMap<64, 64> fixedMap(Map(pMap, 40, 30));
+ *      int index = fixedMap.index(Coordinates(3, 4));
+ *      bool passable = fixedMap.isCellOk(index + FixedMap<64, 64>::OFFSETS[0]);  // the cell above
+ */
+template<int W, int H>
+class FixedMap
+{
+  public:
+  static constexpr int PITCH = W + 2;  // a border cell on each side of a row
+  static constexpr int CELL_COUNT = PITCH * (H + 2);
+  // up, down, left, right : the order of Map::findNeighbors()
+  static constexpr int OFFSETS[4] = {-PITCH, PITCH, -1, 1};
+
+  static bool fits(const int nMapWidth, const int nMapHeight) { return nMapWidth <= W && nMapHeight <= H; }
+
+  /*! \brief Copy the cells of a map, which must fit */
+  explicit FixedMap(const Map& map): _width(map.width()), _height(map.height())
+  {
+    assert(fits(_width, _height));
+    // the rows of the map and the border rows : the cells right of the border of a narrower map are never read
+    memset(_cells, 0, (_height + 2) * PITCH);
+    const MapView view = map.view();
+    for (int y = 0; y < _height; ++y)
+    {
+      unsigned char* row = _cells + (y + 1) * PITCH + 1;
+      if (view.isPacked())
+      {
+        memcpy(row, view.pOrigin + y * _width, _width);
+        continue;
+      }
+      for (int x = 0; x < _width; ++x) { row[x] = map.isCellOk(Coordinates(x, y)) ? 1 : 0; }
+    }
+  }
+
+  /*! \brief false for impassable cells and for the border */
+  bool isCellOk(const int index) const { return _cells[index] != 0; }
+  int index(const Coordinates& coordCell) const { return (coordCell.Y + 1) * PITCH + coordCell.X + 1; }
+  const Coordinates coordinates(const int index) const { return Coordinates(index % PITCH - 1, index / PITCH - 1); }
+  /*! \brief Index of a cell in the input map, row-major */
+  int mapIndex(const int index) const { return (index / PITCH - 1) * _width + index % PITCH - 1; }
+  /*! \brief Manhattan distance, ignoring obstacles */
+  int distance(const int index, const Coordinates& coordCell) const
+  {
+    return abs(index % PITCH - 1 - coordCell.X) + abs(index / PITCH - 1 - coordCell.Y);
+  }
+  int width() const { return _width; }
+  int height() const { return _height; }
+
+  private:
+  int _width, _height;
+  unsigned char _cells[CELL_COUNT];  // not 0 if passable, only the first (_height + 2) rows are initialized
+};
+
+/*! \brief A* on a map of at most W x H cells, with its search state on the stack.
+ *
+ *  Same search and same path as Pathfinder with TieBreak::HigherG. Like Pathfinder, the query
+ *  must have passed checkQueryInput() : findPath() only checks that Start and Target are passable.
+ *  ex: FixedPathfinder<64, 64> pathfinder(0, 0, 39, 29, Map(pMap, 40, 30), pOutBuffer, nOutBufferSize);
+ *      int length = pathfinder.findPath();
+ */
+template<int W, int H>
+class FixedPathfinder
+{
+  public:
+  // cell indexes, costs, heap positions and insertion orders are 16-bit : the orders are bounded by 4 puts per cell
+  static_assert(W > 0 && H > 0 && 4 * W * H < 0x10000 && FixedMap<W, H>::CELL_COUNT <= 0x10000,
+                "FixedPathfinder : the map is too large for 16-bit indexes");
+
+  /*! \brief The map must fit : FixedMap<W,H>::fits() */
+  FixedPathfinder(const int nStartX, const int nStartY,
+                  const int nTargetX, const int nTargetY,
+                  const Map& map,
+                  int* pOutBuffer, const int nOutBufferSize):
+    _start(nStartX, nStartY), _target(nTargetX, nTargetY), _map(map),
+    _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize)
+  {
+    assert((FixedMap<W, H>::fits(map.width(), map.height())));
+  }
+
+  /*! \brief Same as Pathfinder::findPath() */
+  int findPath(SearchStats* pStats = nullptr)
+  {
+    throwIfBadInput(checkInput());
+    return search(pStats);
+  }
+
+  /*! \brief Same as Pathfinder::findPathNoExcept() : nothing is allocated, only bad input is reported */
+  FindPathStatus findPathNoExcept(int* pLength, SearchStats* pStats = nullptr) noexcept
+  {
+    const FindPathStatus status = checkInput();
+    if (status != FindPathStatus::Ok) { return status; }
+    *pLength = search(pStats);
+    return FindPathStatus::Ok;
+  }
+
+  /*! \brief Check Start and Target are passable (the rest is checked by checkQueryInput()) */
+  FindPathStatus checkInput() const
+  {
+    if (!_map.isCellOk(_start))  { return FindPathStatus::StartNotPassable; }
+    if (!_map.isCellOk(_target)) { return FindPathStatus::TargetNotPassable; }
+    return FindPathStatus::Ok;
+  }
+
+  private:
+  static const int ARITY = 4;
+  static const int16_t NOT_QUEUED = -1;
+  static const int16_t CLOSED = -2;
+  static const uint16_t UNREACHED = 0xFFFF;
+
+  /*! \brief The whole search state, a local of search() */
+  struct SearchState
+  {
+    explicit SearchState(const Map& map): map(map), heapSize(0)
+    {
+      // as in FixedMap, only the rows of the map and of its border are used
+      const int used = (map.height() + 2) * FixedMap<W, H>::PITCH;
+      memset(costFromStart, 0xFF, used * sizeof(uint16_t));  // UNREACHED
+      memset(positions, 0xFF, used * sizeof(int16_t));       // NOT_QUEUED
+    }
+
+    FixedMap<W, H> map;
+    uint16_t costFromStart[FixedMap<W, H>::CELL_COUNT];
+    uint16_t parents[FixedMap<W, H>::CELL_COUNT];   // only set for the reached cells
+    int16_t positions[FixedMap<W, H>::CELL_COUNT];  // in the heap, or NOT_QUEUED, or CLOSED once expanded
+    uint64_t heap[W * H];                           // keys, see makeKey()
+    int heapSize;
+  };
+
+  /*! \brief Key of the heap : priority, then higher cost from Start, then insertion order - the QueueKey of
+   *         TieBreak::HigherG - in one integer. The cell index in the low bits never decides, the order is unique.
+   */
+  static uint64_t makeKey(const int priority, const int costFromStart, const int order, const int index)
+  {
+    return ((uint64_t)priority << 48) | ((uint64_t)(UNREACHED - costFromStart) << 32) | ((uint64_t)order << 16) | (uint64_t)index;
+  }
+  static int keyIndex(const uint64_t key) { return (int)(key & 0xFFFF); }
+
+  int search(SearchStats* pStats)
+  {
+    if (pStats == nullptr)
+    {
+      NoStatsCollector collector;
+      return search(collector);
+    }
+    StatsCollector collector(*pStats);
+    return search(collector);
+  }
+
+  template<class Collector>
+  int search(Collector& collector)
+  {
+    // Easy case : Target and Start are the same location
+    if (_start == _target) { return 0; }
+
+    collector.startSearch();
+    SearchState state(_map);
+    const FixedMap<W, H>& map = state.map;
+    const int startIndex  = map.index(_start);
+    const int targetIndex = map.index(_target);
+    state.costFromStart[startIndex] = 0;
+    int order = 0;
+    put(state, makeKey(0, 0, order++, startIndex));
+    collector.openListSize(state.heapSize);
+
+    bool foundTarget = false;
+    while (state.heapSize > 0)
+    {
+      const int currentIndex = dequeue(state);
+      if (currentIndex == targetIndex)
+      {
+        foundTarget = true;
+        break;
+      }
+      state.positions[currentIndex] = CLOSED;
+      collector.expanded();
+
+      const int newCost = state.costFromStart[currentIndex] + 1;
+      for (const int offset : FixedMap<W, H>::OFFSETS)
+      {
+        const int nextIndex = currentIndex + offset;
+        if (!map.isCellOk(nextIndex) || state.positions[nextIndex] == CLOSED) { continue; }
+        collector.generated();
+        if (newCost < state.costFromStart[nextIndex])
+        {
+          state.costFromStart[nextIndex] = (uint16_t)newCost;
+          state.parents[nextIndex] = (uint16_t)currentIndex;
+          put(state, makeKey(newCost + map.distance(nextIndex, _target), newCost, order++, nextIndex));
+        }
+      }
+      collector.openListSize(state.heapSize);
+    }
+    collector.allocated(sizeof(SearchState));  // on the stack
+    collector.endSearch();
+
+    collector.startOutput();
+    const int length = foundTarget ? convertToOutput(state, startIndex, targetIndex) : -1;
+    collector.endOutput();
+    return length;
+  }
+
+  int convertToOutput(const SearchState& state, const int startIndex, const int targetIndex)
+  {
+    // the cost from Start of Target is the length of the path
+    const int length = state.costFromStart[targetIndex];
+    if (length <= _outBufferSize)
+    {
+      int cursor = length;
+      for (int index = targetIndex; index != startIndex; index = state.parents[index])
+      {
+        _outBuffer[--cursor] = state.map.mapIndex(index);
+      }
+    }
+    return length;
+  }
+
+  /*! \brief Insert a cell, or move it up to its improved key */
+  static void put(SearchState& state, const uint64_t key)
+  {
+    int position = state.positions[keyIndex(key)];
+    if (position == NOT_QUEUED) { position = state.heapSize++; }
+    while (position > 0)
+    {
+      const int parent = (position - 1) / ARITY;
+      if (state.heap[parent] < key) { break; }
+      place(state, state.heap[parent], position);
+      position = parent;
+    }
+    place(state, key, position);
+  }
+
+  static int dequeue(SearchState& state)
+  {
+    const int bestIndex = keyIndex(state.heap[0]);
+    const uint64_t last = state.heap[--state.heapSize];
+    const int size = state.heapSize;
+    if (size == 0) { return bestIndex; }
+    int position = 0;
+    while (true)
+    {
+      const int firstChild = position * ARITY + 1;
+      if (firstChild >= size) { break; }
+      const int lastChild = min(firstChild + ARITY, size);
+      int bestChild = firstChild;
+      for (int child = firstChild + 1; child < lastChild; ++child)
+      {
+        if (state.heap[child] < state.heap[bestChild]) { bestChild = child; }
+      }
+      if (last < state.heap[bestChild]) { break; }
+      place(state, state.heap[bestChild], position);
+      position = bestChild;
+    }
+    place(state, last, position);
+    return bestIndex;
+  }
+
+  static void place(SearchState& state, const uint64_t key, const int position)
+  {
+    state.heap[position] = key;
+    state.positions[keyIndex(key)] = (int16_t)position;
+  }
+
+  Coordinates _start, _target;
+  Map _map;
+  int* _outBuffer;
+  int _outBufferSize;
+};
@@ -0,0 +1,188 @@
+#include "focalpathfinder.hpp"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+FocalPathfinder::FocalPathfinder(const int nStartX, const int nStartY,
+                                 const int nTargetX, const int nTargetY,
+                                 const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                 int* pOutBuffer, const int nOutBufferSize,
+                                 const FocalOptions& options):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(pMap, nMapWidth, nMapHeight),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _options(options)
+{
+  throwIfBadInput(checkMapInput(nMapWidth, nMapHeight));
+  throwIfBadInput(_map.checkQuery(_start, _target, nOutBufferSize));
+}
+
+FocalPathfinder::FocalPathfinder(const int nStartX, const int nStartY,
+                                 const int nTargetX, const int nTargetY,
+                                 const PreparedMap& preparedMap,
+                                 int* pOutBuffer, const int nOutBufferSize,
+                                 const FocalOptions& options):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(preparedMap),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _options(options)
+{
+  throwIfBadInput(_map.checkQuery(_start, _target, nOutBufferSize));
+}
+
+int FocalPathfinder::findPath(SearchStats* pStats)
+{
+  if (pStats == nullptr)
+  {
+    NoStatsCollector collector;
+    return search(collector);
+  }
+  StatsCollector collector(*pStats);
+  return search(collector);
+}
+
+template<class Collector>
+int FocalPathfinder::search(Collector& collector)
+{
+  // Easy case : Target and Start are the same location
+  if (_start == _target) { return 0; }
+
+  // Easy case : Target and Start are not in the same connected component, there is no path
+  if (!_map.mayConnect(_start, _target))
+  {
+    return -1;
+  }
+
+  collector.startSearch();
+  const vector<int> shortestPathTree = focalSearch(collector);
+  collector.endSearch();
+
+  collector.startOutput();
+  const int length = convertToOutput(shortestPathTree);
+  collector.endOutput();
+  return length;
+}
+
+template<class Collector>
+const vector<int> FocalPathfinder::focalSearch(Collector& collector)
+{
+  const int mapSize = _map.cellCount();
+  const int startIndex  = _map.coordinatesToIndex(_start);
+  const int targetIndex = _map.coordinatesToIndex(_target);
+
+  // same arrays as Pathfinder::Astar()
+  vector<int> shortestPathTree(mapSize, -1);
+  vector<int> costFromStart(mapSize, INT_MAX);
+  costFromStart[startIndex] = 0;
+  // Cells expanded out of f order may be reached later by a shorter path :
+  // they are then opened again, which keeps the (1 + epsilon) guarantee.
+  vector<bool> expanded(mapSize, false);
+
+  // Open list ordered by f = g + h, focal list ordered by the secondary heuristics.
+  // Every cell of the focal list is also in the open list.
+  IndexedHeap open(mapSize, TieBreak::HigherG);
+  IndexedHeap focal(mapSize, TieBreak::HigherG);
+  const double factor = 1 + max(0.0, _options.epsilon);
+  auto focalBoundOf = [factor](const int lowestF) { return (int)min((double)INT_MAX, floor(factor * lowestF)); };
+  auto putFocal = [this, &focal](const int index, const int heuristics, const int cost) {
+    if (focal.contains(index)) { focal.remove(index); }  // its focal priority may be worse now
+    if (_options.heuristic == FocalHeuristic::DistanceToGo) { focal.put(index, heuristics, -cost); }
+    else                                                    { focal.put(index, -cost, -heuristics); }
+  };
+
+  const int startHeuristics = _map.distance(_start, _target);
+  open.put(startIndex, startHeuristics, 0);
+  putFocal(startIndex, startHeuristics, 0);
+  int focalBound = focalBoundOf(startHeuristics);
+  collector.openListSize(open.size());
+
+  bool foundTarget = false;
+  while (!focal.empty())
+  {
+    const int currentIndex = focal.dequeue();
+    open.remove(currentIndex);
+
+    // early exit - the target is in the focal list, so its cost is within the bound
+    if (currentIndex == targetIndex)
+    {
+      foundTarget = true;
+      break;
+    }
+    if (expanded[currentIndex]) { collector.reExpanded(); }
+    expanded[currentIndex] = true;
+    collector.expanded();
+
+    const Coordinates currentCell = _map.indexToCoordinates(currentIndex);
+    const int newCost = costFromStart[currentIndex] + 1;
+    Coordinates neighbors[4];
+    const int nbNeighbors = _map.findNeighbors(currentCell, neighbors);
+    for (int i = 0; i < nbNeighbors; ++i)
+    {
+      const Coordinates& nextCell = neighbors[i];
+      const int nextIndex = _map.coordinatesToIndex(nextCell);
+      collector.generated();
+      if (newCost >= costFromStart[nextIndex]) { continue; }
+
+      const int heuristics = _map.distance(nextCell, _target);
+      costFromStart[nextIndex] = newCost;
+      shortestPathTree[nextIndex] = currentIndex;
+      open.put(nextIndex, newCost + heuristics, newCost);
+      if (newCost + heuristics <= focalBound) { putFocal(nextIndex, heuristics, newCost); }
+    }
+
+    // the lowest f may have increased : open cells within the new bound join the focal list
+    if (!open.empty())
+    {
+      const int newFocalBound = focalBoundOf(open.topPriority());
+      if (newFocalBound > focalBound)
+      {
+        open.visitUpTo(newFocalBound, [&](const int index) {
+          if (!focal.contains(index))
+          {
+            putFocal(index, _map.distance(_map.indexToCoordinates(index), _target), costFromStart[index]);
+          }
+        });
+        focalBound = newFocalBound;
+      }
+    }
+    collector.openListSize(open.size());
+  }
+  collector.allocated(shortestPathTree.capacity()*sizeof(int) + costFromStart.capacity()*sizeof(int) +
+                      expanded.capacity()/8 + open.bytesAllocated() + focal.bytesAllocated());
+
+  if (!foundTarget)
+  {
+    shortestPathTree.clear();
+  }
+  return shortestPathTree;
+}
+
+int FocalPathfinder::convertToOutput(const vector<int>& shortestPathTree) const
+{
+  // same backtracking as Pathfinder::convertToOutput()
+  if (shortestPathTree.empty())
+  {
+    return -1;
+  }
+  const int startIndex  = _map.coordinatesToIndex(_start);
+  const int targetIndex = _map.coordinatesToIndex(_target);
+  int length = 0;
+  for (int currentIndex = targetIndex; currentIndex != startIndex; currentIndex = shortestPathTree[currentIndex])
+  {
+    ++length;
+  }
+  if (length <= _outBufferSize)
+  {
+    int currentIndex = targetIndex;
+    for (int cursor = length - 1; currentIndex != startIndex; --cursor)
+    {
+      _outBuffer[cursor] = currentIndex;
+      currentIndex = shortestPathTree[currentIndex];
+    }
+  }
+  return length;
+}
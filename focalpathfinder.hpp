@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include "preparedmap.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Focal search
+// ############################################################################
+
+// FocalPathfinder implements focal search (A*epsilon, Pearl and Kim, 1982) : the open list is
+// ordered by f = g + h as in A*, and the "focal" list holds the open cells with
+// f <= (1 + epsilon) * lowest f. The next cell to expand is the best focal cell according to
+// a secondary heuristics, which does not need to be admissible : the returned path is always
+// at most (1 + epsilon) times longer than the shortest one.
+
+/*! \brief Order of the cells in the focal list */
+enum class FocalHeuristic
+{
+  DistanceToGo,  //!< closest to Target first (distance without obstacle), then closest to Start (default)
+  Deepest        //!< highest cost from Start first : depth-first inside the focal list
+};
+
+/*! \brief Suboptimality and secondary heuristics of a focal search */
+struct FocalOptions
+{
+  double epsilon = 0.2;  //!< the path is at most (1 + epsilon) times the shortest one, 0 for A*
+  FocalHeuristic heuristic = FocalHeuristic::DistanceToGo;
+};
+
+/*! \brief Bounded-suboptimal search : same contract as FindPath(), but the returned path may be
+ *         up to (1 + options.epsilon) times longer than the shortest one.
+ *
+ *  ex: FocalOptions options;
+ *      options.epsilon = 0.1;
+ *      FocalPathfinder pathfinder(0, 0, 99, 99, pMap, 100, 100, pOutBuffer, nOutBufferSize, options);
+ *      int length = pathfinder.findPath();
+ */
+class FocalPathfinder
+{
+  public:
+  /*! \throw BadInputException on the same inputs as FindPath() */
+  FocalPathfinder(const int nStartX, const int nStartY,
+                  const int nTargetX, const int nTargetY,
+                  const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                  int* pOutBuffer, const int nOutBufferSize,
+                  const FocalOptions& options = FocalOptions());
+  /*! \brief Search on a PreparedMap, using its preprocessed arrays
+   *  \throw BadInputException on the same inputs as PreparedMap::findPath()
+   */
+  FocalPathfinder(const int nStartX, const int nStartY,
+                  const int nTargetX, const int nTargetY,
+                  const PreparedMap& preparedMap,
+                  int* pOutBuffer, const int nOutBufferSize,
+                  const FocalOptions& options = FocalOptions());
+
+  /*! \brief Find a bounded-suboptimal path and fill the output buffer.
+   *
+   *  \return length of the path, or -1 if none can be found.
+   */
+  int findPath(SearchStats* pStats = nullptr);
+
+  private:
+  template<class Collector>
+  int search(Collector& collector);
+  template<class Collector>
+  const vector<int> focalSearch(Collector& collector);
+  int convertToOutput(const vector<int>& shortestPathTree) const;
+
+  Coordinates _start, _target;
+  QueryMap _map;
+  int* _outBuffer;
+  int _outBufferSize;
+  FocalOptions _options;
+};
@@ -0,0 +1,167 @@
+#include "frontierpathfinder.hpp"
+#include <algorithm>
+#include <climits>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+FrontierPathfinder::FrontierPathfinder(const int nStartX, const int nStartY,
+                                       const int nTargetX, const int nTargetY,
+                                       const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                       int* pOutBuffer, const int nOutBufferSize):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(pMap, nMapWidth, nMapHeight),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _peakBytes(0)
+{
+  throwIfBadInput(checkMapInput(nMapWidth, nMapHeight));
+  throwIfBadInput(_map.checkQuery(_start, _target, nOutBufferSize));
+}
+
+FrontierPathfinder::FrontierPathfinder(const int nStartX, const int nStartY,
+                                       const int nTargetX, const int nTargetY,
+                                       const PreparedMap& preparedMap,
+                                       int* pOutBuffer, const int nOutBufferSize):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(preparedMap),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _peakBytes(0)
+{
+  throwIfBadInput(_map.checkQuery(_start, _target, nOutBufferSize));
+}
+
+int FrontierPathfinder::findPath(SearchStats* pStats)
+{
+  if (pStats == nullptr)
+  {
+    NoStatsCollector collector;
+    return search(collector);
+  }
+  StatsCollector collector(*pStats);
+  return search(collector);
+}
+
+template<class Collector>
+int FrontierPathfinder::search(Collector& collector)
+{
+  // Easy case : Target and Start are the same location
+  if (_start == _target) { return 0; }
+
+  // Easy case : Target and Start are not in the same connected component, there is no path
+  if (!_map.mayConnect(_start, _target))
+  {
+    return -1;
+  }
+
+  collector.startSearch();
+  _peakBytes = 0;
+  const int heuristic = _map.distance(_start, _target);
+  int bound = heuristic;
+  int length = -1;
+  while (true)
+  {
+    int relayCell, lowestPrunedF;
+    length = boundedSearch(collector, _start, _target, bound, 0, &relayCell, &lowestPrunedF);
+    // nothing pruned : every cell reachable from Start was reached
+    if (length >= 0 || lowestPrunedF == INT_MAX) { break; }
+    // each search costs more than the previous ones : a slack at least doubling keeps their sum within a factor
+    bound = max(lowestPrunedF, heuristic + 2 * (bound - heuristic));
+  }
+  collector.endSearch();
+
+  collector.startOutput();
+  if (length > 0 && length <= _outBufferSize) { recoverPath(collector, _start, _target, length, _outBuffer); }
+  collector.endOutput();
+  collector.allocated(_peakBytes);
+  return length;
+}
+
+/*! \brief Breadth-first search from 'from', pruning the cells whose f exceeds the bound.
+ *
+ *  \param relayDepth      depth of the relay layer, 0 for none
+ *  \param pRelayCell      set to the ancestor of 'to' in the relay layer
+ *  \param pLowestPrunedF  set to the lowest f of the pruned cells, INT_MAX if none
+ *  \return depth of 'to', -1 if it was not reached
+ */
+template<class Collector>
+int FrontierPathfinder::boundedSearch(Collector& collector, const Coordinates& from, const Coordinates& to,
+                                      const int bound, const int relayDepth, int* pRelayCell, int* pLowestPrunedF)
+{
+  const int toIndex = _map.coordinatesToIndex(to);
+  *pLowestPrunedF = INT_MAX;
+  _previous.clear();
+  _current.assign(1, LayerNode{_map.coordinatesToIndex(from), -1});
+  for (int depth = 1; !_current.empty(); ++depth)
+  {
+    // neighbors of the current layer within the bound, each with the relay of its parent
+    _next.clear();
+    for (const LayerNode& node : _current)
+    {
+      collector.expanded();
+      Coordinates neighbors[4];
+      const int nbNeighbors = _map.findNeighbors(_map.indexToCoordinates(node.cell), neighbors);
+      for (int i = 0; i < nbNeighbors; ++i)
+      {
+        collector.generated();
+        const int f = depth + _map.distance(neighbors[i], to);
+        if (f > bound)
+        {
+          *pLowestPrunedF = min(*pLowestPrunedF, f);
+          continue;
+        }
+        _next.push_back(LayerNode{_map.coordinatesToIndex(neighbors[i]), node.relay});
+      }
+    }
+
+    // sorted by cell : duplicates are adjacent, and the cells of the previous layer (sorted too)
+    // are removed by walking it along. A grid is bipartite : none is in the current layer
+    sort(_next.begin(), _next.end());
+    size_t kept = 0;
+    auto previous = _previous.begin();
+    for (size_t i = 0; i < _next.size(); ++i)
+    {
+      const int cell = _next[i].cell;
+      if (kept > 0 && _next[kept-1].cell == cell) { continue; }
+      while (previous != _previous.end() && previous->cell < cell) { ++previous; }
+      if (previous != _previous.end() && previous->cell == cell) { continue; }
+      _next[kept++] = _next[i];
+    }
+    _next.resize(kept);
+    if (depth == relayDepth)
+    {
+      for (LayerNode& node : _next) { node.relay = node.cell; }
+    }
+    collector.openListSize(_current.size() + _next.size());
+    _peakBytes = max(_peakBytes, (_previous.capacity() + _current.capacity() + _next.capacity()) * sizeof(LayerNode));
+
+    const auto found = lower_bound(_next.begin(), _next.end(), LayerNode{toIndex, -1});
+    if (found != _next.end() && found->cell == toIndex)
+    {
+      *pRelayCell = found->relay;
+      return depth;
+    }
+    _previous.swap(_current);
+    _current.swap(_next);
+  }
+  return -1;
+}
+
+/*! \brief Fill pOut with the cells of a shortest path from 'from' to 'to', whose length is known, but 'from' */
+template<class Collector>
+void FrontierPathfinder::recoverPath(Collector& collector, const Coordinates& from, const Coordinates& to,
+                                     const int length, int* pOut)
+{
+  if (length == 1)
+  {
+    pOut[0] = _map.coordinatesToIndex(to);
+    return;
+  }
+  // bounded by the length : only the cells on shortest paths are searched
+  const int relayDepth = length / 2;
+  int relayCell, lowestPrunedF;
+  boundedSearch(collector, from, to, length, relayDepth, &relayCell, &lowestPrunedF);
+  const Coordinates relay = _map.indexToCoordinates(relayCell);
+  recoverPath(collector, from, relay, relayDepth, pOut);
+  recoverPath(collector, relay, to, length - relayDepth, pOut + relayDepth);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include "preparedmap.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Frontier search
+// ############################################################################
+
+// On long queries over large open maps, most of the memory of A* holds cells it has settled,
+// kept only to detect duplicates and to backtrack the path. FrontierPathfinder implements a
+// breadth-first heuristic search (Zhou and Hansen, 2006) : a breadth-first search which prunes
+// the cells whose f = g + h exceeds an upper bound U, and keeps only three layers - the previous
+// one, the current one and the next one. On a grid, the neighbors of a layer are in the layer
+// before or the layer after : no other duplicate detection is needed, and memory follows the
+// width of the frontier, not the explored area.
+// The first bound is the heuristic of Start, which is raised each time the search fails - up to
+// the lowest pruned f, and at least doubling the slack above the heuristic - until Target is
+// reached : breadth-first, it is reached at its shortest distance, whatever the bound.
+// Without the closed cells, the path is recovered by divide and conquer : each cell of the
+// frontier remembers its ancestor in the middle layer - the relay - and the two halves of the
+// path, Start to relay and relay to Target, are found by searches bounded by their known lengths.
+// It costs about as much again as the search itself, for a recursion log2(length) deep.
+
+/*! \brief Shortest path with memory proportional to the search frontier.
+ *
+ *  Same contract as FindPath().
+ *  ex: FrontierPathfinder pathfinder(0, 0, 99, 99, pMap, 100, 100, pOutBuffer, nOutBufferSize);
+ *      int length = pathfinder.findPath();
+ */
+class FrontierPathfinder
+{
+  public:
+  /*! \throw BadInputException on the same inputs as FindPath() */
+  FrontierPathfinder(const int nStartX, const int nStartY,
+                     const int nTargetX, const int nTargetY,
+                     const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                     int* pOutBuffer, const int nOutBufferSize);
+  /*! \brief Search on a PreparedMap, using its preprocessed arrays
+   *  \throw BadInputException on the same inputs as PreparedMap::findPath()
+   */
+  FrontierPathfinder(const int nStartX, const int nStartY,
+                     const int nTargetX, const int nTargetY,
+                     const PreparedMap& preparedMap,
+                     int* pOutBuffer, const int nOutBufferSize);
+
+  /*! \brief Find the shortest path and fill the output buffer.
+   *
+   *  \return length of the shortest path, or -1 if none can be found.
+   */
+  int findPath(SearchStats* pStats = nullptr);
+
+  private:
+  /*! \brief A cell of a layer, and its ancestor in the relay layer (-1 before it) */
+  struct LayerNode
+  {
+    int cell;
+    int relay;
+    bool operator<(const LayerNode& other) const { return cell < other.cell; }
+  };
+
+  template<class Collector>
+  int search(Collector& collector);
+  template<class Collector>
+  int boundedSearch(Collector& collector, const Coordinates& from, const Coordinates& to,
+                    const int bound, const int relayDepth, int* pRelayCell, int* pLowestPrunedF);
+  template<class Collector>
+  void recoverPath(Collector& collector, const Coordinates& from, const Coordinates& to, const int length, int* pOut);
+
+  Coordinates _start, _target;
+  QueryMap _map;
+  int* _outBuffer;
+  int _outBufferSize;
+
+  // the three layers, kept between searches to reuse their memory
+  vector<LayerNode> _previous, _current, _next;
+  size_t _peakBytes;
+};
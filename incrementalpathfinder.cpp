@@ -0,0 +1,149 @@
+#include "incrementalpathfinder.hpp"
+#include <algorithm>
+#include <climits>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+IncrementalPathfinder::IncrementalPathfinder(const int nStartX, const int nStartY,
+                                             const int nTargetX, const int nTargetY,
+                                             const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                             int* pOutBuffer, const int nOutBufferSize,
+                                             const TieBreak tieBreak):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(pMap, nMapWidth, nMapHeight),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _openList(0, tieBreak),
+  _status(StepStatus::InProgress), _length(-1), _nodesExpanded(0), _closestDistance(INT_MAX)
+{
+  throwIfBadInput(checkMapInput(nMapWidth, nMapHeight));
+  throwIfBadInput(_map.checkQuery(_start, _target, nOutBufferSize));
+  init(tieBreak);
+}
+
+IncrementalPathfinder::IncrementalPathfinder(const int nStartX, const int nStartY,
+                                             const int nTargetX, const int nTargetY,
+                                             const PreparedMap& preparedMap,
+                                             int* pOutBuffer, const int nOutBufferSize,
+                                             const TieBreak tieBreak):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(preparedMap),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _openList(0, tieBreak),
+  _status(StepStatus::InProgress), _length(-1), _nodesExpanded(0), _closestDistance(INT_MAX)
+{
+  throwIfBadInput(_map.checkQuery(_start, _target, nOutBufferSize));
+  init(tieBreak);
+}
+
+void IncrementalPathfinder::init(const TieBreak tieBreak)
+{
+  // Easy case : Target and Start are the same location
+  if (_start == _target)
+  {
+    _status = StepStatus::Found;
+    _length = 0;
+    _closestDistance = 0;
+    return;
+  }
+
+  // Easy case : Target and Start are not in the same connected component, there is no path
+  if (!_map.mayConnect(_start, _target))
+  {
+    _status = StepStatus::NoPath;
+    return;
+  }
+
+  // same initial state as Pathfinder::Astar()
+  const int mapSize = _map.cellCount();
+  _shortestPathTree.assign(mapSize, -1);
+  _costFromStart.assign(mapSize, INT_MAX);
+  _closed.assign(mapSize, false);
+  _openList = IndexedHeap(mapSize, tieBreak);
+
+  const int startIndex = _map.coordinatesToIndex(_start);
+  _costFromStart[startIndex] = 0;
+  _openList.put(startIndex, 0, 0);
+}
+
+StepStatus IncrementalPathfinder::step(const int maxExpansions)
+{
+  if (_status != StepStatus::InProgress) { return _status; }
+
+  const int targetIndex = _map.coordinatesToIndex(_target);
+  int budget = max(1, maxExpansions);
+  while (budget > 0)
+  {
+    if (_openList.empty())
+    {
+      finish(false);
+      return _status;
+    }
+    const int currentIndex = _openList.dequeue();
+
+    // early exit - as soon as we found a path to the target
+    if (currentIndex == targetIndex)
+    {
+      finish(true);
+      return _status;
+    }
+    _closed[currentIndex] = true;
+    ++_nodesExpanded;
+    --budget;
+
+    // Loop on possible adjacent cells, as Pathfinder::Astar()
+    const Coordinates currentCell = _map.indexToCoordinates(currentIndex);
+    _closestDistance = min(_closestDistance, _map.distance(currentCell, _target));
+    const int newCost = _costFromStart[currentIndex] + 1;
+    Coordinates neighbors[4];
+    const int nbNeighbors = _map.findNeighbors(currentCell, neighbors);
+    for (int i = 0; i < nbNeighbors; ++i)
+    {
+      const Coordinates& nextCell = neighbors[i];
+      const int nextIndex = _map.coordinatesToIndex(nextCell);
+      if (_closed[nextIndex]) { continue; }
+      if (newCost < _costFromStart[nextIndex])
+      {
+        _openList.put(nextIndex, newCost + _map.distance(nextCell, _target), newCost);
+        _costFromStart[nextIndex] = newCost;
+        _shortestPathTree[nextIndex] = currentIndex;
+      }
+    }
+  }
+  return _status;
+}
+
+void IncrementalPathfinder::finish(const bool foundTarget)
+{
+  if (foundTarget)
+  {
+    // backtrack from the target to the start, as Pathfinder::convertToOutput()
+    const int startIndex  = _map.coordinatesToIndex(_start);
+    const int targetIndex = _map.coordinatesToIndex(_target);
+    _length = _costFromStart[targetIndex];
+    if (_length <= _outBufferSize)
+    {
+      int currentIndex = targetIndex;
+      for (int cursor = _length - 1; currentIndex != startIndex; --cursor)
+      {
+        _outBuffer[cursor] = currentIndex;
+        currentIndex = _shortestPathTree[currentIndex];
+      }
+    }
+    _closestDistance = 0;
+  }
+  _status = foundTarget ? StepStatus::Found : StepStatus::NoPath;
+
+  // the search is over : release its state
+  vector<int>().swap(_shortestPathTree);
+  vector<int>().swap(_costFromStart);
+  vector<bool>().swap(_closed);
+  _openList = IndexedHeap(0);
+}
+
+size_t IncrementalPathfinder::bytesAllocated() const
+{
+  return _shortestPathTree.capacity()*sizeof(int) + _costFromStart.capacity()*sizeof(int) +
+         _closed.capacity()/8 + _openList.bytesAllocated();
+}
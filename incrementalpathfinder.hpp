@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include "preparedmap.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Incremental search
+// ############################################################################
+
+// IncrementalPathfinder runs the same A* as FindPath(), but in slices : each call to step()
+// expands at most a given number of cells, and the open list, closed bitmap and shortest path
+// tree are kept until the next call. A caller with a frame budget can thus spread one search
+// over several frames.
+
+/*! \brief State of an incremental search, returned by IncrementalPathfinder::step() */
+enum class StepStatus
+{
+  InProgress,  //!< the budget was spent before the end of the search : call step() again
+  Found,       //!< the shortest path was found, and written in the output buffer if it fits
+  NoPath       //!< Target cannot be reached from Start
+};
+
+/*! \brief A* search which can be interrupted and resumed.
+ *
+ *  The map (or the PreparedMap) and the output buffer must outlive the search.
+ *  Same result and same output format as FindPath().
+ *  ex: IncrementalPathfinder search(0, 0, 99, 99, pMap, 100, 100, pOutBuffer, nOutBufferSize);
+ *      while (search.step(1000) == StepStatus::InProgress) { ...next frame... }
+ *      int length = search.length();
+ */
+class IncrementalPathfinder
+{
+  public:
+  /*! \throw BadInputException on the same inputs as FindPath() */
+  IncrementalPathfinder(const int nStartX, const int nStartY,
+                        const int nTargetX, const int nTargetY,
+                        const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                        int* pOutBuffer, const int nOutBufferSize,
+                        const TieBreak tieBreak = TieBreak::HigherG);
+  /*! \brief Search on a PreparedMap, using its preprocessed arrays
+   *  \throw BadInputException on the same inputs as PreparedMap::findPath()
+   */
+  IncrementalPathfinder(const int nStartX, const int nStartY,
+                        const int nTargetX, const int nTargetY,
+                        const PreparedMap& preparedMap,
+                        int* pOutBuffer, const int nOutBufferSize,
+                        const TieBreak tieBreak = TieBreak::HigherG);
+
+  /*! \brief Expand at most maxExpansions cells (at least 1), or nothing if the search is over.
+   *
+   *  When the result is Found, the output buffer has been filled as by FindPath().
+   */
+  StepStatus step(const int maxExpansions);
+
+  StepStatus status() const { return _status; }
+  /*! \brief Length of the shortest path once Found, -1 otherwise */
+  int length() const { return _length; }
+
+  /*! \brief Progress : cells expanded so far, by all the steps */
+  long long nodesExpanded() const { return _nodesExpanded; }
+  /*! \brief Progress : cells waiting in the open list */
+  size_t openListSize() const { return _openList.size(); }
+  /*! \brief Progress : lowest distance without obstacle to Target among the expanded cells */
+  int closestDistance() const { return _closestDistance; }
+
+  /*! \brief Memory held by the search state between steps */
+  size_t bytesAllocated() const;
+
+  private:
+  void init(const TieBreak tieBreak);
+  void finish(const bool foundTarget);
+
+  Coordinates _start, _target;
+  QueryMap _map;
+  int* _outBuffer;
+  int _outBufferSize;
+
+  // search state, kept between steps - same arrays as Pathfinder::Astar()
+  vector<int> _shortestPathTree;
+  vector<int> _costFromStart;
+  vector<bool> _closed;
+  IndexedHeap _openList;
+
+  StepStatus _status;
+  int _length;
+  long long _nodesExpanded;
+  int _closestDistance;
+};
@@ -0,0 +1,197 @@
+#include "largemap.hpp"
+#include "compressedmap.hpp"
+#include "sparsesearchstate.hpp"
+#include <algorithm>
+#include <queue>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+LargeMap LargeMap::bytes(const unsigned char* pMap, const int nMapWidth, const int nMapHeight)
+{
+  return LargeMap(pMap, nullptr, nullptr, nMapWidth, nMapHeight);
+}
+
+LargeMap LargeMap::bitPacked(const uint64_t* pBits, const int nMapWidth, const int nMapHeight)
+{
+  return LargeMap(nullptr, pBits, nullptr, nMapWidth, nMapHeight);
+}
+
+LargeMap LargeMap::compressed(TileCache& cache)
+{
+  return LargeMap(nullptr, nullptr, &cache, cache.map().width(), cache.map().height());
+}
+
+bool LargeMap::isCellOutOfBounds(const Coordinates& coordCell) const
+{
+  return (coordCell.X < 0 || coordCell.X >= _mapWidth ||
+          coordCell.Y < 0 || coordCell.Y >= _mapHeight);
+}
+
+bool LargeMap::isCellOk(const Coordinates& coordCell) const
+{
+  if (isCellOutOfBounds(coordCell)) { return false; }
+  const int64_t index = coordinatesToIndex(coordCell);
+  if (_pBytes != nullptr) { return _pBytes[index] != 0; }
+  if (_pBits != nullptr)  { return (_pBits[index >> 6] >> (index & 63)) & 1; }
+  return _pTiles->isCellOk(coordCell);
+}
+
+int LargeMap::findNeighbors(const Coordinates& cell, Coordinates outputNeighbors[4]) const
+{
+  int nbNeighbors = 0;
+  const Coordinates candidates[4] = {Coordinates(cell.X, cell.Y-1), Coordinates(cell.X, cell.Y+1),
+                                     Coordinates(cell.X-1, cell.Y), Coordinates(cell.X+1, cell.Y)};
+  for (const Coordinates& candidate : candidates)
+  {
+    if (isCellOk(candidate)) { outputNeighbors[nbNeighbors++] = candidate; }
+  }
+  return nbNeighbors;
+}
+
+// Open list entry : the open list is lazy, a node reached again by a shorter path is queued again,
+// and the stale entries - whose cost is not the node's any more - are skipped when dequeued.
+// Priorities do not fit in an int : this is not Pathfinder's IndexedHeap.
+struct LargeOpenNode
+{
+  int64_t priority;
+  int64_t costFromStart;
+  int64_t node;
+};
+
+// lowest priority first, then highest cost from Start, as TieBreak::HigherG
+struct LargeOpenNodeLater
+{
+  bool operator()(const LargeOpenNode& lhs, const LargeOpenNode& rhs) const
+  {
+    if (lhs.priority != rhs.priority) { return lhs.priority > rhs.priority; }
+    return lhs.costFromStart < rhs.costFromStart;
+  }
+};
+
+template<class Collector>
+static int64_t largeAstar(const Coordinates& start, const Coordinates& target, const LargeMap& map,
+                          int64_t* pOutBuffer, const int64_t nOutBufferSize, Collector& collector)
+{
+  if (start == target) { return 0; }
+
+  Arena* arena = Arena::current();
+  LargeSparseSearchState state(0, arena);
+  priority_queue<LargeOpenNode, ArenaVector<LargeOpenNode>, LargeOpenNodeLater>
+    q{LargeOpenNodeLater(), ArenaVector<LargeOpenNode>(ArenaAllocator<LargeOpenNode>(arena))};
+  const int64_t targetIndex = map.coordinatesToIndex(target);
+
+  collector.startSearch();
+  q.push(LargeOpenNode{map.distance(start, target), 0, state.insert(map.coordinatesToIndex(start), 0, -1)});
+  size_t peakOpenListSize = q.size();
+  collector.openListSize(q.size());
+  int64_t targetNode = -1;
+  while (!q.empty())
+  {
+    const LargeOpenNode current = q.top();
+    q.pop();
+    if (current.costFromStart != state.node(current.node).costFromStart) { continue; }  // stale
+    const int64_t currentIndex = state.node(current.node).cell;
+    if (currentIndex == targetIndex)
+    {
+      targetNode = current.node;
+      break;
+    }
+    collector.expanded();
+
+    // the heuristics is consistent : an expanded node is never reached again by a shorter path
+    const Coordinates currentCell = map.indexToCoordinates(currentIndex);
+    const int64_t newCost = current.costFromStart + 1;
+    Coordinates neighbors[4];
+    const int nbNeighbors = map.findNeighbors(currentCell, neighbors);
+    for (int i = 0; i < nbNeighbors; ++i)
+    {
+      const int64_t nextIndex = map.coordinatesToIndex(neighbors[i]);
+      collector.generated();
+      int64_t nextNode = state.find(nextIndex);
+      if (nextNode < 0)
+      {
+        nextNode = state.insert(nextIndex, newCost, current.node);
+      }
+      else if (newCost < state.node(nextNode).costFromStart)
+      {
+        state.node(nextNode).costFromStart = newCost;
+        state.node(nextNode).parent = current.node;
+      }
+      else
+      {
+        continue;
+      }
+      q.push(LargeOpenNode{newCost + map.distance(neighbors[i], target), newCost, nextNode});
+    }
+    peakOpenListSize = max(peakOpenListSize, q.size());
+    collector.openListSize(q.size());
+  }
+  collector.allocated(state.bytesAllocated() + peakOpenListSize*sizeof(LargeOpenNode));
+  collector.endSearch();
+
+  if (targetNode < 0) { return -1; }
+
+  // backtrack through the parent nodes, as Pathfinder::convertNodesToOutput()
+  collector.startOutput();
+  const int64_t length = state.node(targetNode).costFromStart;
+  if (length <= nOutBufferSize)
+  {
+    int64_t node = targetNode;
+    for (int64_t cursor = length - 1; cursor >= 0; --cursor)
+    {
+      pOutBuffer[cursor] = state.node(node).cell;
+      node = state.node(node).parent;
+    }
+  }
+  collector.endOutput();
+  return length;
+}
+
+template<class Collector>
+static int64_t largeSearch(const Coordinates& start, const Coordinates& target, const LargeMap& map,
+                           int64_t* pOutBuffer, const int64_t nOutBufferSize, Collector& collector)
+{
+  // inside an ArenaScope, the search state is taken from its arena, as Pathfinder's
+  Arena* arena = Arena::current();
+  if (arena != nullptr)
+  {
+    ArenaScope queryScope(*arena);
+    return largeAstar(start, target, map, pOutBuffer, nOutBufferSize, collector);
+  }
+  return largeAstar(start, target, map, pOutBuffer, nOutBufferSize, collector);
+}
+
+FindPathStatus checkLargeInput(const int nStartX, const int nStartY,
+                               const int nTargetX, const int nTargetY,
+                               const LargeMap& map, const int64_t nOutBufferSize) noexcept
+{
+  // same checks as FindPath(), but for the number of cells
+  if (map.width() < 1)  { return FindPathStatus::MapWidthTooSmall; }
+  if (map.height() < 1) { return FindPathStatus::MapHeightTooSmall; }
+  const FindPathStatus status = checkQueryInput(nStartX, nStartY, nTargetX, nTargetY, map.width(), map.height(),
+                                                (nOutBufferSize < 0) ? -1 : 0);
+  if (status != FindPathStatus::Ok) { return status; }
+  if (!map.isCellOk(Coordinates(nStartX, nStartY)))   { return FindPathStatus::StartNotPassable; }
+  if (!map.isCellOk(Coordinates(nTargetX, nTargetY))) { return FindPathStatus::TargetNotPassable; }
+  return FindPathStatus::Ok;
+}
+
+int64_t FindPathLarge(const int nStartX, const int nStartY,
+                      const int nTargetX, const int nTargetY,
+                      const LargeMap& map,
+                      int64_t* pOutBuffer, const int64_t nOutBufferSize,
+                      SearchStats* pStats)
+{
+  throwIfBadInput(checkLargeInput(nStartX, nStartY, nTargetX, nTargetY, map, nOutBufferSize));
+  const Coordinates start(nStartX, nStartY), target(nTargetX, nTargetY);
+
+  if (pStats == nullptr)
+  {
+    NoStatsCollector collector;
+    return largeSearch(start, target, map, pOutBuffer, nOutBufferSize, collector);
+  }
+  StatsCollector collector(*pStats);
+  return largeSearch(start, target, map, pOutBuffer, nOutBufferSize, collector);
+}
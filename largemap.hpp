@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include "pathfinder.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Large maps
+// ############################################################################
+
+// FindPath() indexes cells with ints : its maps are limited to INT_MAX cells, about
+// 46k x 46k (FindPathStatus::MapTooLarge beyond). FindPathLarge() answers the same queries
+// with 64-bit cell indexes, costs and output, on a LargeMap : one byte per cell as FindPath(),
+// or one bit per cell, 8 times smaller (256 MB for 2^31 cells).
+// A dense search state would take tens of GB on such maps : the search only stores the cells
+// it reaches, in a LargeSparseSearchState, whose node numbers are 64-bit too. Smaller maps keep the 32-bit FindPath(), whose
+// indexes and state are twice smaller.
+// A CompressedMap is searched through the TileCache of the thread : LargeMap::compressed().
+
+class TileCache;
+
+/*! \brief Read-only view of a map of up to (2^31-1) x (2^31-1) cells, not copied.
+ *
+ *  ex: vector<uint64_t> bits((width*height + 63) / 64);  // bit i of the map is bit (i & 63) of bits[i >> 6]
+ *      const LargeMap map = LargeMap::bitPacked(bits.data(), width, height);
+ */
+class LargeMap
+{
+  public:
+  /*! \brief One byte per cell, row-major, 0 for impassable cells as in FindPath() */
+  static LargeMap bytes(const unsigned char* pMap, const int nMapWidth, const int nMapHeight);
+  /*! \brief One bit per cell, row-major, set for passable cells */
+  static LargeMap bitPacked(const uint64_t* pBits, const int nMapWidth, const int nMapHeight);
+  /*! \brief Compressed by tiles, decompressed on demand in the cache, which must outlive the LargeMap */
+  static LargeMap compressed(TileCache& cache);
+
+  int width() const { return _mapWidth; }
+  int height() const { return _mapHeight; }
+  int64_t cellCount() const { return (int64_t)_mapWidth * _mapHeight; }
+
+  bool isCellOutOfBounds(const Coordinates& coordCell) const;
+  bool isCellOk(const Coordinates& coordCell) const;
+  /*! \brief Same neighbors and order as Map::findNeighbors() */
+  int findNeighbors(const Coordinates& cell, Coordinates outputNeighbors[4]) const;
+
+  int64_t coordinatesToIndex(const Coordinates& coordinates) const { return (int64_t)coordinates.Y * _mapWidth + coordinates.X; }
+  const Coordinates indexToCoordinates(const int64_t index) const
+  {
+    return Coordinates((int)(index % _mapWidth), (int)(index / _mapWidth));
+  }
+  int64_t distance(const Coordinates& cellA, const Coordinates& cellB) const
+  {
+    return llabs((int64_t)cellA.X - cellB.X) + llabs((int64_t)cellA.Y - cellB.Y);
+  }
+
+  private:
+  LargeMap(const unsigned char* pBytes, const uint64_t* pBits, TileCache* pTiles, const int nMapWidth, const int nMapHeight):
+    _pBytes(pBytes), _pBits(pBits), _pTiles(pTiles), _mapWidth(nMapWidth), _mapHeight(nMapHeight) {}
+
+  // one of them is not nullptr
+  const unsigned char* _pBytes;
+  const uint64_t* _pBits;
+  TileCache* _pTiles;
+  int _mapWidth, _mapHeight;
+};
+
+/*! \brief Input checks of FindPathLarge() and FindPathExternal() : those of FindPath(), except that the map
+ *         may have more than INT_MAX cells
+ */
+FindPathStatus checkLargeInput(const int nStartX, const int nStartY,
+                               const int nTargetX, const int nTargetY,
+                               const LargeMap& map, const int64_t nOutBufferSize) noexcept;
+
+/*! \brief Same contract as FindPath(), with 64-bit cell indexes in the output buffer.
+ *
+ *  \return length of the shortest path, or -1 if none can be found.
+ *  \throw BadInputException on the same inputs as FindPath(), except that the map may have
+ *         more than INT_MAX cells
+ */
+int64_t FindPathLarge(const int nStartX, const int nStartY,
+                      const int nTargetX, const int nTargetY,
+                      const LargeMap& map,
+                      int64_t* pOutBuffer, const int64_t nOutBufferSize,
+                      SearchStats* pStats = nullptr);
@@ -0,0 +1,313 @@
+#include "mappedmap.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PATHFINDER_HAS_MMAP 1
+#elif defined(_WIN32)
+#include <process.h>
+#endif
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+static const char MAGIC[8] = {'P', 'F', 'M', 'A', 'P', '\r', '\n', '\x1a'};
+static const uint32_t VERSION = 2;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+static const uint64_t SECTION_ALIGNMENT = 4096;
+
+enum Section { CELLS, PADDED, PACKED, COMPONENTS, NEIGHBOR_MASKS, NB_SECTIONS };
+
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrderMark;
+  int32_t width, height;
+  uint32_t options;
+  uint32_t reserved;
+  uint64_t fingerprint;
+  struct { uint64_t offset, size, checksum; } sections[NB_SECTIONS];
+  unsigned char padding[256 - 40 - NB_SECTIONS*24];
+};
+static_assert(sizeof(FileHeader) == 256, "the header is part of the file format");
+
+// 64-bit multiplicative hash of 8 bytes at a time : the checksum of a section reads it at memory speed
+static uint64_t checksum(const unsigned char* data, const uint64_t size, uint64_t hash = 0xCBF29CE484222325ull)
+{
+  uint64_t position = 0;
+  for (; position + 8 <= size; position += 8)
+  {
+    uint64_t word;
+    memcpy(&word, data + position, 8);
+    hash = (hash ^ word) * 0x100000001B3ull;
+    hash ^= hash >> 29;
+  }
+  for (; position < size; ++position)
+  {
+    hash = (hash ^ data[position]) * 0x100000001B3ull;
+  }
+  return hash ^ (hash >> 32);
+}
+
+static uint32_t optionBits(const PrepareOptions& options)
+{
+  return (options.padding ? 1u : 0u) | (options.bitPacking ? 2u : 0u) | (options.components ? 4u : 0u) |
+         (options.neighborMasks ? 8u : 0u) | (options.tiledLayout ? 16u : 0u);
+}
+
+static PrepareOptions optionsFromBits(const uint32_t bits)
+{
+  PrepareOptions options;
+  options.padding       = (bits & 1) != 0;
+  options.bitPacking    = (bits & 2) != 0;
+  options.components    = (bits & 4) != 0;
+  options.neighborMasks = (bits & 8) != 0;
+  options.tiledLayout   = (bits & 16) != 0;
+  return options;
+}
+
+// Size of each section for a map and its options : the reader checks the file against them
+static void sectionSizes(const int width, const int height, const PrepareOptions& options, const int cellCount,
+                         uint64_t sizes[NB_SECTIONS])
+{
+  sizes[CELLS]          = (uint64_t)width * height;
+  sizes[PADDED]         = options.padding ? ((uint64_t)width + 2) * ((uint64_t)height + 2) : 0;
+  sizes[PACKED]         = options.bitPacking ? ((uint64_t)cellCount + 63) / 64 * sizeof(uint64_t) : 0;
+  sizes[COMPONENTS]     = options.components ? (uint64_t)cellCount * sizeof(int) : 0;
+  sizes[NEIGHBOR_MASKS] = options.neighborMasks ? (uint64_t)cellCount : 0;
+}
+
+static BadInputException fileError(const string& path, const char* reason)
+{
+  return BadInputException("in MappedMap, " + path + " " + reason + ".\n");
+}
+
+uint64_t mapFingerprint(const unsigned char* pMap, const int nMapWidth, const int nMapHeight)
+{
+  const uint64_t size = (uint64_t)nMapWidth << 32 | (uint32_t)nMapHeight;
+  return checksum(pMap, (uint64_t)nMapWidth * nMapHeight, checksum(reinterpret_cast<const unsigned char*>(&size), sizeof(size)));
+}
+
+void savePreparedMap(const PreparedMap& preparedMap, const string& path)
+{
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.byteOrderMark = BYTE_ORDER_MARK;
+  header.width = preparedMap.width();
+  header.height = preparedMap.height();
+  header.options = optionBits(preparedMap.options());
+  // the file holds a packed map : a view of a larger buffer is copied cell by cell, 1 if passable
+  const Map& map = preparedMap.getMap();
+  const unsigned char* pMap = map.view().pOrigin;
+  vector<unsigned char> packedCells;
+  if (!map.view().isPacked())
+  {
+    packedCells.resize((size_t)map.cellCount());
+    for (int index = 0; index < map.cellCount(); ++index)
+    {
+      packedCells[(size_t)index] = map.isCellOk(map.indexToCoordinates(index)) ? 1 : 0;
+    }
+    pMap = packedCells.data();
+  }
+  header.fingerprint = mapFingerprint(pMap, preparedMap.width(), preparedMap.height());
+
+  uint64_t sizes[NB_SECTIONS];
+  sectionSizes(header.width, header.height, preparedMap.options(), preparedMap.cellCount(), sizes);
+  const void* data[NB_SECTIONS] = {pMap, preparedMap._arrays.padded, preparedMap._arrays.packed,
+                                   preparedMap._arrays.components, preparedMap._arrays.neighborMasks};
+  uint64_t offset = SECTION_ALIGNMENT;
+  for (int section = 0; section < NB_SECTIONS; ++section)
+  {
+    if (sizes[section] == 0) { continue; }
+    header.sections[section].offset = offset;
+    header.sections[section].size = sizes[section];
+    header.sections[section].checksum = checksum(static_cast<const unsigned char*>(data[section]), sizes[section]);
+    offset = (offset + sizes[section] + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+  }
+
+  ofstream output(path, ios::binary | ios::trunc);
+  if (!output) { throw fileError(path, "cannot be written"); }
+  output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (int section = 0; section < NB_SECTIONS; ++section)
+  {
+    if (sizes[section] == 0) { continue; }
+    const uint64_t position = (uint64_t)output.tellp();
+    const vector<char> zeros((size_t)(header.sections[section].offset - position), 0);
+    output.write(zeros.data(), (streamsize)zeros.size());
+    output.write(static_cast<const char*>(data[section]), (streamsize)sizes[section]);
+  }
+  if (!output) { throw fileError(path, "cannot be written"); }
+}
+
+MappedMap::MappedMap(const string& path): _data(nullptr), _size(0), _fingerprint(0), _mapped(false)
+{
+#ifdef PATHFINDER_HAS_MMAP
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) { throw fileError(path, "cannot be opened"); }
+  struct stat status;
+  if (fstat(fd, &status) == 0 && status.st_size >= (off_t)sizeof(FileHeader))
+  {
+    // read-only and shared : the pages are the page cache's, shared by every process mapping the file
+    void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data != MAP_FAILED)
+    {
+      _data = static_cast<const unsigned char*>(data);
+      _size = (size_t)status.st_size;
+      _mapped = true;
+    }
+  }
+  close(fd);
+#endif
+  if (!_mapped)
+  {
+    ifstream input(path, ios::binary);
+    if (!input) { throw fileError(path, "cannot be opened"); }
+    _copy.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+    _data = _copy.data();
+    _size = _copy.size();
+  }
+
+  try
+  {
+    FileHeader header;
+    if (_size < sizeof(header)) { throw fileError(path, "is not a prepared map file"); }
+    memcpy(&header, _data, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) { throw fileError(path, "is not a prepared map file"); }
+    if (header.byteOrderMark != BYTE_ORDER_MARK)         { throw fileError(path, "was written with another byte order"); }
+    if (header.version != VERSION)                       { throw fileError(path, "has an unknown version"); }
+    if (checkMapInput(header.width, header.height) != FindPathStatus::Ok) { throw fileError(path, "has a bad map size"); }
+
+    _fingerprint = header.fingerprint;
+    const PrepareOptions options = optionsFromBits(header.options);
+    // the tiled layout rounds the arrays up : a throwaway view gives their size
+    const PreparedMap layout(_data, header.width, header.height, options, PreparedMap::Arrays{nullptr, nullptr, nullptr, nullptr});
+    if (layout.options().tiledLayout != options.tiledLayout || layout.options().padding != options.padding)
+    {
+      throw fileError(path, "has a bad map size");
+    }
+    uint64_t sizes[NB_SECTIONS];
+    sectionSizes(header.width, header.height, options, layout.cellCount(), sizes);
+    const unsigned char* sections[NB_SECTIONS];
+    for (int section = 0; section < NB_SECTIONS; ++section)
+    {
+      const uint64_t offset = header.sections[section].offset;
+      if (header.sections[section].size != sizes[section] || offset % SECTION_ALIGNMENT != 0 ||
+          offset > _size || sizes[section] > _size - offset)
+      {
+        throw fileError(path, "is truncated or corrupted");
+      }
+      sections[section] = (sizes[section] != 0) ? _data + offset : nullptr;
+    }
+    const PreparedMap::Arrays arrays = {sections[PADDED], reinterpret_cast<const uint64_t*>(sections[PACKED]),
+                                        reinterpret_cast<const int*>(sections[COMPONENTS]), sections[NEIGHBOR_MASKS]};
+    _prepared.reset(new PreparedMap(sections[CELLS], header.width, header.height, options, arrays));
+  }
+  catch (...)
+  {
+#ifdef PATHFINDER_HAS_MMAP
+    if (_mapped) { munmap(const_cast<unsigned char*>(_data), _size); }
+#endif
+    throw;
+  }
+}
+
+bool MappedMap::verify() const
+{
+  FileHeader header;
+  memcpy(&header, _data, sizeof(header));
+  for (int section = 0; section < NB_SECTIONS; ++section)
+  {
+    if (header.sections[section].size != 0 &&
+        checksum(_data + header.sections[section].offset, header.sections[section].size) != header.sections[section].checksum)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+MappedMap::~MappedMap()
+{
+  _prepared.reset();
+#ifdef PATHFINDER_HAS_MMAP
+  if (_mapped) { munmap(const_cast<unsigned char*>(_data), _size); }
+#endif
+}
+
+// Name of the file a rebuild is written to, next to the file it replaces : unique per process and per call,
+// so that concurrent rebuilds of the same file, in this process or in others, never write the same file.
+static string buildPath(const string& path)
+{
+  static atomic<unsigned int> nbBuilds(0);
+#if defined(PATHFINDER_HAS_MMAP)
+  const long long processId = getpid();
+#elif defined(_WIN32)
+  const long long processId = _getpid();
+#else
+  const long long processId = 0;
+#endif
+  return path + ".building." + to_string(processId) + "." + to_string(nbBuilds++);
+}
+
+unique_ptr<MappedMap> openOrBuildPreparedMap(const string& path,
+                                             const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                             const PrepareOptions& options, bool* pRebuilt)
+{
+  throwIfBadInput(checkMapInput(nMapWidth, nMapHeight));
+  if (pRebuilt != nullptr) { *pRebuilt = false; }
+  const uint64_t fingerprint = mapFingerprint(pMap, nMapWidth, nMapHeight);
+  // the options the file is built with : a map too large for tiles stays row-major, or for a border is not padded
+  PrepareOptions builtOptions = options;
+  builtOptions.padding = options.padding && PreparedMap::fitsPadding(nMapWidth, nMapHeight);
+  builtOptions.tiledLayout = options.tiledLayout && PreparedMap::fitsTiledLayout(nMapWidth, nMapHeight);
+  // nullptr if the file is missing, stale or corrupted
+  auto openUpToDate = [&]() -> unique_ptr<MappedMap> {
+    try
+    {
+      unique_ptr<MappedMap> mapped(new MappedMap(path));
+      if (mapped->fingerprint() == fingerprint && optionBits(mapped->prepared().options()) == optionBits(builtOptions) &&
+          mapped->verify())
+      {
+        return mapped;
+      }
+    }
+    catch (const BadInputException&)
+    {
+      // missing, older version or corrupted
+    }
+    return nullptr;
+  };
+  unique_ptr<MappedMap> mapped = openUpToDate();
+  if (mapped) { return mapped; }
+
+  // written aside then renamed : a process opening the file meanwhile sees the old one or the new one, never a partial one
+  const string temporaryPath = buildPath(path);
+  try
+  {
+    savePreparedMap(PreparedMap(pMap, nMapWidth, nMapHeight, options), temporaryPath);
+  }
+  catch (...)
+  {
+    remove(temporaryPath.c_str());
+    throw;
+  }
+  if (rename(temporaryPath.c_str(), path.c_str()) != 0)
+  {
+    // the file may be replaced by another process meanwhile (some systems do not rename over an open file) : use it if it is right
+    remove(temporaryPath.c_str());
+    mapped = openUpToDate();
+    if (mapped) { return mapped; }
+    throw fileError(path, "cannot be written");
+  }
+  if (pRebuilt != nullptr) { *pRebuilt = true; }
+  return unique_ptr<MappedMap>(new MappedMap(path));
+}
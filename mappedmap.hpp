@@ -0,0 +1,82 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "preparedmap.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Memory-mapped prepared maps
+// ############################################################################
+
+// Reading a large map and preprocessing it takes seconds at startup. A prepared map file holds
+// the map and its preprocessed arrays as they are in memory : MappedMap maps it read-only and
+// the queries read it in place, without parsing nor copying. Opening it is near-instant, pages
+// are read from disk on first access only, and processes mapping the same file share them in
+// the page cache.
+//
+// A file is keyed by the fingerprint of its map, and each section has a checksum :
+// openOrBuildPreparedMap() rebuilds a file which is stale (another map, other options, older
+// version) or corrupted, so that restarts only preprocess when something changed.
+//
+// File format, in the byte order of the machine which wrote it (checked when opened) :
+//   header, 256 bytes : magic "PFMAP\r\n\x1a", version, byte order mark 0x01020304,
+//                       width, height, PrepareOptions bits, map fingerprint, then for each
+//                       section its offset, size in bytes (0 if absent) and checksum
+//   sections          : map cells (1 byte per cell, as FindPath()), padded map, bit-packed map,
+//                       component labels, neighbor masks - each aligned on 4096 bytes
+
+/*! \brief Fingerprint of a map, its size and cells : the key of its prepared map files */
+uint64_t mapFingerprint(const unsigned char* pMap, const int nMapWidth, const int nMapHeight);
+
+/*! \brief Write a PreparedMap in a prepared map file : its map and the arrays of its preprocessing options.
+ *  \throw BadInputException if the file cannot be written
+ */
+void savePreparedMap(const PreparedMap& preparedMap, const string& path);
+
+/*! \brief Prepared map file mapped read-only in memory.
+ *
+ *  ex: savePreparedMap(PreparedMap(pMap, width, height, options), "site.pfmap");  // once, offline
+ *      MappedMap mapped("site.pfmap");                                          // at startup
+ *      int length = mapped.prepared().findPath(0, 0, 99, 99, pOutBuffer, nOutBufferSize);
+ */
+class MappedMap
+{
+  public:
+  /*! \throw BadInputException if the file cannot be read, or is not a valid prepared map file */
+  explicit MappedMap(const string& path);
+  ~MappedMap();
+  MappedMap(const MappedMap&) = delete;
+  MappedMap& operator=(const MappedMap&) = delete;
+
+  /*! \brief The map and its arrays, valid as long as the MappedMap */
+  const PreparedMap& prepared() const { return *_prepared; }
+  /*! \brief Fingerprint of the map, as written in the file */
+  uint64_t fingerprint() const { return _fingerprint; }
+  /*! \brief Check the checksums of all the sections : reads the whole file */
+  bool verify() const;
+  size_t fileSize() const { return _size; }
+  /*! \brief false where memory mapping is not available : the file is then read in memory */
+  bool isMapped() const { return _mapped; }
+
+  private:
+  const unsigned char* _data;
+  size_t _size;
+  uint64_t _fingerprint;
+  bool _mapped;
+  vector<unsigned char> _copy;  // file content when it is not mapped
+  unique_ptr<PreparedMap> _prepared;
+};
+
+/*! \brief Map the prepared map file of a map, after (re)building it if it is missing, stale or corrupted.
+ *
+ *  The file is used if it was written for the same map - same fingerprint - with the same options,
+ *  and its checksums are right. Else the map is preprocessed again and the file replaced atomically :
+ *  processes which mapped the previous file keep it until they unmap it.
+ *  \param pRebuilt if not nullptr, set to true if the file was (re)built
+ *  \throw BadInputException on a bad map, or if the file cannot be written
+ */
+unique_ptr<MappedMap> openOrBuildPreparedMap(const string& path,
+                                             const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                             const PrepareOptions& options, bool* pRebuilt = nullptr);
@@ -0,0 +1,515 @@
+#include "memoryboundedpathfinder.hpp"
+#include <algorithm>
+#include <climits>
+#include <new>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+const unsigned char MemoryBoundedPathfinder::NO_DETOUR;
+const int MemoryBoundedPathfinder::STALL_FACTOR;
+const int MemoryBoundedPathfinder::DETOUR_WAYS;
+const size_t MemoryBoundedPathfinder::DETOUR_BYTES_PER_NODE;
+const unsigned char MemoryBoundedPathfinder::ALL_MOVES;
+
+
+MemoryBoundedPathfinder::MemoryBoundedPathfinder(const int nStartX, const int nStartY,
+                                                 const int nTargetX, const int nTargetY,
+                                                 const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                                 int* pOutBuffer, const int nOutBufferSize,
+                                                 const size_t maxBytes):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(pMap, nMapWidth, nMapHeight),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _maxBytes(maxBytes), _capacity(0), _tooDeep(false), _stalledExpansions(0), _stopStatus(FindPathStatus::Ok), _openList(0), _leaves(0), _deadEnds(0)
+{
+  throwIfBadInput(checkMapInput(nMapWidth, nMapHeight));
+  throwIfBadInput(_map.checkQuery(_start, _target, nOutBufferSize));
+}
+
+MemoryBoundedPathfinder::MemoryBoundedPathfinder(const int nStartX, const int nStartY,
+                                                 const int nTargetX, const int nTargetY,
+                                                 const PreparedMap& preparedMap,
+                                                 int* pOutBuffer, const int nOutBufferSize,
+                                                 const size_t maxBytes):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(preparedMap),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _maxBytes(maxBytes), _capacity(0), _tooDeep(false), _stalledExpansions(0), _stopStatus(FindPathStatus::Ok), _openList(0), _leaves(0), _deadEnds(0)
+{
+  throwIfBadInput(_map.checkQuery(_start, _target, nOutBufferSize));
+}
+
+int MemoryBoundedPathfinder::nodeCapacity() const
+{
+  // per node : the node, its free list entry, its entries in the three heaps,
+  // and up to 4 slots of the hash table (kept at most half full, rounded to a power of 2)
+  const size_t bytesPerNode = sizeof(Node) + sizeof(int) + 3*IndexedHeap::bytesPerIndex() + 4*sizeof(int);
+  const size_t cellCount = _map.cellCount();
+  if (_maxBytes / bytesPerNode >= cellCount) { return (int)cellCount; }
+  // nodes are forgotten : the detours are taken from the cap, a byte per cell or a table, see _bestDetours
+  if (hasCellDetours()) { return (int)((_maxBytes - cellCount) / bytesPerNode); }
+  return (int)(_maxBytes / (bytesPerNode + DETOUR_BYTES_PER_NODE));
+}
+
+size_t MemoryBoundedPathfinder::detourTableSize(const int capacity) const
+{
+  // a power of 2, rounded down to stay within the cap
+  size_t tableSize = DETOUR_WAYS;
+  while (2 * tableSize * sizeof(DetourEntry) <= DETOUR_BYTES_PER_NODE * capacity) { tableSize *= 2; }
+  return tableSize;
+}
+
+int MemoryBoundedPathfinder::findPath(SearchStats* pStats)
+{
+  if (pStats == nullptr)
+  {
+    NoStatsCollector collector;
+    return search(collector);
+  }
+  StatsCollector collector(*pStats);
+  return search(collector);
+}
+
+FindPathStatus MemoryBoundedPathfinder::findPathNoExcept(int* pLength, SearchStats* pStats) noexcept
+{
+  try
+  {
+    const int length = findPath(pStats);
+    if (_stopStatus != FindPathStatus::Ok) { return _stopStatus; }
+    *pLength = length;
+  }
+  catch (const bad_alloc&)
+  {
+    return FindPathStatus::OutOfMemory;
+  }
+  return FindPathStatus::Ok;
+}
+
+template<class Collector>
+int MemoryBoundedPathfinder::search(Collector& collector)
+{
+  _stopStatus = FindPathStatus::Ok;
+
+  // Easy case : Target and Start are the same location
+  if (_start == _target) { return 0; }
+
+  // Easy case : Target and Start are not in the same connected component, there is no path
+  if (!_map.mayConnect(_start, _target))
+  {
+    return -1;
+  }
+
+  // Everything is allocated once here, within the cap : the search itself never allocates
+  _capacity = nodeCapacity();
+  if (_capacity < 2) { throw bad_alloc(); }
+
+  _cellDetours.clear();
+  _bestDetours.clear();
+  if (_capacity < _map.cellCount())
+  {
+    if (hasCellDetours())
+    {
+      _cellDetours.assign(_map.cellCount(), NO_DETOUR);
+      collector.allocated(_cellDetours.capacity());
+    }
+    else
+    {
+      _bestDetours.assign(detourTableSize(_capacity), DetourEntry{-1, NO_DETOUR});
+      collector.allocated(_bestDetours.capacity()*sizeof(DetourEntry));
+    }
+  }
+
+  size_t tableSize = 1;
+  while (tableSize < 2 * (size_t)_capacity) { tableSize *= 2; }
+  _nodes.clear();
+  _nodes.reserve(_capacity);
+  _freeNodes.clear();
+  _freeNodes.reserve(_capacity);
+  _table.assign(tableSize, -1);
+  _openList = IndexedHeap(_capacity, TieBreak::HigherG);
+  _openList.reserve(_capacity);
+  _leaves = IndexedHeap(_capacity, TieBreak::HigherG);
+  _leaves.reserve(_capacity);
+  _deadEnds = IndexedHeap(_capacity, TieBreak::HigherG);
+  _deadEnds.reserve(_capacity);
+  collector.allocated(_nodes.capacity()*sizeof(Node) + _freeNodes.capacity()*sizeof(int) + _table.capacity()*sizeof(int) +
+                      _openList.bytesAllocated() + _leaves.bytesAllocated() + _deadEnds.bytesAllocated());
+
+  collector.startSearch();
+  const int targetIndex = _map.coordinatesToIndex(_target);
+  _tooDeep = false;
+  const int startNode = newNode(_map.coordinatesToIndex(_start), 0, _map.distance(_start, _target), -1);
+  putInOpenList(startNode);
+  int length = -1;
+  int targetNode = -1;
+  int highestF = 0;
+  bool stalled = false;
+  _stalledExpansions = 0;
+  while (!_openList.empty())
+  {
+    const int node = _openList.dequeue();
+    if (_nodes[node].cell == targetIndex)
+    {
+      targetNode = node;
+      length = _nodes[node].costFromStart;
+      break;
+    }
+
+    // Without room for the paths of a whole f layer, the search may forget and regenerate the same nodes
+    // without end : give up without progress - a higher f, or a cell reached by a shorter path - for long
+    if (_nodes[node].f > highestF)
+    {
+      highestF = _nodes[node].f;
+      _stalledExpansions = 0;
+    }
+    else if (++_stalledExpansions > STALL_FACTOR * (long long)_map.cellCount())
+    {
+      stalled = true;
+      break;
+    }
+    expand(collector, node);
+    collector.openListSize(_openList.size());
+  }
+  collector.endSearch();
+
+  // Paths were cut by the size of the pool : the cap is too small, unless there is no path at all.
+  // Without cut paths, the search only gave up : Target may be reachable with this cap, given more time.
+  if (targetNode < 0 && (stalled || _tooDeep))
+  {
+    if (!isTargetReachable()) { return -1; }
+    if (_tooDeep) { throw bad_alloc(); }
+    _stopStatus = FindPathStatus::Stalled;
+    return -1;
+  }
+
+  collector.startOutput();
+  if (targetNode >= 0) { convertToOutput(targetNode, length); }
+  collector.endOutput();
+  return length;
+}
+
+template<class Collector>
+void MemoryBoundedPathfinder::expand(Collector& collector, const int node)
+{
+  // a node with forgotten successors is expanded again to regenerate them
+  if (_nodes[node].forgottenF != INT_MAX) { collector.reExpanded(); }
+  collector.expanded();
+  // not to be forgotten while expanded
+  if (_leaves.contains(node))   { _leaves.remove(node); }
+  if (_deadEnds.contains(node)) { _deadEnds.remove(node); }
+  const int nodeF = _nodes[node].f;
+  const unsigned char moves = _nodes[node].moves;
+  _nodes[node].forgottenF = INT_MAX;
+  _nodes[node].moves = 0;
+
+  const Coordinates cell = _map.indexToCoordinates(_nodes[node].cell);
+  const int newCost = _nodes[node].costFromStart + 1;
+  Coordinates neighbors[4];
+  const int nbNeighbors = _map.findNeighbors(cell, neighbors);
+  for (int i = 0; i < nbNeighbors; ++i)
+  {
+    // Expanded again, only its forgotten successors are missing : the other ones are in the pool through a path
+    // not longer, or were, and their successors are
+    const unsigned char move = moveBit(cell, neighbors[i]);
+    if ((moves & move) == 0) { continue; }
+    collector.generated();
+    const int nextCell = _map.coordinatesToIndex(neighbors[i]);
+    // reached before by a shorter path : this one is not a shortest path
+    if (bestDetour(nextCell) < detour(neighbors[i], newCost)) { continue; }
+    // the pool cannot hold the path to this successor
+    if (newCost >= _capacity)
+    {
+      _tooDeep = true;
+      continue;
+    }
+    // a regenerated successor keeps the bound backed up in its parent
+    const int nextF = max(nodeF, newCost + _map.distance(neighbors[i], _target));
+    const int existing = findNode(nextCell);
+    if (existing >= 0)
+    {
+      if (_nodes[existing].costFromStart <= newCost) { continue; }
+
+      // shorter path to a node in the pool : it changes parent and is opened again
+      const int oldParent = _nodes[existing].parent;
+      --_nodes[oldParent].nbChildren;
+      if (oldParent != node) { updateLeaf(oldParent); }
+      _nodes[existing].parent = node;
+      _nodes[existing].costFromStart = newCost;
+      _nodes[existing].f = nextF;
+      // its successors were generated through a longer path
+      _nodes[existing].moves = ALL_MOVES;
+      recordDetour(existing);
+      ++_nodes[node].nbChildren;
+      putInOpenList(existing);
+      updateLeaf(existing);
+      continue;
+    }
+
+    if (_freeNodes.empty() && (int)_nodes.size() == _capacity)
+    {
+      // pool full : forget a dead end or a worse leaf, else the successor itself
+      const int leaf = leafToForget(nextF, newCost);
+      if (leaf < 0)
+      {
+        _nodes[node].forgottenF = min(_nodes[node].forgottenF, nextF);
+        _nodes[node].moves |= move;
+        continue;
+      }
+      forgetLeaf(leaf, node);
+    }
+    const int child = newNode(nextCell, newCost, nextF, node);
+    ++_nodes[node].nbChildren;
+    putInOpenList(child);
+    updateLeaf(child);
+  }
+
+  // successors forgotten meanwhile : the node waits in the open list to regenerate them
+  if (_nodes[node].forgottenF != INT_MAX)
+  {
+    // Only the path from Start to this node is left : the cap is too small for the search
+    if (_nodes[node].nbChildren == 0 && _leaves.empty() && _deadEnds.empty()) { throw bad_alloc(); }
+    _nodes[node].f = _nodes[node].forgottenF;
+    putInOpenList(node);
+  }
+  updateLeaf(node);
+}
+
+int MemoryBoundedPathfinder::newNode(const int cell, const int costFromStart, const int f, const int parent)
+{
+  int node;
+  if (!_freeNodes.empty())
+  {
+    node = _freeNodes.back();
+    _freeNodes.pop_back();
+    _nodes[node] = Node{cell, costFromStart, f, INT_MAX, parent, 0, ALL_MOVES};
+  }
+  else
+  {
+    node = (int)_nodes.size();
+    _nodes.push_back(Node{cell, costFromStart, f, INT_MAX, parent, 0, ALL_MOVES});
+  }
+  insertInTable(node);
+  recordDetour(node);
+  return node;
+}
+
+int MemoryBoundedPathfinder::leafToForget(const int f, const int costFromStart) const
+{
+  // The dead ends first : they are not backed up
+  if (!_deadEnds.empty()) { return _deadEnds.top(); }
+  // Then the SMA* order : the leaf with the highest f, the shallowest one first, if it is worse than the successor
+  if (_leaves.empty()) { return -1; }
+  const int leaf = _leaves.top();
+  const bool worse = _nodes[leaf].f > f || (_nodes[leaf].f == f && _nodes[leaf].costFromStart < costFromStart);
+  return worse ? leaf : -1;
+}
+
+void MemoryBoundedPathfinder::forgetLeaf(const int leaf, const int expandedNode)
+{
+  const bool deadEnd = _deadEnds.contains(leaf);
+  if (deadEnd)
+  {
+    _deadEnds.remove(leaf);
+  }
+  else
+  {
+    _leaves.remove(leaf);
+    _openList.remove(leaf);
+  }
+  removeFromTable(leaf);
+  _freeNodes.push_back(leaf);
+
+  const int parent = _nodes[leaf].parent;
+  --_nodes[parent].nbChildren;
+  // A dead end was expanded : its successors are in the pool through paths not longer, or backed up in their parent,
+  // its parent does not generate it again. Otherwise, back up its f in its parent, which must be expanded again.
+  if (!deadEnd)
+  {
+    _nodes[parent].forgottenF = min(_nodes[parent].forgottenF, _nodes[leaf].f);
+    _nodes[parent].moves |= moveBit(_map.indexToCoordinates(_nodes[parent].cell), _map.indexToCoordinates(_nodes[leaf].cell));
+  }
+  if (parent == expandedNode) { return; }  // put back in the open list at the end of its expansion
+
+  // Already open, its f bounds all the successors it generates : only lower it. It may be lower than its
+  // forgotten successors, after a shorter path to it.
+  if (!deadEnd)
+  {
+    _nodes[parent].f = _openList.contains(parent) ? min(_nodes[parent].f, _nodes[leaf].f) : _nodes[parent].forgottenF;
+    putInOpenList(parent);
+  }
+  updateLeaf(parent);
+}
+
+void MemoryBoundedPathfinder::updateLeaf(const int node)
+{
+  // Start is never forgotten
+  if (_leaves.contains(node))   { _leaves.remove(node); }
+  if (_deadEnds.contains(node)) { _deadEnds.remove(node); }
+  if (_nodes[node].nbChildren == 0 && _nodes[node].parent >= 0)
+  {
+    IndexedHeap& heap = _openList.contains(node) ? _leaves : _deadEnds;
+    heap.put(node, -_nodes[node].f, -_nodes[node].costFromStart);
+  }
+}
+
+void MemoryBoundedPathfinder::putInOpenList(const int node)
+{
+  // the f of a node can increase when bounds are backed up : not a plain decrease-key
+  if (_openList.contains(node)) { _openList.remove(node); }
+  _openList.put(node, _nodes[node].f, _nodes[node].costFromStart);
+}
+
+int MemoryBoundedPathfinder::findNode(const int cell) const
+{
+  // linear probing
+  for (size_t slot = tableSlot(cell); _table[slot] >= 0; slot = (slot + 1) & (_table.size() - 1))
+  {
+    if (_nodes[_table[slot]].cell == cell) { return _table[slot]; }
+  }
+  return -1;
+}
+
+void MemoryBoundedPathfinder::insertInTable(const int node)
+{
+  size_t slot = tableSlot(_nodes[node].cell);
+  while (_table[slot] >= 0) { slot = (slot + 1) & (_table.size() - 1); }
+  _table[slot] = node;
+}
+
+void MemoryBoundedPathfinder::removeFromTable(const int node)
+{
+  const size_t mask = _table.size() - 1;
+  size_t slot = tableSlot(_nodes[node].cell);
+  while (_table[slot] != node) { slot = (slot + 1) & mask; }
+
+  // backward shift deletion : move back the following entries which would not be found anymore
+  size_t next = (slot + 1) & mask;
+  while (_table[next] >= 0)
+  {
+    const size_t home = tableSlot(_nodes[_table[next]].cell);
+    if (((next - home) & mask) >= ((next - slot) & mask))
+    {
+      _table[slot] = _table[next];
+      slot = next;
+    }
+    next = (next + 1) & mask;
+  }
+  _table[slot] = -1;
+}
+
+void MemoryBoundedPathfinder::convertToOutput(const int targetNode, const int length)
+{
+  // the ancestors of a node are never forgotten : the whole path is in the pool
+  if (length > _outBufferSize) { return; }
+  int node = targetNode;
+  for (int cursor = length - 1; cursor >= 0; --cursor)
+  {
+    _outBuffer[cursor] = _nodes[node].cell;
+    node = _nodes[node].parent;
+  }
+}
+
+int MemoryBoundedPathfinder::detour(const Coordinates& cell, const int costFromStart) const
+{
+  // saturated : a longer detour is not recorded
+  return min(costFromStart - _map.distance(_start, cell), (int)NO_DETOUR);
+}
+
+int MemoryBoundedPathfinder::bestDetour(const int cell) const
+{
+  if (!_cellDetours.empty()) { return _cellDetours[cell]; }
+  if (_bestDetours.empty()) { return NO_DETOUR; }
+  const size_t bucket = detourBucket(cell);
+  for (size_t slot = bucket; slot < bucket + DETOUR_WAYS; ++slot)
+  {
+    if (_bestDetours[slot].cell == cell) { return _bestDetours[slot].detour; }
+  }
+  return NO_DETOUR;
+}
+
+void MemoryBoundedPathfinder::recordDetour(const int node)
+{
+  if (_cellDetours.empty() && _bestDetours.empty()) { return; }
+  const int cell = _nodes[node].cell;
+  const int nodeDetour = detour(_map.indexToCoordinates(cell), _nodes[node].costFromStart);
+  if (!_cellDetours.empty())
+  {
+    if (nodeDetour < _cellDetours[cell])
+    {
+      _cellDetours[cell] = (unsigned char)nodeDetour;
+      _stalledExpansions = 0;
+    }
+    return;
+  }
+  // the entry of the cell, else the one with the longest detour - an empty one has NO_DETOUR
+  const size_t bucket = detourBucket(cell);
+  size_t entry = bucket;
+  for (size_t slot = bucket; slot < bucket + DETOUR_WAYS; ++slot)
+  {
+    if (_bestDetours[slot].cell == cell)
+    {
+      entry = slot;
+      break;
+    }
+    if (_bestDetours[slot].detour > _bestDetours[entry].detour) { entry = slot; }
+  }
+  // Every write lowers the detour of its entry : there are finitely many, and the search cannot
+  // count them as progress forever
+  if (nodeDetour < _bestDetours[entry].detour)
+  {
+    _bestDetours[entry] = DetourEntry{cell, (unsigned char)nodeDetour};
+    _stalledExpansions = 0;
+  }
+}
+
+unsigned char MemoryBoundedPathfinder::moveBit(const Coordinates& from, const Coordinates& to)
+{
+  if (to.X != from.X) { return (to.X > from.X) ? 1 : 2; }
+  return (to.Y > from.Y) ? 4 : 8;
+}
+
+bool MemoryBoundedPathfinder::isTargetReachable()
+{
+  // Flood fill with one bit per cell and no queue : sweep the map forward and backward,
+  // reaching the cells next to reached ones, until nothing changes.
+  // The search is over : its memory is released for the bits. Without room for them in the cap,
+  // Target is assumed reachable.
+  const int mapSize = _map.cellCount();
+  if (((size_t)mapSize + 7) / 8 > _maxBytes) { return true; }
+  vector<Node>().swap(_nodes);
+  vector<int>().swap(_freeNodes);
+  vector<int>().swap(_table);
+  vector<unsigned char>().swap(_cellDetours);
+  vector<DetourEntry>().swap(_bestDetours);
+  _openList = IndexedHeap(0);
+  _leaves = IndexedHeap(0);
+  _deadEnds = IndexedHeap(0);
+  vector<bool> reached(mapSize, false);
+  reached[_map.coordinatesToIndex(_start)] = true;
+  auto reach = [&](const int index) {
+    if (reached[index]) { return false; }
+    Coordinates neighbors[4];
+    const Coordinates cell = _map.indexToCoordinates(index);
+    if (!_map.isCellOk(cell)) { return false; }
+    const int nbNeighbors = _map.findNeighbors(cell, neighbors);
+    for (int i = 0; i < nbNeighbors; ++i)
+    {
+      if (reached[_map.coordinatesToIndex(neighbors[i])])
+      {
+        reached[index] = true;
+        return true;
+      }
+    }
+    return false;
+  };
+  const int targetIndex = _map.coordinatesToIndex(_target);
+  for (bool changed = true; changed && !reached[targetIndex]; )
+  {
+    changed = false;
+    for (int index = 0; index < mapSize; ++index)      { changed |= reach(index); }
+    for (int index = mapSize - 1; index >= 0; --index) { changed |= reach(index); }
+  }
+  return reached[targetIndex];
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <vector>
+#include "preparedmap.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Memory-bounded search
+// ############################################################################
+
+// MemoryBoundedPathfinder implements SMA* (Russell, 1992) adapted to graphs : an A* whose nodes
+// live in a pool of fixed size, computed from a byte cap. Only the cells touched by the search
+// are stored, in a hash table, instead of one entry per cell of the map.
+// When the pool is full, the leaf node with the highest f is forgotten, and its f is backed up
+// in its parent, which goes back to the open list : the forgotten part of the search is
+// regenerated only if it becomes promising again. With a large enough cap this is A* ;
+// a smaller cap costs re-expansions, never a longer path.
+
+/*! \brief A* search using at most a given number of bytes.
+ *
+ *  Same contract as FindPath() : the returned path is a shortest one.
+ *  ex: MemoryBoundedPathfinder pathfinder(0, 0, 99, 99, pMap, 100, 100, pOutBuffer, nOutBufferSize, 256*1024);
+ *      int length = pathfinder.findPath();
+ */
+class MemoryBoundedPathfinder
+{
+  public:
+  /*! \param maxBytes memory cap of the search : node pool, hash tables and open lists
+   *  \throw BadInputException on the same inputs as FindPath()
+   */
+  MemoryBoundedPathfinder(const int nStartX, const int nStartY,
+                          const int nTargetX, const int nTargetY,
+                          const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                          int* pOutBuffer, const int nOutBufferSize,
+                          const size_t maxBytes);
+  /*! \brief Search on a PreparedMap, using its preprocessed arrays
+   *  \throw BadInputException on the same inputs as PreparedMap::findPath()
+   */
+  MemoryBoundedPathfinder(const int nStartX, const int nStartY,
+                          const int nTargetX, const int nTargetY,
+                          const PreparedMap& preparedMap,
+                          int* pOutBuffer, const int nOutBufferSize,
+                          const size_t maxBytes);
+
+  /*! \brief Find the shortest path and fill the output buffer.
+   *
+   *  \return length of the shortest path, or -1 if none can be found, or if the search stalled
+   *          (findPathNoExcept() then returns FindPathStatus::Stalled).
+   *  \throw  std::bad_alloc if the cap cannot even hold the nodes of the current best path
+   */
+  int findPath(SearchStats* pStats = nullptr);
+
+  /*! \brief Same as findPath(), reporting a too small cap as FindPathStatus::OutOfMemory,
+   *         and a search without progress for too long as FindPathStatus::Stalled
+   */
+  FindPathStatus findPathNoExcept(int* pLength, SearchStats* pStats = nullptr) noexcept;
+
+  /*! \brief Number of nodes the cap can hold */
+  int nodeCapacity() const;
+
+  private:
+  static const unsigned char NO_DETOUR = 255;  // not reached, or with a longer detour
+  static const int STALL_FACTOR = 16;          // expansions without progress, per cell of the map
+  static const int DETOUR_WAYS = 4;            // entries of a bucket of the detour table
+  static const size_t DETOUR_BYTES_PER_NODE = 16;  // cap taken by the detours per node : 2 entries of the table
+  static const unsigned char ALL_MOVES = 15;    // moveBit() of the 4 successors
+
+  /*! \brief A cell reached by the search */
+  struct Node
+  {
+    int cell;
+    int costFromStart;
+    int f;            // lower bound of a path through the node, raised by the backed up values
+    int forgottenF;   // lowest f of the forgotten successors, INT_MAX if none
+    int parent;       // node, -1 for Start
+    int nbChildren;   // successors in the pool whose parent is this node
+    unsigned char moves;  // moveBit() of the successors to generate at its next expansion
+  };
+
+  /*! \brief Lowest detour a cell was reached with */
+  struct DetourEntry
+  {
+    int cell;               // -1 for an empty entry
+    unsigned char detour;
+  };
+
+  bool hasCellDetours() const { return (size_t)_map.cellCount() <= _maxBytes / 2; }
+  size_t detourTableSize(const int capacity) const;
+  int detour(const Coordinates& cell, const int costFromStart) const;
+  int bestDetour(const int cell) const;
+  void recordDetour(const int node);
+  bool isTargetReachable();
+  template<class Collector>
+  int search(Collector& collector);
+  template<class Collector>
+  void expand(Collector& collector, const int node);
+  int newNode(const int cell, const int costFromStart, const int f, const int parent);
+  int leafToForget(const int f, const int costFromStart) const;
+  void forgetLeaf(const int leaf, const int expandedNode);
+  void updateLeaf(const int node);
+  void putInOpenList(const int node);
+  static unsigned char moveBit(const Coordinates& from, const Coordinates& to);
+
+  int findNode(const int cell) const;
+  void insertInTable(const int node);
+  void removeFromTable(const int node);
+  size_t tableSlot(const int cell) const { return ((size_t)(unsigned int)cell * 2654435761u) & (_table.size() - 1); }
+  size_t detourBucket(const int cell) const
+  {
+    return ((size_t)(unsigned int)cell * 2654435761u) & (_bestDetours.size() - 1) & ~(size_t)(DETOUR_WAYS - 1);
+  }
+
+  void convertToOutput(const int targetNode, const int length);
+
+  Coordinates _start, _target;
+  QueryMap _map;
+  int* _outBuffer;
+  int _outBufferSize;
+  size_t _maxBytes;
+
+  int _capacity;                 // number of nodes in the pool
+  bool _tooDeep;                 // a successor was dropped because the pool cannot hold its path
+  long long _stalledExpansions;  // since the last progress of the search
+  FindPathStatus _stopStatus;    // FindPathStatus::Stalled if the last search gave up
+  vector<Node> _nodes;
+  vector<int> _freeNodes;
+  vector<int> _table;            // open addressing hash table of nodes by cell, -1 for empty slots
+  IndexedHeap _openList;         // nodes by lowest f
+  IndexedHeap _leaves;           // open nodes without children, by highest f : the ones which can be forgotten
+  IndexedHeap _deadEnds;         // expanded nodes without children nor forgotten successors, by highest f
+  // Lowest cost from Start the cells were reached with, only when nodes are forgotten : a forgotten node
+  // is not regenerated by a longer path. Without it, the search would regenerate the forgotten nodes
+  // through all the longer paths, which are countless on a grid.
+  // A byte is enough for the detour : cost from Start minus the distance to Start.
+  // When a byte per cell takes at most half the cap, _cellDetours holds them all. Otherwise
+  // _bestDetours is a table sized from the cap, not from the map : buckets of DETOUR_WAYS entries, where
+  // a new cell replaces the entry with the longest detour. A lost entry costs regenerations, never a longer path.
+  vector<unsigned char> _cellDetours;
+  vector<DetourEntry> _bestDetours;
+};
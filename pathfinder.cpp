@@ -1,6 +1,11 @@
 #include "pathfinder.hpp"
+#include "basicpathfinder.hpp"
+#include "preparedmap.hpp"
 #include <cstdlib>
 #include <cassert>
+#include <climits>
+#include <algorithm>
+#include <new>
 
 // ############################################################################
 // ### IMPLEMENTATION
@@ -11,220 +16,598 @@ int FindPath(const int nStartX, const int nStartY,
              const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
              int* pOutBuffer, const int nOutBufferSize)
 {
-  // Check input
-  if (nMapWidth < 1)          { throw BadInputException("in FindPath(), map width must be greater than 0.\n"); }
-  if (nMapHeight < 1)         { throw BadInputException("in FindPath(), map height must be greater than 0.\n"); }
-  if (nStartX < 0)            { throw BadInputException("in FindPath(), Start's abscissa must be greater or equal to 0.\n"); }
-  if (nStartX >= nMapWidth)   { throw BadInputException("in FindPath(), Start's abscissa must be less than the map width.\n"); }
-  if (nStartY < 0)            { throw BadInputException("in FindPath(), Start's ordinate must be greater or equal to.\n"); }
-  if (nStartY >= nMapHeight)  { throw BadInputException("in FindPath(), Start's ordinate must be less than the map height.\n"); }
-  if (nTargetX < 0)           { throw BadInputException("in FindPath(), Target's abscissa must be greater or equal to 0.\n"); }
-  if (nTargetX >= nMapWidth)  { throw BadInputException("in FindPath(), Target's abscissa must be less than the map width.\n"); }
-  if (nTargetY < 0)           { throw BadInputException("in FindPath(), Target's ordinate must be greater or equal to.\n"); }
-  if (nTargetY >= nMapHeight) { throw BadInputException("in FindPath(), Target's ordinate must be less than the map height.\n"); }
-  if (nOutBufferSize < 0)     { throw BadInputException("in FindPath(), output buffer size must be greater than 0.\n"); }
+  return FindPath(nStartX, nStartY, nTargetX, nTargetY, pMap, nMapWidth, nMapHeight, pOutBuffer, nOutBufferSize, nullptr);
+}
+
+int FindPath(const int nStartX, const int nStartY,
+             const int nTargetX, const int nTargetY, 
+             const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+             int* pOutBuffer, const int nOutBufferSize,
+             SearchStats* pStats)
+{
+  // Map and queries are checked by PreparedMap.
+  // Without preprocessing option, it does not allocate anything : this is just a thin wrapper.
+  const PreparedMap preparedMap(pMap, nMapWidth, nMapHeight);
+  return preparedMap.findPath(nStartX, nStartY, nTargetX, nTargetY, pOutBuffer, nOutBufferSize, pStats);
+}
+
+int FindPath(const int nStartX, const int nStartY,
+             const int nTargetX, const int nTargetY,
+             const MapView& view,
+             int* pOutBuffer, const int nOutBufferSize,
+             SearchStats* pStats)
+{
+  const PreparedMap preparedMap(view);
+  return preparedMap.findPath(nStartX, nStartY, nTargetX, nTargetY, pOutBuffer, nOutBufferSize, pStats);
+}
+
+FindPathStatus FindPathNoExcept(const int nStartX, const int nStartY,
+                                const int nTargetX, const int nTargetY,
+                                const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                int* pOutBuffer, const int nOutBufferSize,
+                                int* pLength, SearchStats* pStats) noexcept
+{
+  const FindPathStatus status = checkMapInput(nMapWidth, nMapHeight);
+  if (status != FindPathStatus::Ok) { return status; }
+
+  // the map is valid : the PreparedMap constructor cannot throw
+  const PreparedMap preparedMap(pMap, nMapWidth, nMapHeight);
+  return preparedMap.findPathNoExcept(nStartX, nStartY, nTargetX, nTargetY, pOutBuffer, nOutBufferSize, pLength, pStats);
+}
+
+FindPathStatus FindPathNoExcept(const int nStartX, const int nStartY,
+                                const int nTargetX, const int nTargetY,
+                                const MapView& view,
+                                int* pOutBuffer, const int nOutBufferSize,
+                                int* pLength, SearchStats* pStats) noexcept
+{
+  const FindPathStatus status = checkMapInput(view.width, view.height);
+  if (status != FindPathStatus::Ok) { return status; }
+
+  const PreparedMap preparedMap(view);
+  return preparedMap.findPathNoExcept(nStartX, nStartY, nTargetX, nTargetY, pOutBuffer, nOutBufferSize, pLength, pStats);
+}
+
+const char* findPathStatusMessage(const FindPathStatus status) noexcept
+{
+  switch (status)
+  {
+    case FindPathStatus::Ok:                    return "";
+    case FindPathStatus::MapWidthTooSmall:      return "in FindPath(), map width must be greater than 0.\n";
+    case FindPathStatus::MapHeightTooSmall:     return "in FindPath(), map height must be greater than 0.\n";
+    case FindPathStatus::MapTooLarge:           return "in FindPath(), map must have less than 2^31 cells, use FindPathLarge().\n";
+    case FindPathStatus::StartXNegative:        return "in FindPath(), Start's abscissa must be greater or equal to 0.\n";
+    case FindPathStatus::StartXOutOfMap:        return "in FindPath(), Start's abscissa must be less than the map width.\n";
+    case FindPathStatus::StartYNegative:        return "in FindPath(), Start's ordinate must be greater or equal to.\n";
+    case FindPathStatus::StartYOutOfMap:        return "in FindPath(), Start's ordinate must be less than the map height.\n";
+    case FindPathStatus::TargetXNegative:       return "in FindPath(), Target's abscissa must be greater or equal to 0.\n";
+    case FindPathStatus::TargetXOutOfMap:       return "in FindPath(), Target's abscissa must be less than the map width.\n";
+    case FindPathStatus::TargetYNegative:       return "in FindPath(), Target's ordinate must be greater or equal to.\n";
+    case FindPathStatus::TargetYOutOfMap:       return "in FindPath(), Target's ordinate must be less than the map height.\n";
+    case FindPathStatus::OutBufferSizeNegative: return "in FindPath(), output buffer size must be greater than 0.\n";
+    case FindPathStatus::StartNotPassable:      return "in FindPath(), Start point must be passable.\n";
+    case FindPathStatus::TargetNotPassable:     return "in FindPath(), Target point must be passable.\n";
+    case FindPathStatus::OutOfMemory:           return "in FindPath(), not enough memory.\n";
+    case FindPathStatus::Cancelled:             return "in FindPath(), search cancelled.\n";
+    case FindPathStatus::DeadlineExceeded:      return "in FindPath(), search deadline exceeded.\n";
+    case FindPathStatus::Stalled:               return "in FindPath(), search stalled without progress.\n";
+  }
+  return "";
+}
+
+FindPathStatus checkMapInput(const int nMapWidth, const int nMapHeight) noexcept
+{
+  if (nMapWidth < 1)          { return FindPathStatus::MapWidthTooSmall; }
+  if (nMapHeight < 1)         { return FindPathStatus::MapHeightTooSmall; }
+  // cell indexes are ints
+  if ((long long)nMapWidth * nMapHeight > INT_MAX) { return FindPathStatus::MapTooLarge; }
+  return FindPathStatus::Ok;
+}
+
+FindPathStatus checkQueryInput(const int nStartX, const int nStartY,
+                               const int nTargetX, const int nTargetY,
+                               const int nMapWidth, const int nMapHeight,
+                               const int nOutBufferSize) noexcept
+{
+  if (nStartX < 0)            { return FindPathStatus::StartXNegative; }
+  if (nStartX >= nMapWidth)   { return FindPathStatus::StartXOutOfMap; }
+  if (nStartY < 0)            { return FindPathStatus::StartYNegative; }
+  if (nStartY >= nMapHeight)  { return FindPathStatus::StartYOutOfMap; }
+  if (nTargetX < 0)           { return FindPathStatus::TargetXNegative; }
+  if (nTargetX >= nMapWidth)  { return FindPathStatus::TargetXOutOfMap; }
+  if (nTargetY < 0)           { return FindPathStatus::TargetYNegative; }
+  if (nTargetY >= nMapHeight) { return FindPathStatus::TargetYOutOfMap; }
+  if (nOutBufferSize < 0)     { return FindPathStatus::OutBufferSizeNegative; }
   // Start and Target location passability will be checked later
+  return FindPathStatus::Ok;
+}
+
+void throwIfBadInput(const FindPathStatus status)
+{
+  if (status != FindPathStatus::Ok) { throw BadInputException(findPathStatusMessage(status)); }
+}
 
-  Pathfinder pathfinder(nStartX, nStartY, nTargetX, nTargetY, pMap, nMapWidth, nMapHeight, pOutBuffer, nOutBufferSize);
-  return pathfinder.findPath();
+Pathfinder::Pathfinder(const int nStartX, const int nStartY,
+                       const int nTargetX, const int nTargetY,
+                       const PreparedMap& preparedMap,
+                       int* pOutBuffer, const int nOutBufferSize,
+                       const TieBreak tieBreak,
+                       const SearchLayout layout):
+  _start(nStartX, nStartY), _target(nTargetX, nTargetY),
+  _map(preparedMap.getMap()),
+  _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+  _tieBreak(tieBreak), _layout(layout), _prepared(nullptr), _tiled(false),
+  _stopCondition(nullptr), _stopStatus(FindPathStatus::Ok)
+{
+  // keep the PreparedMap for its arrays, or for its cell order
+  if (preparedMap.hasPreprocessing() || preparedMap.options().tiledLayout)
+  {
+    _prepared = &preparedMap;
+    _tiled = preparedMap.options().tiledLayout;
+  }
+}
+
+inline int Pathfinder::stateIndex(const Coordinates& coordCell) const
+{
+  return _tiled ? _prepared->cellIndex(coordCell) : _map.coordinatesToIndex(coordCell);
 }
 
-int Pathfinder::findPath()
+inline const Coordinates Pathfinder::stateCoordinates(const int index) const
+{
+  return _tiled ? _prepared->cellCoordinates(index) : _map.indexToCoordinates(index);
+}
+
+inline int Pathfinder::stateSize() const
+{
+  return _tiled ? _prepared->cellCount() : _map.cellCount();
+}
+
+int Pathfinder::findPath(SearchStats* pStats)
 {
   // finish to check input
-  if (!_map.isCellOk(_start))  { throw BadInputException("in FindPath(), Start point must be passable.\n"); }
-  if (!_map.isCellOk(_target)) { throw BadInputException("in FindPath(), Target point must be passable.\n"); }
+  throwIfBadInput(checkInput());
+  return search(pStats);
+}
+
+FindPathStatus Pathfinder::findPathNoExcept(int* pLength, SearchStats* pStats) noexcept
+{
+  const FindPathStatus status = checkInput();
+  if (status != FindPathStatus::Ok) { return status; }
+  try
+  {
+    const int length = search(pStats);
+    if (_stopStatus != FindPathStatus::Ok) { return _stopStatus; }
+    *pLength = length;
+  }
+  catch (const bad_alloc&)
+  {
+    return FindPathStatus::OutOfMemory;
+  }
+  return FindPathStatus::Ok;
+}
+
+FindPathStatus Pathfinder::checkInput() const
+{
+  if (!isCellOk(_start))  { return FindPathStatus::StartNotPassable; }
+  if (!isCellOk(_target)) { return FindPathStatus::TargetNotPassable; }
+  return FindPathStatus::Ok;
+}
+
+int Pathfinder::search(SearchStats* pStats)
+{
+  // Statistics collection is selected once here, the search itself is compiled twice :
+  // with NoStatsCollector, the hot loop does not pay anything for statistics.
+  if (pStats == nullptr)
+  {
+    NoStatsCollector collector;
+    return search(collector);
+  }
+  StatsCollector collector(*pStats);
+  return search(collector);
+}
+
+template<class Collector>
+int Pathfinder::search(Collector& collector)
+{
+  _stopStatus = FindPathStatus::Ok;
 
   // Easy case : Target and Start are the same location
   if (_start == _target) { return 0; }
 
-  // Use A* algorythm to fill a "Shortest path map"
-  const map<Coordinates, Coordinates> shortestPathMap = Astar();
+  // Easy case : Target and Start are not in the same connected component, there is no path
+  if (_prepared != nullptr && _prepared->options().components &&
+      _prepared->component(_start) != _prepared->component(_target))
+  {
+    return -1;
+  }
 
-  // Use "Shortest path map" to build the output - will update pOutBuffer
-  const int length = convertToOutput(shortestPathMap);
+  // Inside an ArenaScope, the search state is taken from its arena, and given back at the end of the query
+  Arena* arena = Arena::current();
+  if (arena != nullptr)
+  {
+    ArenaScope queryScope(*arena);
+    return runSearch(collector);
+  }
+  return runSearch(collector);
+}
 
+// SearchLayout::Automatic : A* reaches about distance^2 / SPARSE_REACH_DIVISOR cells on open maps.
+// A sparse node costs a few times more than a dense cell, in memory and time, but the dense
+// layout initializes the whole map : sparse pays off while the cells reached are a small part of it.
+static const int SPARSE_REACH_DIVISOR = 4;
+static const int SPARSE_MAP_FRACTION = 4;
+
+static long long expectedSparseNodes(const Map& map, const Coordinates& start, const Coordinates& target)
+{
+  const long long distance = map.distance(start, target) + 1;
+  return distance * distance / SPARSE_REACH_DIVISOR;
+}
+
+SearchLayout Pathfinder::layout() const
+{
+  if (_layout != SearchLayout::Automatic) { return _layout; }
+  return (expectedSparseNodes(_map, _start, _target) * SPARSE_MAP_FRACTION <= _map.cellCount()) ? SearchLayout::Sparse
+                                                                                               : SearchLayout::Dense;
+}
+
+template<class Collector>
+int Pathfinder::runSearch(Collector& collector)
+{
+  const SearchLayout layout = this->layout();
+  if (layout == SearchLayout::Sparse) { return basicSearch<SparseState>(collector); }
+  if (layout == SearchLayout::Compact)
+  {
+    collector.startSearch();
+    const ArenaVector<unsigned char> parentDirections = compactAstar(collector);
+    collector.endSearch();
+
+    collector.startOutput();
+    const int length = convertDirectionsToOutput(parentDirections);
+    collector.endOutput();
+    return length;
+  }
+  return basicSearch<DenseState>(collector);
+}
+
+// The map of the dense and sparse searches, as BasicPathfinder reads it : the neighbors from the preprocessed
+// arrays of the PreparedMap if any, the cells indexed by stateIndex()
+class PathfinderMap
+{
+  public:
+  static const int MAX_NEIGHBORS = Map::MAX_NEIGHBORS;
+
+  PathfinderMap(const Map& map, const PreparedMap* prepared, const bool tiled):
+    _map(map), _prepared(prepared), _tiled(tiled) {}
+
+  int findNeighbors(const Coordinates& cell, Coordinates outputNeighbors[MAX_NEIGHBORS]) const
+  {
+    return (_prepared != nullptr) ? _prepared->findNeighbors(cell, outputNeighbors) : _map.findNeighbors(cell, outputNeighbors);
+  }
+  bool isCellOk(const Coordinates& coordCell) const
+  {
+    return (_prepared != nullptr) ? _prepared->isCellOk(coordCell) : _map.isCellOk(coordCell);
+  }
+  int coordinatesToIndex(const Coordinates& coordinates) const
+  {
+    return _tiled ? _prepared->cellIndex(coordinates) : _map.coordinatesToIndex(coordinates);
+  }
+  const Coordinates indexToCoordinates(const int index) const
+  {
+    return _tiled ? _prepared->cellCoordinates(index) : _map.indexToCoordinates(index);
+  }
+  int distance(const Coordinates& cellA, const Coordinates& cellB) const { return _map.distance(cellA, cellB); }
+  int width() const { return _map.width(); }
+  int height() const { return _map.height(); }
+  int cellCount() const { return _tiled ? _prepared->cellCount() : _map.cellCount(); }
+
+  private:
+  const Map& _map;
+  const PreparedMap* _prepared;
+  bool _tiled;
+};
+
+template<class StateLayout, class Collector>
+int Pathfinder::basicSearch(Collector& collector)
+{
+  // The search of BasicPathfinder, with the open list of the tie-break chosen at construction
+  BasicPathfinder<FourConnected, UnitCost, ManhattanHeuristic, HeapOpenList, StateLayout, PathfinderMap>
+    pathfinder(_start.X, _start.Y, _target.X, _target.Y, PathfinderMap(_map, _prepared, _tiled),
+               _outBuffer, _outBufferSize, UnitCost(), ManhattanHeuristic(), HeapOpenList{_tieBreak});
+  pathfinder.setStopCondition(_stopCondition);
+  const int length = pathfinder.search(collector);
+  _stopStatus = pathfinder.stopStatus();
+
+  // the output is row-major : convert the indexes of the tiled state
+  if (_tiled && length <= _outBufferSize)
+  {
+    for (int i = 0; i < length; ++i) { _outBuffer[i] = _map.coordinatesToIndex(stateCoordinates(_outBuffer[i])); }
+  }
   return length;
 }
 
-const map<Coordinates, Coordinates> Pathfinder::Astar() const
+// Direction of the parent of a cell, on 2 bits
+static const unsigned char PARENT_UP    = 0;
+static const unsigned char PARENT_DOWN  = 1;
+static const unsigned char PARENT_LEFT  = 2;
+static const unsigned char PARENT_RIGHT = 3;
+
+static unsigned char parentDirection(const Coordinates& cell, const Coordinates& parent)
 {
-  // "Shortest path" map.
-  // Will contain for each cell, which is the previous cell in the shortest path.
-  // By backtracking from Target to Start, we can reconstitute the shortest path.
-  map<Coordinates, Coordinates> shortestPathMap;
-  // "Cost From Start" map. 
-  // Will contain for each cell the distance from the Start in the shortest path.
-  map<Coordinates, int> costFromStart;
-  costFromStart[_start] = 0;
+  if (parent.Y < cell.Y) { return PARENT_UP; }
+  if (parent.Y > cell.Y) { return PARENT_DOWN; }
+  return (parent.X < cell.X) ? PARENT_LEFT : PARENT_RIGHT;
+}
 
-  // Using priority queue in order to examine first "the most promising cell"
-  // In this case, priority score is the addition of distance of the cell from the Start
-  // and of the heuristics of A* algo, i.e. shortest distance without obstacle between the cell and the Target
-  // and the queue first dequeues the item with lowest score.
-  PriorityQueue<Coordinates> q;
-  q.put(_start, 0);
+static Coordinates parentCell(const Coordinates& cell, const unsigned char direction)
+{
+  switch (direction)
+  {
+    case PARENT_UP:   return Coordinates(cell.X, cell.Y-1);
+    case PARENT_DOWN: return Coordinates(cell.X, cell.Y+1);
+    case PARENT_LEFT: return Coordinates(cell.X-1, cell.Y);
+  }
+  return Coordinates(cell.X+1, cell.Y);
+}
+
+// 4 directions per byte
+static unsigned char readDirection(const ArenaVector<unsigned char>& directions, const int index)
+{
+  return (directions[index >> 2] >> ((index & 3) * 2)) & 3;
+}
+
+static void writeDirection(ArenaVector<unsigned char>& directions, const int index, const unsigned char direction)
+{
+  const int shift = (index & 3) * 2;
+  directions[index >> 2] = (unsigned char)((directions[index >> 2] & ~(3 << shift)) | (direction << shift));
+}
+
+template<class Collector>
+const ArenaVector<unsigned char> Pathfinder::compactAstar(Collector& collector)
+{
+  // Same search as the dense layout, with SearchLayout::Compact state
+  const int mapSize = stateSize();
+  const int startIndex  = stateIndex(_start);
+  const int targetIndex = stateIndex(_target);
+  Arena* arena = Arena::current();
+
+  // Direction of the previous cell in the shortest path, 2 bits per cell, set when the cell is closed.
+  ArenaVector<unsigned char> parentDirections((mapSize + 3) / 4, 0, ArenaAllocator<unsigned char>(arena));
+  ArenaVector<bool> closed(mapSize, false, ArenaAllocator<bool>(arena));
+
+  // A cell may be several times in the open list, once per shorter path found to it :
+  // the first one dequeued has the shortest path, the next ones are skipped as the cell is closed.
+  // The open list entry carries what the dense layout stores per cell.
+  struct OpenCell
+  {
+    int index;
+    int costFromStart;
+    unsigned char parentDirection;
+  };
+  PriorityQueue<OpenCell> q(_tieBreak, arena);
+  q.put(OpenCell{startIndex, 0, 0}, 0, 0);
+  size_t peakOpenListSize = q.size();
+  collector.openListSize(q.size());
 
   bool foundTarget = false;
+  int expansionsBeforeCheck = StopCondition::CHECK_PERIOD;
   while( ! q.empty() )
   {
-    const Coordinates currentCell = q.dequeue();
+    const OpenCell current = q.dequeue();
+    if (closed[current.index]) { continue; }  // reached before by a shorter path
+
+    // abandon the search if cancelled or out of time - checked periodically only
+    if (_stopCondition != nullptr && --expansionsBeforeCheck == 0)
+    {
+      expansionsBeforeCheck = StopCondition::CHECK_PERIOD;
+      _stopStatus = _stopCondition->check();
+      if (_stopStatus != FindPathStatus::Ok) { break; }
+    }
+
+    closed[current.index] = true;
+    if (current.index != startIndex) { writeDirection(parentDirections, current.index, current.parentDirection); }
 
     // early exit - as soon as we found a path to the target
-    if (currentCell == _target)
+    if (current.index == targetIndex)
     {
       foundTarget = true;
       break;
     }
-    
-    // Loop on possible adjacent cells
-    // Map::findNeighbors() will remove uneligible cells from the list (out of bounds and impassable cells)
-    for (const Coordinates& nextCell : _map.findNeighbors(currentCell))
+    collector.expanded();
+
+    const Coordinates currentCell = stateCoordinates(current.index);
+    const int newCost = current.costFromStart + 1;
+    Coordinates neighbors[4];
+    const int nbNeighbors = (_prepared != nullptr) ? _prepared->findNeighbors(currentCell, neighbors)
+                                                   : _map.findNeighbors(currentCell, neighbors);
+    for (int i = 0; i < nbNeighbors; ++i)
     {
-      auto findCurrentCost = costFromStart.find(currentCell);
-      assert(findCurrentCost != costFromStart.end());
-      int newCost = findCurrentCost->second + 1; // it costs 1 to go from one cell to the next
-
-      // Only examine the next cell it if it's the first time,
-      // or if a shorter path from Start cell has been found.
-      auto findIt = costFromStart.find(nextCell);
-      if (findIt == costFromStart.end() || newCost < findIt->second)
-      {
-        const int heuristics = _map.distance(nextCell, _target); // distance without obstacle
-        int priority = newCost + heuristics;
-        q.put(nextCell, priority);
-        costFromStart[nextCell] = newCost;
-        shortestPathMap[nextCell] = currentCell;
-      }
+      const Coordinates& nextCell = neighbors[i];
+      const int nextIndex = stateIndex(nextCell);
+      if (closed[nextIndex]) { continue; }
+      collector.generated();
+
+      // without the cost from Start of open cells, every path is queued : the longer ones are skipped later
+      const int heuristics = _map.distance(nextCell, _target);
+      q.put(OpenCell{nextIndex, newCost, parentDirection(nextCell, currentCell)}, newCost + heuristics, newCost);
     }
+    peakOpenListSize = max(peakOpenListSize, q.size());
+    collector.openListSize(q.size());
   }
+  collector.allocated(parentDirections.capacity() + closed.capacity()/8 +
+                      peakOpenListSize*sizeof(typename PriorityQueue<OpenCell>::PQElement));
 
-  // return "Shortest Path" map - enough to reconstitute shortest path and its length
-  // if we could not find the target, return empty map
   if (!foundTarget)
   {
-    shortestPathMap.clear();
+    parentDirections.clear();
   }
-  return shortestPathMap;
+  return parentDirections;
 }
 
-int Pathfinder::convertToOutput(const map<Coordinates, Coordinates>& shortestPathMap)
+int Pathfinder::convertDirectionsToOutput(const ArenaVector<unsigned char>& parentDirections)
 {
-  // if shortest path map is empty, it means there is no possible path.
-  // just return -1
-  if (shortestPathMap.empty())
+  // backtrack from Target, decoding the parent directions
+  if (parentDirections.empty())
   {
     return -1;
   }
-
-  // backtrack from the target to the start
-  // first we need to know the length of shortest path
+  const int startIndex  = stateIndex(_start);
+  const int targetIndex = stateIndex(_target);
+  auto parentIndex = [&](const int index) {
+    return stateIndex(parentCell(stateCoordinates(index), readDirection(parentDirections, index)));
+  };
   int length = 0;
-  Coordinates currentCell = _target;
-  while( currentCell != _start )
+  for (int currentIndex = targetIndex; currentIndex != startIndex; currentIndex = parentIndex(currentIndex))
   {
     ++length;
-    currentCell = shortestPathMap.find(currentCell)->second;
   }
-
-  // if length is shorter than nOutBufferSize, 
-  // then backtrack again and fill pOutBuffer (starting from the end to the start)
   if (length <= _outBufferSize)
   {
-    currentCell = _target;
-    int cursor = 0;
-    while( currentCell != _start )
+    int currentIndex = targetIndex;
+    for (int cursor = length - 1; currentIndex != startIndex; --cursor)
     {
-      ++cursor;
-      _outBuffer[length-cursor] = _map.coordinatesToIndex(currentCell);
-      currentCell = shortestPathMap.find(currentCell)->second;
+      _outBuffer[cursor] = _tiled ? _map.coordinatesToIndex(stateCoordinates(currentIndex)) : currentIndex;
+      currentIndex = parentIndex(currentIndex);
     }
   }
-
   return length;
 }
 
-bool Map::isCellOutOfBounds(const Coordinates& coordCell) const
+bool Pathfinder::isCellOk(const Coordinates& coordCell) const
 {
-  return (coordCell.X < 0 || coordCell.X >= _mapWidth || 
-          coordCell.Y < 0 || coordCell.Y >= _mapHeight);
+  return (_prepared != nullptr) ? _prepared->isCellOk(coordCell) : _map.isCellOk(coordCell);
 }
 
-bool Map::isCellOk(const Coordinates& coordCell) const
+bool operator==(const Coordinates& lhs, const Coordinates& rhs)
 {
-  // check if cell is out of bounds
-  if (isCellOutOfBounds(coordCell))
-  {
-    return false;
-  }
+  return ((lhs.X == rhs.X) && (lhs.Y == rhs.Y));
+}
 
-  // check if cell is impassable
-  const int indexCell = coordinatesToIndex(coordCell);
-  assert(indexCell >= 0 && indexCell < _mapHeight*_mapWidth);
-  if (_pMap[indexCell] == 0)
-  {
-    return false;
-  }
+bool operator!=(const Coordinates& lhs, const Coordinates& rhs)
+{
+  return (!(lhs == rhs));
+}
 
-  // else the cell is eligible
-  return true;
+bool operator<(const Coordinates& lhs, const Coordinates& rhs)
+{
+  if (lhs.X < rhs.X)  return true;
+  if (lhs.X > rhs.X)  return false;
+  if (lhs.Y < rhs.Y)  return true;
+  if (lhs.Y > rhs.Y)  return false;
+  return false;
 }
 
-const list<Coordinates> Map::findNeighbors(const Coordinates& cell) const
+bool operator<(const QueueKey& lhs, const QueueKey& rhs)
 {
-  list<Coordinates> outputNeighbors;
-  const Coordinates upCell    = Coordinates(cell.X, cell.Y-1);
-  const Coordinates downCell  = Coordinates(cell.X, cell.Y+1);
-  const Coordinates leftCell  = Coordinates(cell.X-1, cell.Y);
-  const Coordinates rightCell = Coordinates(cell.X+1, cell.Y);
-  if (isCellOk(upCell))     outputNeighbors.push_back(upCell);
-  if (isCellOk(downCell))   outputNeighbors.push_back(downCell);
-  if (isCellOk(leftCell))   outputNeighbors.push_back(leftCell);
-  if (isCellOk(rightCell))  outputNeighbors.push_back(rightCell);
-  return outputNeighbors;
+  if (lhs.priority < rhs.priority)  return true;
+  if (lhs.priority > rhs.priority)  return false;
+  if (lhs.tiebreak < rhs.tiebreak)  return true;
+  if (lhs.tiebreak > rhs.tiebreak)  return false;
+  // smaller order is dequeued first - Lifo policy stores negated insertion order
+  return (lhs.order < rhs.order);
 }
 
-int Map::coordinatesToIndex(const Coordinates& coordinates) const
+QueueKey makeQueueKey(const TieBreak tieBreak, const int priority, const int costFromStart, const long long order)
 {
-  assert(!isCellOutOfBounds(coordinates));
-  return (coordinates.Y*_mapWidth + coordinates.X);
+  QueueKey key = {priority, 0, order};
+  if (tieBreak == TieBreak::HigherG)    { key.tiebreak = -costFromStart; }
+  if (tieBreak == TieBreak::LowerH)     { key.tiebreak = priority - costFromStart; }
+  if (tieBreak == TieBreak::Lifo)       { key.order = -key.order; }
+  return key;
 }
-const Coordinates Map::indexToCoordinates(const int index) const
+
+size_t IndexedHeap::bytesPerIndex()
 {
-  assert(index>=0 && index < _mapWidth*_mapHeight);
-  return Coordinates(index % _mapWidth, index / _mapWidth);
+  return sizeof(HeapElement) + sizeof(int);
 }
 
-int Map::distance(const Coordinates& cellA, const Coordinates& cellB) const
+void IndexedHeap::put(const int index, const int priority, const int costFromStart)
 {
-  return (abs(cellA.X-cellB.X) + abs(cellA.Y-cellB.Y));
+  const QueueKey key = makeQueueKey(_tieBreak, priority, costFromStart, _counter++);
+  int position = _positions[index];
+  if (position < 0)
+  {
+    // new cell : append it at the bottom of the heap
+    position = (int)_elements.size();
+    _elements.push_back(HeapElement{key, index});
+    _positions[index] = position;
+  }
+  else
+  {
+    // decrease-key : only an improvement of the priority is expected
+    assert(!(_elements[position].key < key));
+    _elements[position].key = key;
+  }
+  siftUp(position);
 }
 
-bool operator==(const Coordinates& lhs, const Coordinates& rhs)
+int IndexedHeap::dequeue()
 {
-  return ((lhs.X == rhs.X) && (lhs.Y == rhs.Y));
+  assert(!_elements.empty());
+  const int bestIndex = _elements.front().index;
+  _positions[bestIndex] = -1;
+  const HeapElement last = _elements.back();
+  _elements.pop_back();
+  if (!_elements.empty())
+  {
+    place(last, 0);
+    siftDown(0);
+  }
+  return bestIndex;
 }
 
-bool operator!=(const Coordinates& lhs, const Coordinates& rhs)
+void IndexedHeap::remove(const int index)
 {
-  return (!(lhs == rhs));
+  const int position = _positions[index];
+  assert(position >= 0);
+  _positions[index] = -1;
+  const HeapElement last = _elements.back();
+  _elements.pop_back();
+  if (position < (int)_elements.size())
+  {
+    // the last element takes the free position, then moves up or down to its place
+    place(last, position);
+    siftUp(position);
+    siftDown(_positions[last.index]);
+  }
 }
 
-bool operator<(const Coordinates& lhs, const Coordinates& rhs)
+void IndexedHeap::siftUp(int position)
 {
-  if (lhs.X < rhs.X)  return true;
-  if (lhs.X > rhs.X)  return false;
-  if (lhs.Y < rhs.Y)  return true;
-  if (lhs.Y > rhs.Y)  return false;
-  return false;
+  const HeapElement element = _elements[position];
+  while (position > 0)
+  {
+    const int parent = (position - 1) / ARITY;
+    if (!(element.key < _elements[parent].key)) { break; }
+    place(_elements[parent], position);
+    position = parent;
+  }
+  place(element, position);
 }
 
-bool operator<(const std::pair<int, time_t>& lhs, const std::pair<int, time_t>& rhs)
+void IndexedHeap::siftDown(int position)
 {
-  if (lhs.first < rhs.first)  return true;
-  if (lhs.first > rhs.first)  return false;
-  // for FIFO, we want smaller time to be dequeued first
-  if (lhs.second > rhs.second)  return true;
-  if (lhs.second < rhs.second)  return false;
-  return false;
-}
\ No newline at end of file
+  const HeapElement element = _elements[position];
+  const int size = (int)_elements.size();
+  while (true)
+  {
+    // find the best of the (up to) ARITY children
+    const int firstChild = position * ARITY + 1;
+    if (firstChild >= size) { break; }
+    const int lastChild = min(firstChild + ARITY, size);
+    int bestChild = firstChild;
+    for (int child = firstChild + 1; child < lastChild; ++child)
+    {
+      if (_elements[child].key < _elements[bestChild].key) { bestChild = child; }
+    }
+    if (!(_elements[bestChild].key < element.key)) { break; }
+    place(_elements[bestChild], position);
+    position = bestChild;
+  }
+  place(element, position);
+}
+
+void IndexedHeap::place(const HeapElement& element, const int position)
+{
+  _elements[position] = element;
+  _positions[element.index] = position;
+}
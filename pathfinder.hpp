@@ -1,9 +1,16 @@
 #pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
 #include <list>
 #include <map>
 #include <queue>
-#include <ctime>
+#include <vector>
+#include <string>
 #include <exception>
+#include <chrono>
+#include <atomic>
+#include "arena.hpp"
 
 using namespace std;
 
@@ -51,6 +58,92 @@ int FindPath(const int nStartX, const int nStartY,
              const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
              int* pOutBuffer, const int nOutBufferSize);
 
+struct SearchStats;
+struct MapView;
+class PreparedMap;
+template<typename Cell> class BasicSparseSearchState;
+typedef BasicSparseSearchState<int> SparseSearchState;
+
+/*! \brief Same as above, also filling per-query statistics in *pStats.
+ *
+ *  pStats may be nullptr, in which case no statistics are collected at all
+ *  and the search runs exactly as the API without statistics.
+ */
+int FindPath(const int nStartX, const int nStartY,
+             const int nTargetX, const int nTargetY, 
+             const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+             int* pOutBuffer, const int nOutBufferSize,
+             SearchStats* pStats);
+
+/*! \brief Result of the input checks, one value per BadInputException message.
+ *
+ *  Returned by the noexcept API instead of throwing.
+ */
+enum class FindPathStatus
+{
+  Ok,
+  MapWidthTooSmall,
+  MapHeightTooSmall,
+  MapTooLarge,        //!< more than INT_MAX cells : see FindPathLarge()
+  StartXNegative,
+  StartXOutOfMap,
+  StartYNegative,
+  StartYOutOfMap,
+  TargetXNegative,
+  TargetXOutOfMap,
+  TargetYNegative,
+  TargetYOutOfMap,
+  OutBufferSizeNegative,
+  StartNotPassable,
+  TargetNotPassable,
+  OutOfMemory,        //!< only returned by the noexcept API, the throwing one lets std::bad_alloc go
+  Cancelled,          //!< the search was stopped by its StopCondition's cancellation flag
+  DeadlineExceeded,   //!< the search was stopped by its StopCondition's deadline
+  Stalled             //!< MemoryBoundedPathfinder gave up after too many expansions without progress
+};
+
+/*! \brief Same as FindPath(), on a view of a caller buffer : a sub-rectangle, a channel, a threshold.
+ *
+ *  The cells are read in place, without copy. Coordinates and output indices are relative to the view.
+ *  ex: FindPath(0, 0, 99, 99, MapView(pImage, 640, 480).subView(200, 100, 100, 100), pOutBuffer, nOutBufferSize);
+ */
+int FindPath(const int nStartX, const int nStartY,
+             const int nTargetX, const int nTargetY,
+             const MapView& view,
+             int* pOutBuffer, const int nOutBufferSize,
+             SearchStats* pStats = nullptr);
+
+/*! \brief Same as FindPath(), reporting bad input as a status code instead of an exception.
+ *
+ *  The rejection of a bad input does not allocate anything, nor unwind the stack.
+ *  \param pLength set to the length of the shortest path, or -1 if none can be found,
+ *                 when the status is FindPathStatus::Ok. Left untouched otherwise.
+ */
+FindPathStatus FindPathNoExcept(const int nStartX, const int nStartY,
+                                const int nTargetX, const int nTargetY,
+                                const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                                int* pOutBuffer, const int nOutBufferSize,
+                                int* pLength, SearchStats* pStats = nullptr) noexcept;
+
+/*! \brief Same as FindPathNoExcept(), on a view of a caller buffer */
+FindPathStatus FindPathNoExcept(const int nStartX, const int nStartY,
+                                const int nTargetX, const int nTargetY,
+                                const MapView& view,
+                                int* pOutBuffer, const int nOutBufferSize,
+                                int* pLength, SearchStats* pStats = nullptr) noexcept;
+
+/*! \brief Message of the BadInputException matching a status, a static string. */
+const char* findPathStatusMessage(const FindPathStatus status) noexcept;
+
+/*! \brief Input checks shared by FindPath() and PreparedMap. */
+FindPathStatus checkMapInput(const int nMapWidth, const int nMapHeight) noexcept;
+FindPathStatus checkQueryInput(const int nStartX, const int nStartY,
+                               const int nTargetX, const int nTargetY,
+                               const int nMapWidth, const int nMapHeight,
+                               const int nOutBufferSize) noexcept;
+/*! \throw BadInputException if status is not FindPathStatus::Ok */
+void throwIfBadInput(const FindPathStatus status);
+
 /*! \brief Coordinates on the 2D map.
  *
  *  With appropriate operators in order to be used in maps and queues.
@@ -65,25 +158,226 @@ bool operator==(const Coordinates& lhs, const Coordinates& rhs);
 bool operator!=(const Coordinates& lhs, const Coordinates& rhs);
 bool operator<(const Coordinates& lhs, const Coordinates& rhs);
 
-/*! \brief Class describing and providing all operations pertaining to the map. */
-class Map
+/*! \brief Where the cells of a map are in a caller buffer, and which ones are passable.
+ *
+ *  By default, the map is packed : nWidth*nHeight bytes, row after row, 0 for impassable cells.
+ *  Maps inside larger images or multi-channel buffers are read in place by setting the fields :
+ *  ex: MapView view(pRgba + 3, 1920, 1080);  // alpha channel of an RGBA image
+ *      view.cellStride = 4;
+ *      view.rowPitch = 1920*4;
+ *      view.threshold = 128;
+ *      FindPath(0, 0, 99, 99, view.subView(400, 300, 100, 100), pOutBuffer, nOutBufferSize);
+ */
+struct MapView
+{
+  MapView(const unsigned char* pOrigin, const int nWidth, const int nHeight):
+    pOrigin(pOrigin), width(nWidth), height(nHeight), rowPitch(nWidth) {}
+
+  /*! \brief View of the nWidth x nHeight cells whose top left cell is (x, y) in this view.
+   *         The rectangle must be inside this view.
+   */
+  MapView subView(const int x, const int y, const int nWidth, const int nHeight) const
+  {
+    MapView view = *this;
+    view.pOrigin = pOrigin + y*rowPitch + (ptrdiff_t)x*cellStride;
+    view.width = nWidth;
+    view.height = nHeight;
+    return view;
+  }
+  /*! \brief nWidth*nHeight bytes, row after row, passable if not 0 : the FindPath() map */
+  bool isPacked() const { return rowPitch == width && cellStride == 1 && threshold == 1; }
+
+  const unsigned char* pOrigin;  //!< byte of the cell (0, 0) : buffer, plus the offsets of the origin and of the channel
+  int width, height;             //!< in cells
+  ptrdiff_t rowPitch;            //!< bytes from a cell to the one below, negative for bottom-up images
+  int cellStride = 1;            //!< bytes from a cell to the one on its right : the number of channels
+  unsigned char threshold = 1;   //!< a cell is passable if its byte is at least the threshold
+};
+
+/*! \brief Connectivity policy of BasicMap : the 4 orthogonal moves.
+ *
+ *  A connectivity policy gives the moves from a cell, as offsets, in the order findNeighbors()
+ *  returns them. Its functions are static, or members of a policy object given to BasicMap
+ *  when they depend on runtime data.
+ */
+struct FourConnected
+{
+  static const int MAX_NEIGHBORS = 4;
+  // up, down, left, right
+  static constexpr int DX[MAX_NEIGHBORS] = { 0, 0, -1, 1};
+  static constexpr int DY[MAX_NEIGHBORS] = {-1, 1,  0, 0};
+
+  static constexpr int directionCount() { return MAX_NEIGHBORS; }
+  static constexpr int dx(const int direction) { return DX[direction]; }
+  static constexpr int dy(const int direction) { return DY[direction]; }
+  static constexpr bool isDiagonal(const int) { return false; }
+};
+
+/*! \brief Connectivity policy of BasicMap : the 4 orthogonal moves, then the 4 diagonal ones.
+ *
+ *  A diagonal move does not cut corners : both orthogonal cells it passes by must be passable.
+ */
+struct EightConnected
+{
+  static const int MAX_NEIGHBORS = 8;
+  // up, down, left, right, then up-left, up-right, down-left, down-right
+  static constexpr int DX[MAX_NEIGHBORS] = { 0, 0, -1, 1, -1,  1, -1, 1};
+  static constexpr int DY[MAX_NEIGHBORS] = {-1, 1,  0, 0, -1, -1,  1, 1};
+
+  static constexpr int directionCount() { return MAX_NEIGHBORS; }
+  static constexpr int dx(const int direction) { return DX[direction]; }
+  static constexpr int dy(const int direction) { return DY[direction]; }
+  static constexpr bool isDiagonal(const int direction) { return direction >= 4; }
+};
+
+/*! \brief Class describing and providing all operations pertaining to the map.
+ *
+ *  The moves between cells are given by the Connectivity policy : with static policies, the
+ *  neighbor loop is unrolled and the diagonal checks disappear from 4-connected maps.
+ *  Everything is inline : each search inlines the map of its instantiation.
+ */
+template<class Connectivity>
+class BasicMap : private Connectivity  // empty base : a static policy takes no room
 {
   public:
-  Map(const unsigned char* pMap, const int nMapWidth, const int nMapHeight): 
-    _pMap(pMap), _mapWidth(nMapWidth), _mapHeight(nMapHeight){}
+  static const int MAX_NEIGHBORS = Connectivity::MAX_NEIGHBORS;
 
-  const list<Coordinates> findNeighbors(const Coordinates& cell) const;
+  BasicMap(const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+           const Connectivity& connectivity = Connectivity()):
+    Connectivity(connectivity),
+    _pMap(pMap), _mapWidth(nMapWidth), _mapHeight(nMapHeight), _rowPitch(nMapWidth), _cellStride(1), _threshold(1) {}
+  explicit BasicMap(const MapView& view, const Connectivity& connectivity = Connectivity()):
+    Connectivity(connectivity),
+    _pMap(view.pOrigin), _mapWidth(view.width), _mapHeight(view.height),
+    _rowPitch(view.rowPitch), _cellStride(view.cellStride), _threshold(view.threshold) {}
 
-  bool isCellOutOfBounds(const Coordinates& coordCell) const;
-  bool isCellOk(const Coordinates& coordCell) const;
+  const list<Coordinates> findNeighbors(const Coordinates& cell) const
+  {
+    Coordinates neighbors[MAX_NEIGHBORS];
+    const int nbNeighbors = findNeighbors(cell, neighbors);
+    return list<Coordinates>(neighbors, neighbors + nbNeighbors);
+  }
+  int findNeighbors(const Coordinates& cell, Coordinates outputNeighbors[MAX_NEIGHBORS]) const
+  {
+    int nbNeighbors = 0;
+    for (int direction = 0; direction < this->directionCount(); ++direction)
+    {
+      const Coordinates neighbor(cell.X + this->dx(direction), cell.Y + this->dy(direction));
+      if (!isCellOk(neighbor)) { continue; }
+      if (this->isDiagonal(direction) &&
+          (!isCellOk(Coordinates(neighbor.X, cell.Y)) || !isCellOk(Coordinates(cell.X, neighbor.Y))))
+      {
+        continue;
+      }
+      outputNeighbors[nbNeighbors++] = neighbor;
+    }
+    return nbNeighbors;
+  }
 
-  int coordinatesToIndex(const Coordinates& coordinates) const;
-  const Coordinates indexToCoordinates(const int index) const;
-  int distance(const Coordinates& cellA, const Coordinates& cellB) const;
+  bool isCellOutOfBounds(const Coordinates& coordCell) const
+  {
+    return (coordCell.X < 0 || coordCell.X >= _mapWidth ||
+            coordCell.Y < 0 || coordCell.Y >= _mapHeight);
+  }
+  bool isCellOk(const Coordinates& coordCell) const
+  {
+    // check if cell is out of bounds
+    if (isCellOutOfBounds(coordCell)) { return false; }
+    // check if cell is impassable
+    return _pMap[coordCell.Y*_rowPitch + (ptrdiff_t)coordCell.X*_cellStride] >= _threshold;
+  }
+
+  int coordinatesToIndex(const Coordinates& coordinates) const
+  {
+    assert(!isCellOutOfBounds(coordinates));
+    return (coordinates.Y*_mapWidth + coordinates.X);
+  }
+  const Coordinates indexToCoordinates(const int index) const
+  {
+    assert(index>=0 && index < _mapWidth*_mapHeight);
+    return Coordinates(index % _mapWidth, index / _mapWidth);
+  }
+  /*! \brief Manhattan distance, ignoring obstacles */
+  int distance(const Coordinates& cellA, const Coordinates& cellB) const
+  {
+    return (abs(cellA.X-cellB.X) + abs(cellA.Y-cellB.Y));
+  }
+  int width() const { return _mapWidth; }
+  int height() const { return _mapHeight; }
+  int cellCount() const { return _mapWidth*_mapHeight; }
+  const MapView view() const
+  {
+    MapView view(_pMap, _mapWidth, _mapHeight);
+    view.rowPitch = _rowPitch;
+    view.cellStride = _cellStride;
+    view.threshold = _threshold;
+    return view;
+  }
+  const Connectivity& connectivity() const { return *this; }
 
   private:
+  // the index of a cell in the search is always row-major in the view (coordinatesToIndex()) :
+  // the pitch, stride and threshold only change where and how its byte is read
   const unsigned char* _pMap;
   int _mapWidth, _mapHeight;
+  ptrdiff_t _rowPitch;
+  int _cellStride;
+  unsigned char _threshold;
+};
+
+/*! \brief The map of FindPath() and of every engine : 4-connected */
+typedef BasicMap<FourConnected> Map;
+
+/*! \brief Policy used to order cells having the same priority in the open list.
+ *
+ *  On open maps, whole plateaus of cells share the same priority score (f = g + h).
+ *  The tie-break policy decides which one of them is expanded first.
+ */
+enum class TieBreak
+{
+  Fifo,     //!< first inserted, first dequeued
+  Lifo,     //!< last inserted, first dequeued
+  HigherG,  //!< prefer the cell with higher cost from Start, i.e. deeper in the search (default)
+  LowerH    //!< prefer the cell with lower heuristics, i.e. closer to Target
+};
+
+/*! \brief Per cell search state of Pathfinder.
+ *
+ *  The dense layout keeps for each cell its parent index and its cost from Start (8 bytes),
+ *  and an indexed open list (4 more bytes). The compact one keeps 3 bits per cell : the
+ *  direction of the parent on 2 bits and the closed flag. Costs from Start are only stored
+ *  in the open list, whose stale entries are skipped when dequeued instead of being updated.
+ *  The sparse one only stores the cells reached by the search, in a SparseSearchState.
+ */
+enum class SearchLayout
+{
+  Dense,     //!< fastest for queries reaching a large part of the map
+  Compact,   //!< about 30 times less memory per cell, for very large maps
+  Sparse,    //!< memory proportional to the cells reached, for short queries on large maps
+  Automatic  //!< Sparse when the query is short for the size of the map, else Dense (default)
+};
+
+/*! \brief Conditions to abandon a search before its end : cancellation flag and deadline.
+ *
+ *  The search loop checks them every CHECK_PERIOD expansions, so a stopped search
+ *  releases its thread quickly without paying a clock read per expansion.
+ */
+struct StopCondition
+{
+  static const int CHECK_PERIOD = 1024;
+
+  const atomic<bool>* cancelled = nullptr;  //!< no cancellation if nullptr
+  chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+
+  FindPathStatus check() const
+  {
+    if (cancelled != nullptr && cancelled->load(memory_order_relaxed)) { return FindPathStatus::Cancelled; }
+    if (deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= deadline)
+    {
+      return FindPathStatus::DeadlineExceeded;
+    }
+    return FindPathStatus::Ok;
+  }
 };
 
 /*! \brief Central class that will process A* algorythm to find shortest path  */
@@ -93,22 +387,134 @@ class Pathfinder
   Pathfinder(const int nStartX, const int nStartY,
              const int nTargetX, const int nTargetY, 
              const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
-             int* pOutBuffer, const int nOutBufferSize):
+             int* pOutBuffer, const int nOutBufferSize,
+             const TieBreak tieBreak = TieBreak::HigherG,
+             const SearchLayout layout = SearchLayout::Automatic):
              _start(nStartX, nStartY), _target(nTargetX, nTargetY),
              _map(pMap, nMapWidth, nMapHeight),
-             _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize)
+             _outBuffer(pOutBuffer), _outBufferSize(nOutBufferSize),
+             _tieBreak(tieBreak), _layout(layout), _prepared(nullptr), _tiled(false),
+             _stopCondition(nullptr), _stopStatus(FindPathStatus::Ok)
              {}
+  /*! \brief Search on a PreparedMap, using its preprocessed arrays */
+  Pathfinder(const int nStartX, const int nStartY,
+             const int nTargetX, const int nTargetY,
+             const PreparedMap& preparedMap,
+             int* pOutBuffer, const int nOutBufferSize,
+             const TieBreak tieBreak = TieBreak::HigherG,
+             const SearchLayout layout = SearchLayout::Automatic);
+
+  /*! \brief Find the shortest path and fill the output buffer.
+   *
+   *  \param pStats if not nullptr, filled with statistics about this search.
+   */
+  int findPath(SearchStats* pStats = nullptr);
 
-  int findPath();
+  /*! \brief Same as findPath(), reporting bad input as a status code instead of an exception. */
+  FindPathStatus findPathNoExcept(int* pLength, SearchStats* pStats = nullptr) noexcept;
+
+  /*! \brief Check Start and Target are passable (the rest is checked by checkQueryInput()) */
+  FindPathStatus checkInput() const;
+
+  /*! \brief Layout used by the search : the one given at construction, or the one chosen for SearchLayout::Automatic */
+  SearchLayout layout() const;
+
+  /*! \brief Abandon the search when the condition is met : findPathNoExcept() then returns
+   *         FindPathStatus::Cancelled or DeadlineExceeded (findPath() returns -1).
+   *         nullptr (default) for no condition. The condition must outlive the search.
+   */
+  void setStopCondition(const StopCondition* stopCondition) { _stopCondition = stopCondition; }
 
   private:
-  const map<Coordinates, Coordinates> Astar() const;
-  int convertToOutput(const map<Coordinates, Coordinates>& shortestPathMap);
+  int search(SearchStats* pStats);
+  template<class Collector>
+  int search(Collector& collector);
+  template<class Collector>
+  int runSearch(Collector& collector);
+  // the dense and sparse layouts : BasicPathfinder with this state layout
+  template<class StateLayout, class Collector>
+  int basicSearch(Collector& collector);
+  template<class Collector>
+  const ArenaVector<unsigned char> compactAstar(Collector& collector);
+  int convertDirectionsToOutput(const ArenaVector<unsigned char>& parentDirections);
+  bool isCellOk(const Coordinates& coordCell) const;
+  // index of the cells in the dense and compact search states : the prepared map's cell index if tiled, else row-major
+  int stateIndex(const Coordinates& coordCell) const;
+  const Coordinates stateCoordinates(const int index) const;
+  int stateSize() const;
 
   Coordinates _start, _target;
   Map _map;
   int* _outBuffer;
   int _outBufferSize;
+  TieBreak _tieBreak;
+  SearchLayout _layout;
+  const PreparedMap* _prepared;  // nullptr when there is no preprocessing to use
+  bool _tiled;                   // _prepared has PrepareOptions::tiledLayout
+  const StopCondition* _stopCondition;
+  FindPathStatus _stopStatus;    // why the last search was stopped, Ok if it was not
+};
+
+/*! \brief Statistics about a single query, see FindPath(..., SearchStats* pStats).
+ *
+ *  Counters are reset at the beginning of each query.
+ *  A re-expansion is the expansion of a cell which had already been expanded:
+ *  it cannot happen with Pathfinder's A* (closed cells are final), but the counter
+ *  is shared with engines which may re-open cells.
+ */
+struct SearchStats
+{
+  long long nodesExpanded = 0;     //!< cells dequeued from the open list and expanded
+  long long nodesGenerated = 0;    //!< neighbors examined from expanded cells
+  long long peakOpenListSize = 0;  //!< maximum number of cells in the open list at once
+  long long reExpansions = 0;      //!< expansions of an already expanded cell
+  long long bytesAllocated = 0;    //!< memory allocated for the search state
+  double searchMicroseconds = 0;   //!< time spent in the search itself
+  double outputMicroseconds = 0;   //!< time spent backtracking the path into the output buffer
+};
+
+/*! \brief Statistics collector doing nothing, used when no statistics are requested.
+ *
+ *  Search loops are templates on the collector: with this one every call is an
+ *  empty inline function, so the loop compiles exactly as if it had no statistics.
+ */
+struct NoStatsCollector
+{
+  inline void expanded() {}
+  inline void reExpanded() {}
+  inline void generated() {}
+  inline void openListSize(const size_t) {}
+  inline void allocated(const size_t) {}
+  inline void startSearch() {}
+  inline void endSearch() {}
+  inline void startOutput() {}
+  inline void endOutput() {}
+};
+
+/*! \brief Statistics collector filling a SearchStats. */
+class StatsCollector
+{
+  public:
+  StatsCollector(SearchStats& stats): _stats(stats) { _stats = SearchStats(); }
+
+  inline void expanded()   { ++_stats.nodesExpanded; }
+  inline void reExpanded() { ++_stats.reExpansions; }
+  inline void generated()  { ++_stats.nodesGenerated; }
+  inline void openListSize(const size_t size) { _stats.peakOpenListSize = max(_stats.peakOpenListSize, (long long)size); }
+  inline void allocated(const size_t bytes)   { _stats.bytesAllocated += (long long)bytes; }
+  inline void startSearch() { _startTime = chrono::steady_clock::now(); }
+  inline void endSearch()   { _stats.searchMicroseconds += elapsedMicroseconds(); }
+  inline void startOutput() { _startTime = chrono::steady_clock::now(); }
+  inline void endOutput()   { _stats.outputMicroseconds += elapsedMicroseconds(); }
+
+  private:
+  double elapsedMicroseconds() const
+  {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - _startTime).count();
+  }
+
+  SearchStats& _stats;
+  chrono::steady_clock::time_point _startTime;
 };
 
 /*! \brief Exception to return if the input does not respect the rules  */
@@ -124,33 +530,153 @@ public:
     }
 };
 
+/*! \brief Ordering key of an item in the open list.
+ *
+ *  Items are sorted by priority, then by the tie-break value computed from the
+ *  TieBreak policy, then by insertion order - which makes the order fully deterministic.
+ */
+struct QueueKey
+{
+  int priority;
+  int tiebreak;
+  long long order;
+};
+bool operator<(const QueueKey& lhs, const QueueKey& rhs);
+QueueKey makeQueueKey(const TieBreak tieBreak, const int priority, const int costFromStart, const long long order);
+
 /*! \brief Override std::priority_queue, to be more user-friendly in code
  *
- *  in case of tie, the queue has a FIFO dequeue order.
+ *  in case of tie, the queue follows the TieBreak policy given at construction
+ *  (FIFO dequeue order by default).
  *  ex: PriorityQueue<Coordinates> q;
  *  to enqueue : q.put(Coordinates(0,0), 12);  where 12 is the priority
+ *  to enqueue with the cost from Start, used by HigherG and LowerH policies :
+ *               q.put(Coordinates(0,0), 12, 5);
  *  to dequeue item with lower priority : Coordinates coord = q.dequeue();
+ *  The elements are allocated in the given arena, or on the heap if it is nullptr.
  */
-bool operator<(const pair<int, time_t>& lhs, const pair<int, time_t>& rhs);
 template<typename T>
 struct PriorityQueue {
-  typedef pair< pair<int, time_t>, T> PQElement;
-  priority_queue<PQElement, vector<PQElement>,
-                 greater<PQElement>> elements;
+  struct PQElement {
+    QueueKey key;
+    T item;
+  };
+  struct Later {
+    bool operator()(const PQElement& lhs, const PQElement& rhs) const { return rhs.key < lhs.key; }
+  };
+  priority_queue<PQElement, ArenaVector<PQElement>, Later> elements;
+  TieBreak tieBreak;
+  long long counter;
+
+  PriorityQueue(const TieBreak tieBreak = TieBreak::Fifo, Arena* arena = nullptr):
+    elements(Later(), ArenaVector<PQElement>(ArenaAllocator<PQElement>(arena))), tieBreak(tieBreak), counter(0) {}
 
   inline bool empty() const {
      return elements.empty();
   }
 
+  inline size_t size() const {
+     return elements.size();
+  }
+
   inline void put(T item, int priority) {
-    time_t tiebreaker = time(nullptr);
-    pair<int, time_t> priopair = {priority, tiebreaker};
-    elements.emplace(priopair, item);
+    put(item, priority, 0);
+  }
+
+  inline void put(T item, int priority, int costFromStart) {
+    elements.push(PQElement{makeQueueKey(tieBreak, priority, costFromStart, counter++), item});
   }
 
   T dequeue() {
-    T best_item = elements.top().second;
+    T best_item = elements.top().item;
     elements.pop();
     return best_item;
   }
-};
\ No newline at end of file
+};
+
+/*! \brief Indexed 4-ary min-heap on cell indexes, with in-place decrease-key.
+ *
+ *  Each cell index in [0, capacity) is at most once in the heap: its position is
+ *  tracked, so an improved priority moves the existing entry up instead of
+ *  pushing a duplicate. Ties are broken with the same QueueKey as PriorityQueue.
+ *  ex: IndexedHeap q(mapSize);
+ *  to enqueue or improve : q.put(index, 12, 5);  where 12 is the priority, 5 the cost from Start
+ *  to dequeue index with lower priority : int index = q.dequeue();
+ *  The heap is allocated in the given arena, or on the heap if it is nullptr.
+ */
+class IndexedHeap
+{
+  public:
+  static const int ARITY = 4;
+
+  IndexedHeap(const int capacity, const TieBreak tieBreak = TieBreak::Fifo, Arena* arena = nullptr):
+    _elements(ArenaAllocator<HeapElement>(arena)), _positions(capacity, -1, ArenaAllocator<int>(arena)),
+    _visitStack(ArenaAllocator<int>(arena)), _tieBreak(tieBreak), _counter(0) {}
+
+  bool empty() const { return _elements.empty(); }
+  size_t size() const { return _elements.size(); }
+  bool contains(const int index) const { return _positions[index] >= 0; }
+  /*! \brief Index dequeued next. The heap must not be empty */
+  int top() const { return _elements.front().index; }
+  /*! \brief Priority of the index dequeued next. The heap must not be empty */
+  int topPriority() const { return _elements.front().key.priority; }
+  size_t bytesAllocated() const
+  {
+    return _elements.capacity()*sizeof(HeapElement) + _positions.capacity()*sizeof(int) + _visitStack.capacity()*sizeof(int);
+  }
+
+  /*! \brief Reserve room for size indexes : no allocation while the heap stays smaller */
+  void reserve(const size_t size) { _elements.reserve(size); }
+  /*! \brief Memory needed per index of the capacity, when the heap is full */
+  static size_t bytesPerIndex();
+  /*! \brief Accept indexes in [0, capacity) : the capacity can only grow */
+  void growCapacity(const int capacity) { if (capacity > (int)_positions.size()) { _positions.resize(capacity, -1); } }
+
+  void put(const int index, const int priority, const int costFromStart);
+  int dequeue();
+  /*! \brief Remove an index from the heap, wherever it is. It must be in the heap */
+  void remove(const int index);
+
+  /*! \brief Call visit(index) for every index whose priority is at most maxPriority.
+   *
+   *  Subtrees of the heap above maxPriority are skipped : the cost is proportional to the
+   *  number of visited indexes, not to the heap size. The stack of positions to visit is kept
+   *  from a call to the next : it allocates only when it grows. visit must not modify the heap.
+   */
+  template<class Visitor>
+  void visitUpTo(const int maxPriority, Visitor visit)
+  {
+    if (_elements.empty()) { return; }
+    _visitStack.clear();
+    _visitStack.push_back(0);
+    while (!_visitStack.empty())
+    {
+      const int position = _visitStack.back();
+      _visitStack.pop_back();
+      if (_elements[position].key.priority > maxPriority) { continue; }
+      visit(_elements[position].index);
+      const int firstChild = position * ARITY + 1;
+      for (int child = firstChild; child < firstChild + ARITY && child < (int)_elements.size(); ++child)
+      {
+        _visitStack.push_back(child);
+      }
+    }
+  }
+
+  private:
+  struct HeapElement
+  {
+    QueueKey key;
+    int index;
+  };
+
+  void siftUp(int position);
+  void siftDown(int position);
+  void place(const HeapElement& element, const int position);
+
+  ArenaVector<HeapElement> _elements;
+  ArenaVector<int> _positions;  // position in _elements of each cell index, -1 if absent
+  ArenaVector<int> _visitStack; // positions left to visit by visitUpTo()
+  TieBreak _tieBreak;
+  long long _counter;
+};
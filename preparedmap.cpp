@@ -0,0 +1,300 @@
+#include "preparedmap.hpp"
+#include "fixedmap.hpp"
+#include <cassert>
+#include <climits>
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+const unsigned char PreparedMap::NEIGHBOR_UP;
+const unsigned char PreparedMap::NEIGHBOR_DOWN;
+const unsigned char PreparedMap::NEIGHBOR_LEFT;
+const unsigned char PreparedMap::NEIGHBOR_RIGHT;
+const int PreparedMap::TILE_BITS;
+const int PreparedMap::TILE_SIZE;
+const int QueryMap::MAX_NEIGHBORS;
+
+PreparedMap::PreparedMap(const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                         const PrepareOptions& options):
+  PreparedMap(MapView(pMap, nMapWidth, nMapHeight), options)
+{
+}
+
+PreparedMap::PreparedMap(const MapView& view, const PrepareOptions& options):
+  _map(view), _mapWidth(view.width), _mapHeight(view.height), _options(options),
+  _tileRowBits(0), _cellCount(0), _arrays{nullptr, nullptr, nullptr, nullptr}
+{
+  throwIfBadInput(checkMapInput(view.width, view.height));
+  initLayout();
+
+  if (_options.padding)       { buildPadding(); }
+  if (_options.bitPacking)    { buildBitPacking(); }
+  if (_options.components)    { buildComponents(); }
+  if (_options.neighborMasks) { buildNeighborMasks(); }
+  _arrays = Arrays{_padded.empty() ? nullptr : _padded.data(), _packed.empty() ? nullptr : _packed.data(),
+                   _components.empty() ? nullptr : _components.data(),
+                   _neighborMasks.empty() ? nullptr : _neighborMasks.data()};
+}
+
+PreparedMap::PreparedMap(const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+                         const PrepareOptions& options, const Arrays& arrays):
+  _map(pMap, nMapWidth, nMapHeight), _mapWidth(nMapWidth), _mapHeight(nMapHeight), _options(options),
+  _tileRowBits(0), _cellCount(0), _arrays(arrays)
+{
+  // checked by MappedMap
+  initLayout();
+}
+
+void PreparedMap::initLayout()
+{
+  // the border, or the tiles, can take a map below 2^31 cells above it : such a map is not padded, or stays row-major
+  if (!fitsPadding(_mapWidth, _mapHeight))     { _options.padding = false; }
+  if (!fitsTiledLayout(_mapWidth, _mapHeight)) { _options.tiledLayout = false; }
+  if (!_options.tiledLayout)
+  {
+    _cellCount = _map.cellCount();
+    return;
+  }
+  _tileRowBits = tileRowBits(_mapWidth);
+  _cellCount = (int)tiledCellCount(_mapWidth, _mapHeight);
+}
+
+int PreparedMap::tileRowBits(const int nMapWidth)
+{
+  int bits = 0;
+  while (((int64_t)TILE_SIZE << bits) < nMapWidth) { ++bits; }
+  return bits;
+}
+
+int64_t PreparedMap::tiledCellCount(const int nMapWidth, const int nMapHeight)
+{
+  const int64_t tileRows = ((int64_t)nMapHeight + TILE_SIZE - 1) / TILE_SIZE;
+  return (tileRows << tileRowBits(nMapWidth)) * TILE_SIZE * TILE_SIZE;
+}
+
+bool PreparedMap::fitsTiledLayout(const int nMapWidth, const int nMapHeight)
+{
+  return tiledCellCount(nMapWidth, nMapHeight) <= INT_MAX;
+}
+
+bool PreparedMap::fitsPadding(const int nMapWidth, const int nMapHeight)
+{
+  return ((int64_t)nMapWidth + 2) * ((int64_t)nMapHeight + 2) <= INT_MAX;
+}
+
+// Small maps without preprocessing are searched by a FixedPathfinder, its state on the stack : the smallest
+// instantiation the map fits in, so that a small map does not initialize the rows of a larger one.
+// query(pathfinder) is run on it, and its result set in *pResult. false if the map does not fit.
+template<class Result, class Query>
+static bool queryFixedMap(const PreparedMap& preparedMap,
+                          const int nStartX, const int nStartY,
+                          const int nTargetX, const int nTargetY,
+                          int* pOutBuffer, const int nOutBufferSize,
+                          const Query& query, Result* pResult)
+{
+  if (preparedMap.hasPreprocessing() || preparedMap.options().tiledLayout)
+  {
+    return false;
+  }
+  const Map& map = preparedMap.getMap();
+  if (FixedMap<32, 32>::fits(map.width(), map.height()))
+  {
+    FixedPathfinder<32, 32> pathfinder(nStartX, nStartY, nTargetX, nTargetY, map, pOutBuffer, nOutBufferSize);
+    *pResult = query(pathfinder);
+    return true;
+  }
+  if (FixedMap<64, 64>::fits(map.width(), map.height()))
+  {
+    FixedPathfinder<64, 64> pathfinder(nStartX, nStartY, nTargetX, nTargetY, map, pOutBuffer, nOutBufferSize);
+    *pResult = query(pathfinder);
+    return true;
+  }
+  return false;
+}
+
+int PreparedMap::findPath(const int nStartX, const int nStartY,
+                          const int nTargetX, const int nTargetY,
+                          int* pOutBuffer, const int nOutBufferSize,
+                          SearchStats* pStats) const
+{
+  throwIfBadInput(checkQueryInput(nStartX, nStartY, nTargetX, nTargetY, _mapWidth, _mapHeight, nOutBufferSize));
+
+  int length = -1;
+  if (queryFixedMap(*this, nStartX, nStartY, nTargetX, nTargetY, pOutBuffer, nOutBufferSize,
+                    [&](auto& pathfinder) { return pathfinder.findPath(pStats); }, &length))
+  {
+    return length;
+  }
+  Pathfinder pathfinder(nStartX, nStartY, nTargetX, nTargetY, *this, pOutBuffer, nOutBufferSize);
+  return pathfinder.findPath(pStats);
+}
+
+FindPathStatus PreparedMap::findPathNoExcept(const int nStartX, const int nStartY,
+                                             const int nTargetX, const int nTargetY,
+                                             int* pOutBuffer, const int nOutBufferSize,
+                                             int* pLength, SearchStats* pStats) const noexcept
+{
+  const FindPathStatus status = checkQueryInput(nStartX, nStartY, nTargetX, nTargetY, _mapWidth, _mapHeight, nOutBufferSize);
+  if (status != FindPathStatus::Ok) { return status; }
+
+  FindPathStatus fixedStatus = FindPathStatus::Ok;
+  if (queryFixedMap(*this, nStartX, nStartY, nTargetX, nTargetY, pOutBuffer, nOutBufferSize,
+                    [&](auto& pathfinder) { return pathfinder.findPathNoExcept(pLength, pStats); }, &fixedStatus))
+  {
+    return fixedStatus;
+  }
+  Pathfinder pathfinder(nStartX, nStartY, nTargetX, nTargetY, *this, pOutBuffer, nOutBufferSize);
+  return pathfinder.findPathNoExcept(pLength, pStats);
+}
+
+int PreparedMap::findNeighbors(const Coordinates& cell, Coordinates outputNeighbors[4]) const
+{
+  // same neighbors and same order as Map::findNeighbors()
+  int nbNeighbors = 0;
+  if (_options.neighborMasks)
+  {
+    const unsigned char mask = _arrays.neighborMasks[cellIndex(cell)];
+    if (mask & NEIGHBOR_UP)     outputNeighbors[nbNeighbors++] = Coordinates(cell.X, cell.Y-1);
+    if (mask & NEIGHBOR_DOWN)   outputNeighbors[nbNeighbors++] = Coordinates(cell.X, cell.Y+1);
+    if (mask & NEIGHBOR_LEFT)   outputNeighbors[nbNeighbors++] = Coordinates(cell.X-1, cell.Y);
+    if (mask & NEIGHBOR_RIGHT)  outputNeighbors[nbNeighbors++] = Coordinates(cell.X+1, cell.Y);
+    return nbNeighbors;
+  }
+  if (_options.padding)
+  {
+    // the border is impassable : no bounds check needed
+    const int index = paddedIndex(cell);
+    const int paddedWidth = _mapWidth + 2;
+    if (_arrays.padded[index - paddedWidth])  outputNeighbors[nbNeighbors++] = Coordinates(cell.X, cell.Y-1);
+    if (_arrays.padded[index + paddedWidth])  outputNeighbors[nbNeighbors++] = Coordinates(cell.X, cell.Y+1);
+    if (_arrays.padded[index - 1])            outputNeighbors[nbNeighbors++] = Coordinates(cell.X-1, cell.Y);
+    if (_arrays.padded[index + 1])            outputNeighbors[nbNeighbors++] = Coordinates(cell.X+1, cell.Y);
+    return nbNeighbors;
+  }
+  if (_options.bitPacking)
+  {
+    const Coordinates candidates[4] = {Coordinates(cell.X, cell.Y-1), Coordinates(cell.X, cell.Y+1),
+                                       Coordinates(cell.X-1, cell.Y), Coordinates(cell.X+1, cell.Y)};
+    for (const Coordinates& candidate : candidates)
+    {
+      if (isCellOk(candidate)) { outputNeighbors[nbNeighbors++] = candidate; }
+    }
+    return nbNeighbors;
+  }
+  return _map.findNeighbors(cell, outputNeighbors);
+}
+
+bool PreparedMap::isCellOk(const Coordinates& coordCell) const
+{
+  if (_options.padding)
+  {
+    if (coordCell.X < -1 || coordCell.X > _mapWidth || coordCell.Y < -1 || coordCell.Y > _mapHeight) { return false; }
+    return _arrays.padded[paddedIndex(coordCell)] != 0;
+  }
+  if (_options.bitPacking)
+  {
+    if (_map.isCellOutOfBounds(coordCell)) { return false; }
+    return isPackedCellOk(cellIndex(coordCell));
+  }
+  return _map.isCellOk(coordCell);
+}
+
+int PreparedMap::component(const Coordinates& coordCell) const
+{
+  assert(_options.components);
+  return _arrays.components[cellIndex(coordCell)];
+}
+
+unsigned char PreparedMap::neighborMask(const Coordinates& coordCell) const
+{
+  assert(_options.neighborMasks);
+  return _arrays.neighborMasks[cellIndex(coordCell)];
+}
+
+size_t PreparedMap::bytesAllocated() const
+{
+  return _padded.capacity() + _packed.capacity()*sizeof(uint64_t) +
+         _components.capacity()*sizeof(int) + _neighborMasks.capacity();
+}
+
+void PreparedMap::buildPadding()
+{
+  _padded.assign(((size_t)_mapWidth + 2)*((size_t)_mapHeight + 2), 0);
+  for (int y = 0; y < _mapHeight; ++y)
+  {
+    for (int x = 0; x < _mapWidth; ++x)
+    {
+      const Coordinates cell(x, y);
+      _padded[paddedIndex(cell)] = _map.isCellOk(cell) ? 1 : 0;
+    }
+  }
+}
+
+void PreparedMap::buildBitPacking()
+{
+  _packed.assign(((size_t)_cellCount + 63) / 64, 0);
+  for (int y = 0; y < _mapHeight; ++y)
+  {
+    for (int x = 0; x < _mapWidth; ++x)
+    {
+      const Coordinates cell(x, y);
+      if (_map.isCellOk(cell))
+      {
+        const int index = cellIndex(cell);
+        _packed[index >> 6] |= (uint64_t)1 << (index & 63);
+      }
+    }
+  }
+}
+
+void PreparedMap::buildComponents()
+{
+  // flood fill from each passable cell not labelled yet, with an explicit stack
+  // (cells of the last tiles out of the map keep label 0)
+  const int mapSize = _map.cellCount();
+  _components.assign(_cellCount, 0);
+  int nbComponents = 0;
+  vector<int> stack;
+  for (int seedIndex = 0; seedIndex < mapSize; ++seedIndex)
+  {
+    const Coordinates seedCell = _map.indexToCoordinates(seedIndex);
+    const int seed = cellIndex(seedCell);
+    if (_components[seed] != 0 || !_map.isCellOk(seedCell)) { continue; }
+    ++nbComponents;
+    _components[seed] = nbComponents;
+    stack.push_back(seed);
+    while (!stack.empty())
+    {
+      const Coordinates cell = cellCoordinates(stack.back());
+      stack.pop_back();
+      Coordinates neighbors[4];
+      const int nbNeighbors = _map.findNeighbors(cell, neighbors);
+      for (int i = 0; i < nbNeighbors; ++i)
+      {
+        const int neighborIndex = cellIndex(neighbors[i]);
+        if (_components[neighborIndex] == 0)
+        {
+          _components[neighborIndex] = nbComponents;
+          stack.push_back(neighborIndex);
+        }
+      }
+    }
+  }
+}
+
+void PreparedMap::buildNeighborMasks()
+{
+  const int mapSize = _map.cellCount();
+  _neighborMasks.assign(_cellCount, 0);
+  for (int index = 0; index < mapSize; ++index)
+  {
+    const Coordinates cell = _map.indexToCoordinates(index);
+    unsigned char mask = 0;
+    if (_map.isCellOk(Coordinates(cell.X, cell.Y-1)))  mask |= NEIGHBOR_UP;
+    if (_map.isCellOk(Coordinates(cell.X, cell.Y+1)))  mask |= NEIGHBOR_DOWN;
+    if (_map.isCellOk(Coordinates(cell.X-1, cell.Y)))  mask |= NEIGHBOR_LEFT;
+    if (_map.isCellOk(Coordinates(cell.X+1, cell.Y)))  mask |= NEIGHBOR_RIGHT;
+    _neighborMasks[cellIndex(cell)] = mask;
+  }
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "pathfinder.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Prepared map
+// ############################################################################
+
+/*! \brief Optional preprocessing done once by PreparedMap.
+ *
+ *  Every option costs memory and construction time, and makes each query cheaper.
+ */
+struct PrepareOptions
+{
+  bool padding = false;        //!< copy the map with a border of impassable cells : no bounds check while searching.
+                               //!< Cleared in PreparedMap::options() when !PreparedMap::fitsPadding()
+  bool bitPacking = false;     //!< copy the map with 1 bit per cell instead of 1 byte
+  bool components = false;     //!< label connected components : unreachable Target is answered without search
+  bool neighborMasks = false;  //!< store the 4 passable neighbors of each cell as a 4-bit mask
+  bool tiledLayout = false;    //!< order cells by tiles in the arrays above and in the search state, see PreparedMap::cellIndex().
+                               //!< Cleared in PreparedMap::options() when !PreparedMap::fitsTiledLayout()
+};
+
+/*! \brief Map validated and preprocessed once, to answer many queries.
+ *
+ *  The input map must outlive the PreparedMap, which does not copy it
+ *  (only the preprocessed arrays are owned).
+ *  Queries are const and reentrant : a PreparedMap can be shared by several threads.
+ *  ex: PreparedMap prepared(pMap, 100, 100, options);
+ *      int length = prepared.findPath(0, 0, 99, 99, pOutBuffer, nOutBufferSize);
+ */
+class PreparedMap
+{
+  public:
+  static const unsigned char NEIGHBOR_UP    = 1;
+  static const unsigned char NEIGHBOR_DOWN  = 2;
+  static const unsigned char NEIGHBOR_LEFT  = 4;
+  static const unsigned char NEIGHBOR_RIGHT = 8;
+
+  /*! \throw BadInputException if 1≤nMapWidth,nMapHeight is not respected */
+  PreparedMap(const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+              const PrepareOptions& options = PrepareOptions());
+  /*! \brief Map read in place from a view of a caller buffer, see MapView.
+   *         The preprocessed arrays do not depend on the view : with padding or bitPacking, queries do not read it.
+   *  \throw BadInputException if 1≤view.width,view.height is not respected
+   */
+  explicit PreparedMap(const MapView& view, const PrepareOptions& options = PrepareOptions());
+  PreparedMap(const PreparedMap&) = delete;
+  PreparedMap& operator=(const PreparedMap&) = delete;
+
+  /*! \brief Same contract as FindPath(), without re-validating the map.
+   *         Without preprocessing, maps of at most 64x64 cells are searched by a FixedPathfinder.
+   */
+  int findPath(const int nStartX, const int nStartY,
+               const int nTargetX, const int nTargetY,
+               int* pOutBuffer, const int nOutBufferSize,
+               SearchStats* pStats = nullptr) const;
+
+  /*! \brief Same contract as FindPathNoExcept(), without re-validating the map */
+  FindPathStatus findPathNoExcept(const int nStartX, const int nStartY,
+                                  const int nTargetX, const int nTargetY,
+                                  int* pOutBuffer, const int nOutBufferSize,
+                                  int* pLength, SearchStats* pStats = nullptr) const noexcept;
+
+  const Map& getMap() const { return _map; }
+  int width() const { return _mapWidth; }
+  int height() const { return _mapHeight; }
+  const PrepareOptions& options() const { return _options; }
+  /*! \brief Do queries read preprocessed arrays ? Without any, the plain Map of getMap() is faster */
+  bool hasPreprocessing() const
+  {
+    return _options.padding || _options.bitPacking || _options.components || _options.neighborMasks;
+  }
+
+  /*! \brief Same as Map::findNeighbors(), using the preprocessed arrays if any */
+  int findNeighbors(const Coordinates& cell, Coordinates outputNeighbors[4]) const;
+
+  bool isCellOk(const Coordinates& coordCell) const;
+  /*! \brief Connected component of a cell, 0 for impassable cells. Requires options.components */
+  int component(const Coordinates& coordCell) const;
+  /*! \brief NEIGHBOR_* bits of the passable neighbors. Requires options.neighborMasks */
+  unsigned char neighborMask(const Coordinates& coordCell) const;
+
+  /*! \brief Index of a cell in the preprocessed arrays and in the dense search state.
+   *
+   *  Row-major by default : the cells above and below are a whole row away, i.e. in another
+   *  cache line, and on wide maps in another page. With options.tiledLayout, the map is cut
+   *  in TILE_SIZE x TILE_SIZE tiles stored one after the other, and the cells of a tile are
+   *  in Z-order : most vertical neighbors are in the same cache line, and a page holds a
+   *  square area of the map.
+   */
+  int cellIndex(const Coordinates& coordCell) const
+  {
+    if (!_options.tiledLayout) { return _map.coordinatesToIndex(coordCell); }
+    const int tile = ((coordCell.Y >> TILE_BITS) << _tileRowBits) | (coordCell.X >> TILE_BITS);
+    return (tile << (2*TILE_BITS)) | interleaveBits(coordCell.X & (TILE_SIZE-1), coordCell.Y & (TILE_SIZE-1));
+  }
+  const Coordinates cellCoordinates(const int index) const
+  {
+    if (!_options.tiledLayout) { return _map.indexToCoordinates(index); }
+    const int tile = index >> (2*TILE_BITS);
+    return Coordinates(((tile & ((1 << _tileRowBits) - 1)) << TILE_BITS) | deinterleaveBits(index),
+                       ((tile >> _tileRowBits) << TILE_BITS) | deinterleaveBits(index >> 1));
+  }
+  /*! \brief Size of the arrays indexed by cellIndex() : with tiles, the map is rounded up to whole tiles,
+   *         and its number of tiles per row to a power of 2 (no division to find the coordinates of an index)
+   */
+  int cellCount() const { return _cellCount; }
+  /*! \brief false if the tiles of the map, rounded up as above, exceed 2^31 cells : options.tiledLayout is then ignored */
+  static bool fitsTiledLayout(const int nMapWidth, const int nMapHeight);
+  /*! \brief false if the map and its border exceed 2^31 cells : options.padding is then ignored */
+  static bool fitsPadding(const int nMapWidth, const int nMapHeight);
+
+  /*! \brief Memory owned by the preprocessed arrays, 0 when they are in a MappedMap */
+  size_t bytesAllocated() const;
+
+  static const int TILE_BITS = 4;
+  static const int TILE_SIZE = 1 << TILE_BITS;
+
+  private:
+  friend class MappedMap;
+  friend void savePreparedMap(const PreparedMap& preparedMap, const string& path);
+  /*! \brief Preprocessed arrays built elsewhere, not copied : nullptr for the options not set */
+  struct Arrays
+  {
+    const unsigned char* padded;
+    const uint64_t* packed;
+    const int* components;
+    const unsigned char* neighborMasks;
+  };
+  PreparedMap(const unsigned char* pMap, const int nMapWidth, const int nMapHeight,
+              const PrepareOptions& options, const Arrays& arrays);
+  void initLayout();
+  static int tileRowBits(const int nMapWidth);
+  static int64_t tiledCellCount(const int nMapWidth, const int nMapHeight);
+
+  // Z-order of TILE_BITS bits coordinates : x bits on even bits, y bits on odd bits
+  static int interleaveBits(int value)
+  {
+    value = (value | (value << 2)) & 0x33;
+    return (value | (value << 1)) & 0x55;
+  }
+  static int interleaveBits(const int x, const int y) { return interleaveBits(x) | (interleaveBits(y) << 1); }
+  static int deinterleaveBits(int value)
+  {
+    value &= 0x55;
+    value = (value | (value >> 1)) & 0x33;
+    return (value | (value >> 2)) & 0x0F;
+  }
+
+  int paddedIndex(const Coordinates& coordCell) const { return (coordCell.Y+1)*(_mapWidth+2) + coordCell.X+1; }
+  bool isPackedCellOk(const int index) const { return (_arrays.packed[index >> 6] >> (index & 63)) & 1; }
+
+  void buildPadding();
+  void buildBitPacking();
+  void buildComponents();
+  void buildNeighborMasks();
+
+  Map _map;
+  int _mapWidth, _mapHeight;
+  PrepareOptions _options;
+  int _tileRowBits;  // log2 of the number of tiles per row
+  int _cellCount;
+  vector<unsigned char> _padded;        // (width+2)*(height+2), border cells are 0
+  vector<uint64_t> _packed;             // bit i is set if cell i is passable
+  vector<int> _components;              // component label of each cell, 0 if impassable
+  vector<unsigned char> _neighborMasks; // NEIGHBOR_* bits of each cell
+  Arrays _arrays;                       // the arrays read by queries : the vectors above, or a MappedMap's
+};
+
+/*! \brief The map the engines search : the preprocessed arrays of a PreparedMap, or its plain Map when it has none.
+ *
+ *  Same interface as Map for the cells, and the checks and early exits every engine does on its query.
+ */
+class QueryMap
+{
+  public:
+  static const int MAX_NEIGHBORS = Map::MAX_NEIGHBORS;
+
+  QueryMap(const unsigned char* pMap, const int nMapWidth, const int nMapHeight):
+    _map(pMap, nMapWidth, nMapHeight), _prepared(nullptr) {}
+  explicit QueryMap(const PreparedMap& preparedMap):
+    _map(preparedMap.getMap()), _prepared(preparedMap.hasPreprocessing() ? &preparedMap : nullptr) {}
+
+  /*! \brief Same checks as FindPath() on the query, then Start and Target are passable */
+  FindPathStatus checkQuery(const Coordinates& start, const Coordinates& target, const int nOutBufferSize) const
+  {
+    const FindPathStatus status = checkQueryInput(start.X, start.Y, target.X, target.Y, width(), height(), nOutBufferSize);
+    if (status != FindPathStatus::Ok) { return status; }
+    if (!isCellOk(start))  { return FindPathStatus::StartNotPassable; }
+    if (!isCellOk(target)) { return FindPathStatus::TargetNotPassable; }
+    return FindPathStatus::Ok;
+  }
+  /*! \brief false if the connected components of the PreparedMap tell there is no path between the cells */
+  bool mayConnect(const Coordinates& cellA, const Coordinates& cellB) const
+  {
+    return _prepared == nullptr || !_prepared->options().components || _prepared->component(cellA) == _prepared->component(cellB);
+  }
+
+  int findNeighbors(const Coordinates& cell, Coordinates outputNeighbors[MAX_NEIGHBORS]) const
+  {
+    return (_prepared != nullptr) ? _prepared->findNeighbors(cell, outputNeighbors) : _map.findNeighbors(cell, outputNeighbors);
+  }
+  bool isCellOk(const Coordinates& coordCell) const
+  {
+    return (_prepared != nullptr) ? _prepared->isCellOk(coordCell) : _map.isCellOk(coordCell);
+  }
+  bool isCellOutOfBounds(const Coordinates& coordCell) const { return _map.isCellOutOfBounds(coordCell); }
+  int coordinatesToIndex(const Coordinates& coordinates) const { return _map.coordinatesToIndex(coordinates); }
+  const Coordinates indexToCoordinates(const int index) const { return _map.indexToCoordinates(index); }
+  int distance(const Coordinates& cellA, const Coordinates& cellB) const { return _map.distance(cellA, cellB); }
+  int width() const { return _map.width(); }
+  int height() const { return _map.height(); }
+  int cellCount() const { return _map.cellCount(); }
+
+  private:
+  Map _map;
+  const PreparedMap* _prepared;  // nullptr when there is no preprocessing to use
+};
@@ -0,0 +1,62 @@
+#include "sparsesearchstate.hpp"
+
+// ############################################################################
+// ### IMPLEMENTATION
+// ############################################################################
+
+template<typename Cell>
+const Cell BasicSparseSearchState<Cell>::EMPTY;
+
+template<typename Cell>
+BasicSparseSearchState<Cell>::BasicSparseSearchState(const int expectedNodes, Arena* arena):
+  _nodes(ArenaAllocator<Node>(arena)), _slots(ArenaAllocator<Cell>(arena)), _shift(64)
+{
+  size_t slotCount = 16;
+  while (slotCount < 2 * (size_t)expectedNodes) { slotCount *= 2; }
+  _slots.assign(slotCount, EMPTY);
+  for (size_t size = slotCount; size > 1; size /= 2) { --_shift; }
+  _nodes.reserve(slotCount / 2);
+}
+
+template<typename Cell>
+Cell BasicSparseSearchState<Cell>::find(const Cell cell) const
+{
+  // linear probing : the nodes of a cluster are in consecutive slots
+  const size_t mask = _slots.size() - 1;
+  for (size_t slot = slotOf(cell); _slots[slot] != EMPTY; slot = (slot + 1) & mask)
+  {
+    if (_nodes[_slots[slot]].cell == cell) { return _slots[slot]; }
+  }
+  return -1;
+}
+
+template<typename Cell>
+Cell BasicSparseSearchState<Cell>::insert(const Cell cell, const Cell costFromStart, const Cell parent)
+{
+  if (2 * (_nodes.size() + 1) > _slots.size()) { grow(); }
+  const size_t mask = _slots.size() - 1;
+  size_t slot = slotOf(cell);
+  while (_slots[slot] != EMPTY) { slot = (slot + 1) & mask; }
+  const Cell number = (Cell)_nodes.size();
+  _nodes.push_back(Node{cell, costFromStart, parent});
+  _slots[slot] = number;
+  return number;
+}
+
+template<typename Cell>
+void BasicSparseSearchState<Cell>::grow()
+{
+  // only the slots are rebuilt : node numbers do not change
+  _slots.assign(2 * _slots.size(), EMPTY);
+  --_shift;
+  const size_t mask = _slots.size() - 1;
+  for (Cell number = 0; number < (Cell)_nodes.size(); ++number)
+  {
+    size_t slot = slotOf(_nodes[number].cell);
+    while (_slots[slot] != EMPTY) { slot = (slot + 1) & mask; }
+    _slots[slot] = number;
+  }
+}
+
+template class BasicSparseSearchState<int>;
+template class BasicSparseSearchState<int64_t>;
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include "arena.hpp"
+
+using namespace std;
+
+// ############################################################################
+// ### Sparse search state
+// ############################################################################
+
+// The dense search state has an entry per cell of the map, whatever the query : on a
+// 32k x 32k map, gigabytes to answer a query touching a few thousand cells.
+// SparseSearchState only stores the cells reached by the search : its nodes are appended
+// to a single array, in the order they are reached, and found by cell with an open
+// addressing hash table of node numbers. There is no allocation per node, and a node
+// number never changes : it can index an IndexedHeap.
+// Cell indexes, costs and node numbers are ints, or 64-bit integers for maps beyond 2^31
+// cells (LargeMap) : a search reaches each cell once at most, so nodes number as cells do.
+
+/*! \brief Cost from Start and parent of the cells reached by a search, by cell index.
+ *
+ *  ex: SparseSearchState state;
+ *      const int node = state.insert(cellIndex, 12, parentNode);
+ *      state.find(cellIndex) == node;
+ */
+template<typename Cell>
+class BasicSparseSearchState
+{
+  public:
+  /*! \brief A cell reached by the search */
+  struct Node
+  {
+    Cell cell;
+    Cell costFromStart;
+    Cell parent;  // node number, -1 for Start
+  };
+
+  /*! \param expectedNodes nodes stored before the first growth of the table
+   *  \param arena         where the arrays are allocated, on the heap if nullptr
+   */
+  explicit BasicSparseSearchState(const int expectedNodes = 0, Arena* arena = nullptr);
+
+  /*! \brief Node number of a cell, -1 if it is not reached */
+  Cell find(const Cell cell) const;
+  /*! \brief Add a cell, which must not be reached yet, and return its node number */
+  Cell insert(const Cell cell, const Cell costFromStart, const Cell parent);
+
+  Node& node(const Cell number) { return _nodes[number]; }
+  const Node& node(const Cell number) const { return _nodes[number]; }
+  Cell size() const { return (Cell)_nodes.size(); }
+  size_t bytesAllocated() const { return _nodes.capacity()*sizeof(Node) + _slots.capacity()*sizeof(Cell); }
+
+  private:
+  static const Cell EMPTY = -1;
+
+  // Fibonacci hashing : the high bits of the product, so that cells a power of 2 apart - the
+  // rows of a map whose width is a power of 2 - do not fall in the same slots
+  size_t slotOf(const Cell cell) const { return (size_t)(((uint64_t)cell * 0x9E3779B97F4A7C15ull) >> _shift); }
+  void grow();
+
+  ArenaVector<Node> _nodes;
+  ArenaVector<Cell> _slots;  // node number of each slot, EMPTY if none. At most half full
+  int _shift;                // 64 - log2(number of slots)
+};
+
+/*! \brief Search state of Pathfinder's SearchLayout::Sparse */
+typedef BasicSparseSearchState<int> SparseSearchState;
+/*! \brief Search state of FindPathLarge() */
+typedef BasicSparseSearchState<int64_t> LargeSparseSearchState;
@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "catch.hpp"
+#include "../basicpathfinder.hpp"
+
+using namespace std;
+
+/*! \brief A random map, 1 to maxSide cells a side, and a query on it whose Start and Target are passable */
+struct RandomQuery
+{
+  int mapWidth, mapHeight, mapSize;
+  vector<unsigned char> pMap;
+  int startIndex, targetIndex;
+  Coordinates start, target;
+};
+
+/*! \brief The map alone, obstaclePercent % of impassable cells. Drawn with rand() : seed it with srand() */
+inline RandomQuery randomMap(const int maxSide, const int obstaclePercent)
+{
+  RandomQuery query;
+  query.mapWidth  = 1 + rand() % maxSide;
+  query.mapHeight = 1 + rand() % maxSide;
+  query.mapSize = query.mapWidth*query.mapHeight;
+  query.pMap.resize(query.mapSize);
+  for (unsigned char& cell : query.pMap) { cell = (rand() % 100 < obstaclePercent) ? 0 : 1; }
+  return query;
+}
+
+inline void setQuery(RandomQuery& query, const int startIndex, const int targetIndex)
+{
+  query.startIndex = startIndex;
+  query.targetIndex = targetIndex;
+  query.pMap[startIndex] = query.pMap[targetIndex] = 1;
+  query.start = Coordinates(startIndex % query.mapWidth, startIndex / query.mapWidth);
+  query.target = Coordinates(targetIndex % query.mapWidth, targetIndex / query.mapWidth);
+}
+
+/*! \brief Start and Target are random cells */
+inline RandomQuery randomQuery(const int maxSide = 40, const int obstaclePercent = 30)
+{
+  RandomQuery query = randomMap(maxSide, obstaclePercent);
+  const int startIndex  = rand() % query.mapSize;
+  const int targetIndex = rand() % query.mapSize;
+  setQuery(query, startIndex, targetIndex);
+  return query;
+}
+
+/*! \brief From the top-left corner to the bottom-right one */
+inline RandomQuery cornerQuery(const int maxSide = 40, const int obstaclePercent = 30)
+{
+  RandomQuery query = randomMap(maxSide, obstaclePercent);
+  setQuery(query, 0, query.mapSize - 1);
+  return query;
+}
+
+/*! \brief The output is a path of moves to passable cells from start to target. Returns its cost, -1 if there is no path */
+template<class Connectivity = FourConnected, class CostModel = UnitCost, class Index>
+int64_t checkPath(const vector<unsigned char>& pMap, const int mapWidth, const int64_t start, const int64_t target,
+                  const Index* path, const int64_t length)
+{
+  if (length < 0) { return -1; }
+  int64_t previous = start;
+  int64_t pathCost = 0;
+  for (int64_t i = 0; i < length; ++i)
+  {
+    const Coordinates from((int)(previous % mapWidth), (int)(previous / mapWidth));
+    const Coordinates to((int)(path[i] % mapWidth), (int)(path[i] / mapWidth));
+    const int dx = abs(from.X - to.X), dy = abs(from.Y - to.Y);
+    CHECK(((Connectivity::MAX_NEIGHBORS == 4) ? dx + dy : max(dx, dy)) == 1);
+    CHECK(pMap[path[i]] == 1);
+    pathCost += CostModel::moveCost(from, to);
+    previous = path[i];
+  }
+  CHECK(previous == target);
+  return pathCost;
+}
@@ -0,0 +1,113 @@
+#include "catch.hpp"
+#include "randomquery.hpp"
+#include "../anytimepathfinder.hpp"
+#include "../preparedmap.hpp"
+#include <climits>
+#include <cstdlib>
+#include <limits>
+
+using namespace std;
+
+TEST_CASE("AnytimePathfinder - shortest path when the budget is not limited")
+{
+  srand(35);
+  for (int mapIndex = 0; mapIndex < 30; ++mapIndex)
+  {
+    const RandomQuery query = cornerQuery(50);
+    const int mapWidth = query.mapWidth, mapHeight = query.mapHeight;
+    const vector<unsigned char>& pMap = query.pMap;
+    const int size = mapWidth*mapHeight;
+    vector<int> outputBuffer(size);
+
+    const int expectedLength = FindPath(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                                        outputBuffer.data(), size);
+    AnytimePathfinder pathfinder(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                                 outputBuffer.data(), size);
+    REQUIRE(pathfinder.findPath() == expectedLength);
+    CHECK(pathfinder.bound() == 1);
+
+    // each path is shorter than the previous one, and respects its bound
+    int previousLength = INT_MAX;
+    for (const AnytimeSolution& solution : pathfinder.solutions())
+    {
+      CHECK(solution.length <= previousLength);
+      CHECK(solution.length <= solution.bound * expectedLength);
+      CHECK(solution.bound <= solution.weight);
+      previousLength = solution.length;
+    }
+
+    // the output is a valid path, ending on Target
+    checkPath(pMap, mapWidth, query.startIndex, query.targetIndex, outputBuffer.data(), expectedLength);
+  }
+}
+
+TEST_CASE("AnytimePathfinder - first path within the initial weight")
+{
+  // open map with a long wall : the inflated search goes straight to the wall
+  const int mapWidth = 60;
+  const int mapHeight = 60;
+  vector<unsigned char> pMap(mapWidth*mapHeight, 1);
+  for (int y = 0; y < mapHeight - 5; ++y) { pMap[y*mapWidth + 30] = 0; }
+  vector<int> outputBuffer(mapWidth*mapHeight);
+  const int size = (int)outputBuffer.size();
+  const int shortest = FindPath(0, 0, 59, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), size);
+
+  AnytimeOptions options;
+  options.initialWeight = 3;
+  AnytimePathfinder pathfinder(0, 0, 59, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), size, options);
+  CHECK(pathfinder.findPath() == shortest);
+  REQUIRE(!pathfinder.solutions().empty());
+  CHECK(pathfinder.solutions().front().weight == 3);
+  CHECK(pathfinder.solutions().front().length <= 3 * shortest);
+
+  SECTION("budget spent before any path")
+  {
+    options.maxExpansions = 10;
+    AnytimePathfinder limited(0, 0, 59, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), size, options);
+    CHECK(limited.findPath() == -1);
+    CHECK(limited.bound() == numeric_limits<double>::infinity());
+  }
+  SECTION("budget spent after the first path")
+  {
+    options.maxExpansions = pathfinder.solutions().front().nodesExpanded + 1;
+    AnytimePathfinder limited(0, 0, 59, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), size, options);
+    const int length = limited.findPath();
+    CHECK(length == pathfinder.solutions().front().length);
+    CHECK(length <= limited.bound() * shortest);
+    CHECK(limited.bound() <= 3);
+  }
+  SECTION("weight 1 is A*")
+  {
+    options.initialWeight = 1;
+    AnytimePathfinder astar(0, 0, 59, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), size, options);
+    CHECK(astar.findPath() == shortest);
+    CHECK(astar.solutions().size() == 1);
+  }
+}
+
+TEST_CASE("AnytimePathfinder - easy cases and bad input")
+{
+  unsigned char pMap[] = {0, 0, 1,
+                          0, 1, 1,
+                          1, 0, 1};
+  int outputBuffer[9];
+
+  AnytimePathfinder noPath(2, 0, 0, 2, pMap, 3, 3, outputBuffer, 9);
+  CHECK(noPath.findPath() == -1);
+  CHECK(noPath.bound() == 1);
+
+  PrepareOptions options;
+  options.components = true;
+  const PreparedMap prepared(pMap, 3, 3, options);
+  AnytimePathfinder prepNoPath(2, 0, 0, 2, prepared, outputBuffer, 9);
+  CHECK(prepNoPath.findPath() == -1);
+  AnytimePathfinder prepPath(2, 0, 1, 1, prepared, outputBuffer, 9);
+  CHECK(prepPath.findPath() == 2);
+
+  AnytimePathfinder samePlace(2, 2, 2, 2, pMap, 3, 3, outputBuffer, 9);
+  CHECK(samePlace.findPath() == 0);
+
+  CHECK_THROWS_AS(AnytimePathfinder(0, 0, 2, 2, pMap, 3, 3, outputBuffer, 9), BadInputException);
+  CHECK_THROWS_AS(AnytimePathfinder(2, 0, 2, 2, pMap, 0, 3, outputBuffer, 9), BadInputException);
+  CHECK_THROWS_AS(AnytimePathfinder(2, 0, 3, 2, prepared, outputBuffer, 9), BadInputException);
+}
@@ -0,0 +1,97 @@
+#include "catch.hpp"
+#include "../arena.hpp"
+#include "../pathfinder.hpp"
+#include <cstdint>
+#include <cstdlib>
+
+using namespace std;
+
+TEST_CASE("Arena - aligned allocations, released at once by rewind")
+{
+  Arena arena(1024);
+  const Arena::Mark start = arena.mark();
+  char* a = static_cast<char*>(arena.allocate(3, 1));
+  double* b = static_cast<double*>(arena.allocate(10 * sizeof(double), alignof(double)));
+  CHECK(reinterpret_cast<uintptr_t>(b) % alignof(double) == 0);
+  CHECK(static_cast<void*>(a) != static_cast<void*>(b));
+  CHECK(arena.systemAllocations() == 1);
+
+  // the same memory is handed out again after a rewind, without asking the system
+  arena.rewind(start);
+  CHECK(arena.allocate(3, 1) == a);
+  CHECK(arena.allocate(10 * sizeof(double), alignof(double)) == b);
+  CHECK(arena.systemAllocations() == 1);
+
+  // a request larger than a block gets a block of its own, kept after a reset
+  arena.allocate(5000, 8);
+  CHECK(arena.systemAllocations() == 2);
+  CHECK(arena.bytesReserved() >= 1024 + 5000);
+  arena.reset();
+  arena.allocate(1000, 8);
+  arena.allocate(5000, 8);
+  CHECK(arena.systemAllocations() == 2);
+
+  arena.release();
+  CHECK(arena.bytesReserved() == 0);
+}
+
+TEST_CASE("Arena - scopes are nested, and make their arena the current one")
+{
+  CHECK(Arena::current() == nullptr);
+  Arena arena;
+  {
+    ArenaScope outer(arena);
+    CHECK(Arena::current() == &arena);
+    void* kept = arena.allocate(16, 8);
+    void* released = nullptr;
+    {
+      ArenaScope inner(arena);
+      released = arena.allocate(16, 8);
+    }
+    // the inner scope released only its own allocation
+    CHECK(arena.allocate(16, 8) == released);
+    CHECK(kept != released);
+    CHECK(Arena::current() == &arena);
+  }
+  CHECK(Arena::current() == nullptr);
+
+  // containers : on the heap without arena
+  ArenaVector<int> onHeap(100, 1);
+  CHECK(onHeap.get_allocator().arena() == nullptr);
+  ArenaVector<int> inArena(100, 1, ArenaAllocator<int>(&arena));
+  CHECK(inArena.get_allocator().arena() == &arena);
+}
+
+TEST_CASE("Arena - queries in a scope give the same paths, with no allocation once warm")
+{
+  srand(39);
+  const int mapWidth  = 64;
+  const int mapHeight = 64;
+  vector<unsigned char> pMap(mapWidth*mapHeight);
+  for (unsigned char& cell : pMap) { cell = (rand() % 100 < 25) ? 0 : 1; }
+  pMap[0] = 1;
+  pMap[mapWidth*mapHeight - 1] = 1;
+  vector<int> expected(mapWidth*mapHeight), actual(mapWidth*mapHeight);
+
+  for (const SearchLayout layout : {SearchLayout::Dense, SearchLayout::Compact, SearchLayout::Sparse})
+  {
+    Pathfinder reference(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                         expected.data(), (int)expected.size(), TieBreak::HigherG, layout);
+    const int length = reference.findPath();
+
+    Arena arena;
+    ArenaScope scope(arena);
+    long long systemAllocations = 0;
+    for (int query = 0; query < 3; ++query)
+    {
+      Pathfinder pathfinder(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                            actual.data(), (int)actual.size(), TieBreak::HigherG, layout);
+      REQUIRE(pathfinder.findPath() == length);
+      CHECK(actual == expected);
+      // each query gives its memory back : the next ones reuse the same blocks
+      if (query > 0) { CHECK(arena.systemAllocations() == systemAllocations); }
+      systemAllocations = arena.systemAllocations();
+    }
+    CHECK(systemAllocations > 0);
+  }
+}
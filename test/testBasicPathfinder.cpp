@@ -0,0 +1,117 @@
+#include "catch.hpp"
+#include "randomquery.hpp"
+#include "../basicpathfinder.hpp"
+#include <cstdlib>
+
+using namespace std;
+
+/*! \brief Cheapest cost on an 8-connected map without corner cutting, by Dijkstra on the neighbors of BasicMap */
+template<class CostModel>
+static int referenceCost(const BasicMap<EightConnected>& map, const Coordinates& start, const Coordinates& target)
+{
+  vector<int> costs(map.cellCount(), INT_MAX);
+  priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> open;
+  costs[map.coordinatesToIndex(start)] = 0;
+  open.push(make_pair(0, map.coordinatesToIndex(start)));
+  while (!open.empty())
+  {
+    const pair<int, int> best = open.top();
+    open.pop();
+    if (best.first != costs[best.second]) { continue; }
+    const Coordinates cell = map.indexToCoordinates(best.second);
+    if (cell == target) { return best.first; }
+    Coordinates neighbors[EightConnected::MAX_NEIGHBORS];
+    const int nbNeighbors = map.findNeighbors(cell, neighbors);
+    for (int i = 0; i < nbNeighbors; ++i)
+    {
+      const int index = map.coordinatesToIndex(neighbors[i]);
+      const int cost = best.first + CostModel::moveCost(cell, neighbors[i]);
+      if (cost < costs[index])
+      {
+        costs[index] = cost;
+        open.push(make_pair(cost, index));
+      }
+    }
+  }
+  return -1;
+}
+
+TEST_CASE("BasicPathfinder - the default instantiation is the search of FindPath")
+{
+  srand(49);
+  for (int mapIndex = 0; mapIndex < 30; ++mapIndex)
+  {
+    const RandomQuery query = randomQuery();
+    const Coordinates& start = query.start;
+    const Coordinates& target = query.target;
+    const Map map(query.pMap.data(), query.mapWidth, query.mapHeight);
+
+    vector<int> expected(query.mapSize), actual(query.mapSize);
+    Pathfinder pathfinder(start.X, start.Y, target.X, target.Y, query.pMap.data(), query.mapWidth, query.mapHeight,
+                          expected.data(), query.mapSize, TieBreak::HigherG, SearchLayout::Dense);
+    BasicPathfinder<> basic(start.X, start.Y, target.X, target.Y, map, actual.data(), query.mapSize);
+    SearchStats expectedStats, actualStats;
+    const int length = pathfinder.findPath(&expectedStats);
+    REQUIRE(basic.findPath(&actualStats) == length);
+    CHECK(basic.cost() == length);
+    // same expansion order : the very same path
+    CHECK(actualStats.nodesExpanded == expectedStats.nodesExpanded);
+    for (int i = 0; i < length; ++i) { CHECK(actual[i] == expected[i]); }
+
+    // other open lists, states and heuristics : other orders, the same lengths
+    BasicPathfinder<FourConnected, UnitCost, ManhattanHeuristic, LazyOpenList<TieBreak::Fifo>, SparseState>
+      lazySparse(start.X, start.Y, target.X, target.Y, map, actual.data(), query.mapSize);
+    REQUIRE(lazySparse.findPath() == length);
+    CHECK(checkPath(query.pMap, query.mapWidth, query.startIndex, query.targetIndex, actual.data(), length) == length);
+    BasicPathfinder<FourConnected, UnitCost, ZeroHeuristic, IndexedOpenList<TieBreak::Lifo>, SparseState>
+      dijkstra(start.X, start.Y, target.X, target.Y, map, actual.data(), query.mapSize);
+    REQUIRE(dijkstra.findPath() == length);
+    CHECK(checkPath(query.pMap, query.mapWidth, query.startIndex, query.targetIndex, actual.data(), length) == length);
+  }
+
+  // bad input : the same exceptions as FindPath
+  const unsigned char pMap[] = {1, 0, 1};
+  int outBuffer[2];
+  CHECK_THROWS_WITH(BasicPathfinder<>(0, 0, 3, 0, Map(pMap, 3, 1), outBuffer, 2),
+                    findPathStatusMessage(FindPathStatus::TargetXOutOfMap));
+  CHECK_THROWS_WITH(BasicPathfinder<>(0, 0, 1, 0, Map(pMap, 3, 1), outBuffer, 2),
+                    findPathStatusMessage(FindPathStatus::TargetNotPassable));
+  BasicPathfinder<> blocked(0, 0, 2, 0, Map(pMap, 3, 1), outBuffer, 2);
+  CHECK(blocked.findPath() == -1);
+  CHECK(blocked.cost() == -1);
+}
+
+TEST_CASE("BasicPathfinder - 8-connected maps, unit and octile costs")
+{
+  // a diagonal move does not cut corners
+  const unsigned char pCorner[] = {1, 0,
+                                   0, 1};
+  const BasicMap<EightConnected> corner(pCorner, 2, 2);
+  Coordinates neighbors[EightConnected::MAX_NEIGHBORS];
+  CHECK(corner.findNeighbors(Coordinates(0, 0), neighbors) == 0);
+
+  srand(50);
+  for (int mapIndex = 0; mapIndex < 30; ++mapIndex)
+  {
+    const RandomQuery query = randomQuery();
+    const Coordinates& start = query.start;
+    const Coordinates& target = query.target;
+    const BasicMap<EightConnected> map(query.pMap.data(), query.mapWidth, query.mapHeight);
+    vector<int> outBuffer(query.mapSize);
+
+    BasicPathfinder<EightConnected, UnitCost, OctileHeuristic> unit(start.X, start.Y, target.X, target.Y, map, outBuffer.data(), query.mapSize);
+    const int unitLength = unit.findPath();
+    CHECK(unit.cost() == referenceCost<UnitCost>(map, start, target));
+    CHECK(checkPath<EightConnected, UnitCost>(query.pMap, query.mapWidth, query.startIndex, query.targetIndex,
+                                              outBuffer.data(), unitLength) == unit.cost());
+
+    BasicPathfinder<EightConnected, OctileCost, OctileHeuristic, LazyOpenList<>> octile(start.X, start.Y, target.X, target.Y,
+                                                                                      map, outBuffer.data(), query.mapSize);
+    const int octileLength = octile.findPath();
+    CHECK(octile.cost() == referenceCost<OctileCost>(map, start, target));
+    CHECK(checkPath<EightConnected, OctileCost>(query.pMap, query.mapWidth, query.startIndex, query.targetIndex,
+                                                outBuffer.data(), octileLength) == octile.cost());
+    // a cheaper path may take more moves, never fewer
+    CHECK(octileLength >= unitLength);
+  }
+}
@@ -0,0 +1,124 @@
+#include "catch.hpp"
+#include "../compressedmap.hpp"
+#include "../largemap.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+using namespace std;
+
+static const char* FILE_PATH = "testCompressedMap.pftiles";
+
+// mostly empty, with walls of obstacles and a few blocked areas : every kind of tile
+static vector<unsigned char> sparseMap(const int mapWidth, const int mapHeight)
+{
+  vector<unsigned char> pMap(mapWidth*mapHeight, 1);
+  for (int y = 0; y < mapHeight; ++y)
+  {
+    for (int x = 0; x < mapWidth; ++x)
+    {
+      if (rand() % 100 < 2 || (x % 97 == 50 && y % 80 != 0) || (x > 130 && x < 200 && y > 70 && y < 140))
+      {
+        pMap[y*mapWidth + x] = 0;
+      }
+    }
+  }
+  return pMap;
+}
+
+TEST_CASE("CompressedMap - same cells as the map, in memory and from its file")
+{
+  srand(45);
+  for (const int size : {1, 63, 64, 65, 300})
+  {
+    const int mapWidth = size, mapHeight = 301 - size;
+    const vector<unsigned char> pMap = sparseMap(mapWidth, mapHeight);
+    const CompressedMap compressed(pMap.data(), mapWidth, mapHeight);
+    compressed.save(FILE_PATH);
+    const CompressedMap loaded(FILE_PATH);
+    CHECK(loaded.width() == mapWidth);
+    CHECK(loaded.height() == mapHeight);
+    CHECK(loaded.compressedSize() == compressed.compressedSize());
+
+    for (const CompressedMap* map : {&compressed, &loaded})
+    {
+      TileCache cache(*map, 2);  // tiny : tiles are evicted and decompressed again
+      for (int y = 0; y < mapHeight; ++y)
+      {
+        for (int x = 0; x < mapWidth; ++x)
+        {
+          if (cache.isCellOk(Coordinates(x, y)) != (pMap[y*mapWidth + x] != 0))
+          {
+            FAIL("cell " << x << "," << y << " of a " << mapWidth << "x" << mapHeight << " map");
+          }
+        }
+      }
+    }
+  }
+
+  // uniform tiles have no data
+  const vector<unsigned char> empty(200*130, 1);
+  const CompressedMap compressed(empty.data(), 200, 130);
+  CHECK(compressed.tileKind(0) == CompressedMap::Passable);
+  CHECK(compressed.tileKind(3) == CompressedMap::Encoded);  // 8 columns in the map, 56 beyond
+  TileCache cache(compressed);
+  CHECK(cache.isCellOk(Coordinates(10, 10)));
+  CHECK(cache.decompressions() == 0);
+  remove(FILE_PATH);
+}
+
+TEST_CASE("CompressedMap - FindPathLarge finds the same paths, decompressing only the tiles it reaches")
+{
+  srand(46);
+  const int mapWidth = 1024, mapHeight = 1024;
+  vector<unsigned char> pMap = sparseMap(mapWidth, mapHeight);
+  pMap[900*mapWidth + 900] = pMap[930*mapWidth + 920] = 1;
+  const CompressedMap compressed(pMap.data(), mapWidth, mapHeight);
+  CHECK(compressed.compressedSize() * 8 < pMap.size());
+  TileCache cache(compressed);
+  const LargeMap map = LargeMap::compressed(cache);
+
+  for (int query = 0; query < 20; ++query)
+  {
+    const int from = rand() % (mapWidth*mapHeight), to = rand() % (mapWidth*mapHeight);
+    if (!pMap[from] || !pMap[to]) { continue; }
+    vector<int64_t> expected(mapWidth*mapHeight), actual(mapWidth*mapHeight);
+    const int64_t length = FindPathLarge(from % mapWidth, from / mapWidth, to % mapWidth, to / mapWidth,
+                                         LargeMap::bytes(pMap.data(), mapWidth, mapHeight), expected.data(), (int64_t)expected.size());
+    REQUIRE(FindPathLarge(from % mapWidth, from / mapWidth, to % mapWidth, to / mapWidth,
+                          map, actual.data(), (int64_t)actual.size()) == length);
+    CHECK(actual == expected);
+  }
+
+  // a short query in a corner : a few of the 256 tiles
+  TileCache cornerCache(compressed);
+  vector<int64_t> outBuffer(100);
+  const int64_t length = FindPathLarge(900, 900, 920, 930, LargeMap::compressed(cornerCache), outBuffer.data(), 100);
+  CHECK(length >= 50);
+  CHECK(cornerCache.decompressions() <= 4);
+}
+
+TEST_CASE("CompressedMap - bad files, throw exception")
+{
+  CHECK_THROWS_WITH(CompressedMap("no such file.pftiles"), "in CompressedMap, no such file.pftiles cannot be opened.\n");
+
+  {
+    ofstream output(FILE_PATH, ios::binary);
+    for (int i = 0; i < 100; ++i) { output << ' '; }
+  }
+  CHECK_THROWS_WITH(CompressedMap(FILE_PATH), string("in CompressedMap, ") + FILE_PATH + " is not a compressed map file.\n");
+
+  const vector<unsigned char> pMap(100*100, 1);
+  CompressedMap(pMap.data(), 100, 100).save(FILE_PATH);
+  string content;
+  {
+    ifstream input(FILE_PATH, ios::binary);
+    content.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+  }
+  {
+    ofstream output(FILE_PATH, ios::binary | ios::trunc);
+    output.write(content.data(), (streamsize)content.size() - 1);
+  }
+  CHECK_THROWS_WITH(CompressedMap(FILE_PATH), string("in CompressedMap, ") + FILE_PATH + " is truncated or corrupted.\n");
+  remove(FILE_PATH);
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+#include "randomquery.hpp"
+#include "../externalsearch.hpp"
+#include <cstdlib>
+
+using namespace std;
+
+TEST_CASE("FindPathExternal - same lengths as FindPathLarge")
+{
+  srand(47);
+  for (int mapIndex = 0; mapIndex < 30; ++mapIndex)
+  {
+    const RandomQuery query = randomQuery();
+    const LargeMap map = LargeMap::bytes(query.pMap.data(), query.mapWidth, query.mapHeight);
+
+    vector<int64_t> expected(query.mapSize), actual(query.mapSize);
+    const int64_t length = FindPathLarge(query.start.X, query.start.Y, query.target.X, query.target.Y,
+                                         map, expected.data(), query.mapSize);
+    ExternalSearchStats stats;
+    REQUIRE(FindPathExternal(query.start.X, query.start.Y, query.target.X, query.target.Y,
+                             map, actual.data(), query.mapSize, MIN_EXTERNAL_BYTES, &stats) == length);
+    checkPath(query.pMap, query.mapWidth, query.startIndex, query.targetIndex, actual.data(), length);
+    if (length > 0) { CHECK(stats.layers == length); }
+    CHECK(stats.runsWritten == 0);  // small layers : merged in memory
+  }
+
+  // too small an output buffer : the length only
+  const unsigned char pMap[] = {1, 1, 1};
+  int64_t outBuffer[2] = {-1, -1};
+  CHECK(FindPathExternal(0, 0, 2, 0, LargeMap::bytes(pMap, 3, 1), outBuffer, 1, 0) == 2);
+  CHECK(outBuffer[0] == -1);
+  CHECK(FindPathExternal(1, 0, 1, 0, LargeMap::bytes(pMap, 3, 1), outBuffer, 2, 0) == 0);
+  CHECK_THROWS_WITH(FindPathExternal(0, 0, 3, 0, LargeMap::bytes(pMap, 3, 1), outBuffer, 2, 0),
+                    findPathStatusMessage(FindPathStatus::TargetXOutOfMap));
+}
+
+TEST_CASE("FindPathExternal - layers larger than memory, in sorted runs merged in several passes")
+{
+  srand(48);
+  const int mapWidth = 700, mapHeight = 700;
+  vector<unsigned char> pMap(mapWidth*mapHeight);
+  for (unsigned char& cell : pMap) { cell = (rand() % 100 < 10) ? 0 : 1; }
+  const int startIndex = 350*mapWidth + 350;
+  pMap[startIndex] = 1;
+  const LargeMap map = LargeMap::bytes(pMap.data(), mapWidth, mapHeight);
+
+  for (const int targetIndex : {10*mapWidth + 20, 690*mapWidth + 5, 351*mapWidth + 352})
+  {
+    pMap[targetIndex] = 1;
+    vector<int64_t> expected(pMap.size()), actual(pMap.size());
+    const int64_t length = FindPathLarge(350, 350, targetIndex % mapWidth, targetIndex / mapWidth,
+                                         map, expected.data(), (int64_t)expected.size());
+    ExternalSearchStats stats;
+    REQUIRE(FindPathExternal(350, 350, targetIndex % mapWidth, targetIndex / mapWidth,
+                             map, actual.data(), (int64_t)actual.size(), MIN_EXTERNAL_BYTES, &stats) == length);
+    checkPath(pMap, mapWidth, startIndex, targetIndex, actual.data(), length);
+    CHECK(stats.bytesAllocated <= 2 * (long long)MIN_EXTERNAL_BYTES);
+    if (length > 300)
+    {
+      CHECK(stats.runsWritten > 0);
+      CHECK(stats.peakLayerCells * 4 > (long long)MIN_EXTERNAL_BYTES / 2 / 8 * 3);  // more than 3 runs : more than the fan-in
+    }
+  }
+
+  // unreachable Target : every reachable cell, then -1
+  pMap[0] = 1;
+  pMap[1] = pMap[mapWidth] = 0;
+  ExternalSearchStats stats;
+  vector<int64_t> outBuffer(10);
+  CHECK(FindPathExternal(350, 350, 0, 0, map, outBuffer.data(), 10, MIN_EXTERNAL_BYTES, &stats) == -1);
+  CHECK(stats.cellsReached > mapWidth*mapHeight / 2);
+}
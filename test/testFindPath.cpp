@@ -1,5 +1,7 @@
 #include "catch.hpp"
+#include "randomquery.hpp"
 #include "../pathfinder.hpp"
+#include <cstdlib>
 
 using namespace std;
 
@@ -337,4 +339,244 @@ TEST_CASE("findPath - Target location is not passable, throw exception")
 
   CHECK_THROWS_WITH( FindPath(start.X, start.Y, target.X, target.Y, pMap, mapWidth, mapHeight, outputBuffer, outBufferSize),
                      "in FindPath(), Target point must be passable.\n");
-}
\ No newline at end of file
+}
+TEST_CASE("findPath - Statistics out-parameter")
+{
+  const Coordinates start(0,0);
+  const Coordinates target(1,2);
+  const int mapWidth  = 4;
+  const int mapHeight = 3;
+  unsigned char pMap[mapWidth*mapHeight] ={1, 1, 1, 1, 0, 1, 0, 1, 0, 1, 1, 1};
+  const int outBufferSize = 12;
+  int outputBuffer[outBufferSize];
+  SearchStats stats;
+  stats.nodesExpanded = 1000; // must be reset by the query
+
+  const int length = FindPath(start.X, start.Y, target.X, target.Y, pMap, mapWidth, mapHeight, outputBuffer, outBufferSize, &stats);
+  REQUIRE(length == 3);
+  CHECK(stats.nodesExpanded == 3);
+  CHECK(stats.nodesGenerated >= stats.nodesExpanded);
+  CHECK(stats.peakOpenListSize >= 1);
+  CHECK(stats.reExpansions == 0);
+  CHECK(stats.bytesAllocated > 0);
+  CHECK(stats.searchMicroseconds >= 0);
+  CHECK(stats.outputMicroseconds >= 0);
+
+  // without statistics, the result is the same
+  int otherBuffer[outBufferSize];
+  REQUIRE(FindPath(start.X, start.Y, target.X, target.Y, pMap, mapWidth, mapHeight, otherBuffer, outBufferSize, nullptr) == 3);
+  CHECK(otherBuffer[0] == outputBuffer[0]);
+  CHECK(otherBuffer[1] == outputBuffer[1]);
+  CHECK(otherBuffer[2] == outputBuffer[2]);
+}
+
+TEST_CASE("findPath - noexcept variant reports bad input as status codes")
+{
+  int mapWidth  = 2;
+  int mapHeight = 2;
+  unsigned char pMap[4] ={1, 1,
+                          1, 0};
+  const int outBufferSize = 10;
+  int outputBuffer[outBufferSize];
+  int length = 42;
+
+  struct BadQuery
+  {
+    int startX, startY, targetX, targetY, width, height, outBufferSize;
+    FindPathStatus expected;
+  };
+  const BadQuery badQueries[] = {
+    { 0, 0, 1, 0, 0, 2, 10, FindPathStatus::MapWidthTooSmall},
+    { 0, 0, 1, 0, 2, 0, 10, FindPathStatus::MapHeightTooSmall},
+    {-1, 0, 1, 0, 2, 2, 10, FindPathStatus::StartXNegative},
+    { 2, 0, 1, 0, 2, 2, 10, FindPathStatus::StartXOutOfMap},
+    { 0,-1, 1, 0, 2, 2, 10, FindPathStatus::StartYNegative},
+    { 0, 2, 1, 0, 2, 2, 10, FindPathStatus::StartYOutOfMap},
+    { 0, 0,-1, 0, 2, 2, 10, FindPathStatus::TargetXNegative},
+    { 0, 0, 2, 0, 2, 2, 10, FindPathStatus::TargetXOutOfMap},
+    { 0, 0, 1,-1, 2, 2, 10, FindPathStatus::TargetYNegative},
+    { 0, 0, 1, 2, 2, 2, 10, FindPathStatus::TargetYOutOfMap},
+    { 0, 0, 1, 0, 2, 2, -1, FindPathStatus::OutBufferSizeNegative},
+    { 1, 1, 1, 0, 2, 2, 10, FindPathStatus::StartNotPassable},
+    { 0, 0, 1, 1, 2, 2, 10, FindPathStatus::TargetNotPassable},
+  };
+  for (const BadQuery& q : badQueries)
+  {
+    CHECK(FindPathNoExcept(q.startX, q.startY, q.targetX, q.targetY, pMap, q.width, q.height,
+                           outputBuffer, q.outBufferSize, &length) == q.expected);
+    CHECK(length == 42); // not modified
+    // same validation as the throwing API, with the same message
+    CHECK_THROWS_WITH(FindPath(q.startX, q.startY, q.targetX, q.targetY, pMap, q.width, q.height, outputBuffer, q.outBufferSize),
+                      findPathStatusMessage(q.expected));
+  }
+
+  REQUIRE(FindPathNoExcept(0, 0, 0, 1, pMap, mapWidth, mapHeight, outputBuffer, outBufferSize, &length) == FindPathStatus::Ok);
+  CHECK(length == 1);
+  CHECK(outputBuffer[0] == 2);
+}
+
+TEST_CASE("findPath - compact layout finds shortest paths in less memory")
+{
+  srand(38);
+  for (int mapIndex = 0; mapIndex < 30; ++mapIndex)
+  {
+    const RandomQuery query = cornerQuery();
+    const int mapWidth = query.mapWidth, mapHeight = query.mapHeight;
+    vector<int> denseBuffer(query.mapSize), compactBuffer(query.mapSize);
+
+    Pathfinder dense(0, 0, mapWidth-1, mapHeight-1, query.pMap.data(), mapWidth, mapHeight,
+                     denseBuffer.data(), (int)denseBuffer.size());
+    Pathfinder compact(0, 0, mapWidth-1, mapHeight-1, query.pMap.data(), mapWidth, mapHeight,
+                       compactBuffer.data(), (int)compactBuffer.size(), TieBreak::HigherG, SearchLayout::Compact);
+    SearchStats denseStats, compactStats;
+    const int length = dense.findPath(&denseStats);
+    REQUIRE(compact.findPath(&compactStats) == length);
+    CHECK(compactStats.nodesExpanded == denseStats.nodesExpanded);
+
+    // the path may differ between paths of the same length, but it is a path
+    checkPath(query.pMap, mapWidth, query.startIndex, query.targetIndex, compactBuffer.data(), length);
+  }
+}
+
+TEST_CASE("findPath - compact layout takes several times less memory on a large map")
+{
+  // the per cell state is the bulk of the memory when the open list is a small part of the map
+  srand(380);
+  const int mapWidth  = 512;
+  const int mapHeight = 512;
+  vector<unsigned char> pMap(mapWidth*mapHeight);
+  for (unsigned char& cell : pMap) { cell = (rand() % 100 < 20) ? 0 : 1; }
+  pMap[0] = 1;
+  pMap[mapWidth*mapHeight - 1] = 1;
+  vector<int> outputBuffer(mapWidth*mapHeight);
+
+  Pathfinder dense(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                   outputBuffer.data(), (int)outputBuffer.size());
+  Pathfinder compact(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                     outputBuffer.data(), (int)outputBuffer.size(), TieBreak::HigherG, SearchLayout::Compact);
+  SearchStats denseStats, compactStats;
+  const int length = dense.findPath(&denseStats);
+  REQUIRE(length > 0);
+  REQUIRE(compact.findPath(&compactStats) == length);
+  CHECK(compactStats.bytesAllocated * 5 < denseStats.bytesAllocated);
+}
+
+TEST_CASE("findPath - compact layout, not enough buffer for output")
+{
+  const int mapWidth  = 4;
+  const int mapHeight = 3;
+  unsigned char pMap[mapWidth*mapHeight] ={1, 1, 1, 1,
+                                           0, 1, 0, 1,
+                                           0, 1, 1, 1};
+  int outputBuffer[2] = {-7, -7};
+  Pathfinder pathfinder(0, 0, 1, 2, pMap, mapWidth, mapHeight, outputBuffer, 2, TieBreak::HigherG, SearchLayout::Compact);
+  CHECK(pathfinder.findPath() == 3);
+  CHECK(outputBuffer[0] == -7);
+  CHECK(outputBuffer[1] == -7);
+
+  int fullBuffer[3];
+  Pathfinder full(0, 0, 1, 2, pMap, mapWidth, mapHeight, fullBuffer, 3, TieBreak::HigherG, SearchLayout::Compact);
+  REQUIRE(full.findPath() == 3);
+  CHECK(fullBuffer[0] == 1);
+  CHECK(fullBuffer[1] == 5);
+  CHECK(fullBuffer[2] == 9);
+}
+
+TEST_CASE("findPath - sparse layout finds the same paths as the dense one")
+{
+  srand(40);
+  for (int mapIndex = 0; mapIndex < 30; ++mapIndex)
+  {
+    const RandomQuery query = randomQuery();
+    const Coordinates& start = query.start;
+    const Coordinates& target = query.target;
+    vector<int> denseBuffer(query.mapSize), sparseBuffer(query.mapSize);
+
+    Pathfinder dense(start.X, start.Y, target.X, target.Y, query.pMap.data(), query.mapWidth, query.mapHeight,
+                     denseBuffer.data(), (int)denseBuffer.size(), TieBreak::HigherG, SearchLayout::Dense);
+    Pathfinder sparse(start.X, start.Y, target.X, target.Y, query.pMap.data(), query.mapWidth, query.mapHeight,
+                      sparseBuffer.data(), (int)sparseBuffer.size(), TieBreak::HigherG, SearchLayout::Sparse);
+    SearchStats denseStats, sparseStats;
+    const int length = dense.findPath(&denseStats);
+    REQUIRE(sparse.findPath(&sparseStats) == length);
+    // same expansion order : the very same path
+    CHECK(sparseStats.nodesExpanded == denseStats.nodesExpanded);
+    for (int i = 0; i < length; ++i) { CHECK(sparseBuffer[i] == denseBuffer[i]); }
+  }
+}
+
+TEST_CASE("findPath - views of a larger multi-channel buffer give the same paths as packed maps")
+{
+  srand(48);
+  const int nbChannels = 3, margin = 5;
+  for (int mapIndex = 0; mapIndex < 30; ++mapIndex)
+  {
+    const RandomQuery query = randomQuery();
+    const int mapWidth = query.mapWidth, mapHeight = query.mapHeight;
+    const vector<unsigned char>& pMap = query.pMap;
+
+    // the map in channel 1 of an image with a margin around it, occupancy 0-255, impassable below 100
+    const int imageWidth = mapWidth + 2*margin, imageHeight = mapHeight + 2*margin;
+    vector<unsigned char> image(imageWidth*imageHeight*nbChannels);
+    for (unsigned char& byte : image) { byte = (unsigned char)(rand() % 256); }
+    for (int index = 0; index < mapWidth*mapHeight; ++index)
+    {
+      const int x = margin + index % mapWidth, y = margin + index / mapWidth;
+      image[(y*imageWidth + x)*nbChannels + 1] = pMap[index] ? (unsigned char)(100 + rand() % 156) : (unsigned char)(rand() % 100);
+    }
+    MapView imageView(image.data() + 1, imageWidth, imageHeight);
+    imageView.rowPitch = imageWidth*nbChannels;
+    imageView.cellStride = nbChannels;
+    imageView.threshold = 100;
+    const MapView view = imageView.subView(margin, margin, mapWidth, mapHeight);
+
+    vector<int> packedBuffer(mapWidth*mapHeight), viewBuffer(mapWidth*mapHeight);
+    const int startX = query.start.X, startY = query.start.Y;
+    const int targetX = query.target.X, targetY = query.target.Y;
+    const int length = FindPath(startX, startY, targetX, targetY, pMap.data(), mapWidth, mapHeight,
+                                packedBuffer.data(), (int)packedBuffer.size());
+    REQUIRE(FindPath(startX, startY, targetX, targetY, view, viewBuffer.data(), (int)viewBuffer.size()) == length);
+    // indices relative to the view : the very same path
+    for (int i = 0; i < length; ++i) { CHECK(viewBuffer[i] == packedBuffer[i]); }
+
+    int viewLength = -2;
+    CHECK(FindPathNoExcept(startX, startY, targetX, targetY, view, viewBuffer.data(), (int)viewBuffer.size(),
+                           &viewLength) == FindPathStatus::Ok);
+    CHECK(viewLength == length);
+  }
+
+  const unsigned char pMap[] = {1, 0, 1};
+  int outBuffer[2];
+  int length = -2;
+  CHECK(FindPathNoExcept(0, 0, 0, 0, MapView(pMap, 0, 1), outBuffer, 2, &length) == FindPathStatus::MapWidthTooSmall);
+  CHECK_THROWS_AS(FindPath(0, 0, 1, 0, MapView(pMap, 3, 1), outBuffer, 2), BadInputException);
+}
+
+TEST_CASE("findPath - automatic layout is sparse for short queries on a large map")
+{
+  srand(400);
+  const int mapWidth  = 1024;
+  const int mapHeight = 1024;
+  vector<unsigned char> pMap(mapWidth*mapHeight);
+  for (unsigned char& cell : pMap) { cell = (rand() % 100 < 20) ? 0 : 1; }
+  pMap[500*mapWidth + 500] = 1;
+  pMap[520*mapWidth + 530] = 1;
+  vector<int> denseBuffer(mapWidth*mapHeight), automaticBuffer(mapWidth*mapHeight);
+
+  Pathfinder dense(500, 500, 530, 520, pMap.data(), mapWidth, mapHeight,
+                   denseBuffer.data(), (int)denseBuffer.size(), TieBreak::HigherG, SearchLayout::Dense);
+  Pathfinder automatic(500, 500, 530, 520, pMap.data(), mapWidth, mapHeight,
+                       automaticBuffer.data(), (int)automaticBuffer.size());
+  CHECK(automatic.layout() == SearchLayout::Sparse);
+  SearchStats denseStats, automaticStats;
+  const int length = dense.findPath(&denseStats);
+  REQUIRE(length > 0);
+  REQUIRE(automatic.findPath(&automaticStats) == length);
+  // memory follows the cells reached, not the map size
+  CHECK(automaticStats.bytesAllocated * 50 < denseStats.bytesAllocated);
+
+  // across the map, the search reaches too many cells : dense
+  Pathfinder across(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                    automaticBuffer.data(), (int)automaticBuffer.size());
+  CHECK(across.layout() == SearchLayout::Dense);
+}
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+#include "../findpathasync.hpp"
+#include "../preparedmap.hpp"
+
+using namespace std;
+
+TEST_CASE("FindPathAsync - same result as FindPath")
+{
+  const int mapWidth  = 4;
+  const int mapHeight = 3;
+  unsigned char pMap[mapWidth*mapHeight] ={1, 1, 1, 1, 0, 1, 0, 1, 0, 1, 1, 1};
+  const int outBufferSize = 12;
+  int outputBuffer[outBufferSize];
+
+  future<FindPathResult> result = FindPathAsync(0, 0, 1, 2, pMap, mapWidth, mapHeight, outputBuffer, outBufferSize);
+  const FindPathResult r = result.get();
+  REQUIRE(r.status == FindPathStatus::Ok);
+  REQUIRE(r.length == 3);
+  CHECK(outputBuffer[0] == 1);
+  CHECK(outputBuffer[1] == 5);
+  CHECK(outputBuffer[2] == 9);
+
+  const PreparedMap prepared(pMap, mapWidth, mapHeight);
+  int otherBuffer[outBufferSize];
+  const FindPathResult other = FindPathAsync(prepared, 0, 0, 1, 2, otherBuffer, outBufferSize).get();
+  REQUIRE(other.status == FindPathStatus::Ok);
+  CHECK(other.length == 3);
+  CHECK(otherBuffer[2] == 9);
+}
+
+TEST_CASE("FindPathAsync - bad input is reported as a status")
+{
+  unsigned char pMap[4] ={1, 1,
+                          1, 0};
+  int outputBuffer[4];
+  CHECK(FindPathAsync(0, 0, 1, 1, pMap, 0, 2, outputBuffer, 4).get().status == FindPathStatus::MapWidthTooSmall);
+  CHECK(FindPathAsync(0, 0, 1, 1, pMap, 2, 2, outputBuffer, 4).get().status == FindPathStatus::TargetNotPassable);
+  CHECK(FindPathAsync(0, 0, 5, 1, pMap, 2, 2, outputBuffer, 4).get().status == FindPathStatus::TargetXOutOfMap);
+}
+
+TEST_CASE("FindPathAsync - cancellation and deadline")
+{
+  // large map with a wall : the Target cannot be reached, so the search explores the whole left side
+  const int mapWidth  = 1000;
+  const int mapHeight = 1000;
+  vector<unsigned char> pMap(mapWidth*mapHeight, 1);
+  for (int y = 0; y < mapHeight; ++y) { pMap[y*mapWidth + mapWidth/2] = 0; }
+  vector<int> outputBuffer(mapWidth*mapHeight);
+
+  SECTION("cancelled before running")
+  {
+    CancellationToken token;
+    token.cancel();
+    const FindPathResult r = FindPathAsync(0, 0, mapWidth-1, 0, pMap.data(), mapWidth, mapHeight,
+                                           outputBuffer.data(), (int)outputBuffer.size(), token).get();
+    CHECK(r.status == FindPathStatus::Cancelled);
+  }
+  SECTION("deadline already passed")
+  {
+    const FindPathResult r = FindPathAsync(0, 0, mapWidth-1, 0, pMap.data(), mapWidth, mapHeight,
+                                           outputBuffer.data(), (int)outputBuffer.size(), CancellationToken(),
+                                           chrono::steady_clock::now()).get();
+    CHECK(r.status == FindPathStatus::DeadlineExceeded);
+  }
+  SECTION("deadline reached while searching")
+  {
+    const FindPathResult r = FindPathAsync(0, 0, mapWidth-1, 0, pMap.data(), mapWidth, mapHeight,
+                                           outputBuffer.data(), (int)outputBuffer.size(), CancellationToken(),
+                                           chrono::steady_clock::now() + chrono::microseconds(200)).get();
+    CHECK(r.status == FindPathStatus::DeadlineExceeded);
+  }
+  SECTION("cancelled while searching")
+  {
+    CancellationToken token;
+    future<FindPathResult> result = FindPathAsync(0, 0, mapWidth-1, 0, pMap.data(), mapWidth, mapHeight,
+                                                  outputBuffer.data(), (int)outputBuffer.size(), token);
+    this_thread::sleep_for(chrono::microseconds(200));
+    token.cancel();
+    const FindPathStatus status = result.get().status;
+    // on a very fast machine the search may be over before the cancellation
+    CHECK((status == FindPathStatus::Cancelled || status == FindPathStatus::Ok));
+  }
+}
+
+TEST_CASE("Executor - runs every task before being destroyed")
+{
+  atomic<int> counter(0);
+  {
+    Executor executor(3);
+    for (int i = 0; i < 100; ++i)
+    {
+      executor.submit([&counter]() { ++counter; });
+    }
+  }
+  CHECK(counter == 100);
+}
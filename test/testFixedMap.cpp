@@ -0,0 +1,105 @@
+#include "catch.hpp"
+#include "randomquery.hpp"
+#include "../fixedmap.hpp"
+#include <cstdlib>
+
+using namespace std;
+
+TEST_CASE("FixedMap - copy with a border, constant neighbor offsets")
+{
+  // alpha channel of a 2-channel buffer, passable from 128
+  const unsigned char pBuffer[] = {0, 200,   0, 100,   0, 128,
+                                   0,   0,   0, 255,   0,  10};
+  MapView view(pBuffer + 1, 3, 2);
+  view.cellStride = 2;
+  view.rowPitch = 6;
+  view.threshold = 128;
+  const FixedMap<4, 4> fixedMap((Map(view)));
+  CHECK(FixedMap<4, 4>::PITCH == 6);
+  CHECK(fixedMap.isCellOk(fixedMap.index(Coordinates(0, 0))));
+  CHECK(!fixedMap.isCellOk(fixedMap.index(Coordinates(1, 0))));
+  CHECK(fixedMap.isCellOk(fixedMap.index(Coordinates(2, 0))));
+  CHECK(fixedMap.isCellOk(fixedMap.index(Coordinates(1, 1))));
+  // the border : around the map, whatever the room left in the fixed size
+  CHECK(!fixedMap.isCellOk(fixedMap.index(Coordinates(-1, 0))));
+  CHECK(!fixedMap.isCellOk(fixedMap.index(Coordinates(3, 0))));
+  CHECK(!fixedMap.isCellOk(fixedMap.index(Coordinates(0, -1))));
+  CHECK(!fixedMap.isCellOk(fixedMap.index(Coordinates(2, 2))));
+
+  const int index = fixedMap.index(Coordinates(2, 1));
+  CHECK(fixedMap.coordinates(index + FixedMap<4, 4>::OFFSETS[0]) == Coordinates(2, 0));
+  CHECK(fixedMap.coordinates(index + FixedMap<4, 4>::OFFSETS[2]) == Coordinates(1, 1));
+  CHECK(fixedMap.mapIndex(index) == 5);
+  CHECK(fixedMap.distance(index, Coordinates(0, 0)) == 3);
+  CHECK(FixedMap<4, 4>::fits(4, 1));
+  CHECK(!FixedMap<4, 4>::fits(4, 5));
+}
+
+TEST_CASE("FixedPathfinder - the search of Pathfinder, on the stack")
+{
+  srand(50);
+  for (int mapIndex = 0; mapIndex < 40; ++mapIndex)
+  {
+    const RandomQuery query = randomQuery(64);
+    const int mapWidth = query.mapWidth, mapHeight = query.mapHeight, mapSize = query.mapSize;
+    const vector<unsigned char>& pMap = query.pMap;
+    const int startX = query.start.X, startY = query.start.Y;
+    const int targetX = query.target.X, targetY = query.target.Y;
+
+    vector<int> expected(mapSize), actual(mapSize);
+    Pathfinder pathfinder(startX, startY, targetX, targetY, pMap.data(), mapWidth, mapHeight, expected.data(), mapSize,
+                          TieBreak::HigherG, SearchLayout::Dense);
+    FixedPathfinder<64, 64> fixed(startX, startY, targetX, targetY, Map(pMap.data(), mapWidth, mapHeight), actual.data(), mapSize);
+    SearchStats expectedStats, actualStats;
+    const int length = pathfinder.findPath(&expectedStats);
+    REQUIRE(fixed.findPath(&actualStats) == length);
+    // same expansion order : the very same path
+    CHECK(actualStats.nodesExpanded == expectedStats.nodesExpanded);
+    CHECK(actualStats.nodesGenerated == expectedStats.nodesGenerated);
+    CHECK(actualStats.peakOpenListSize == expectedStats.peakOpenListSize);
+    for (int i = 0; i < length; ++i) { CHECK(actual[i] == expected[i]); }
+
+    // FindPath() routes the map to the smallest fixed size it fits in
+    SearchStats routedStats, fixedStats;
+    REQUIRE(FindPath(startX, startY, targetX, targetY, pMap.data(), mapWidth, mapHeight, actual.data(), mapSize, &routedStats) == length);
+    for (int i = 0; i < length; ++i) { CHECK(actual[i] == expected[i]); }
+    if (mapWidth <= 32 && mapHeight <= 32)
+    {
+      FixedPathfinder<32, 32> small(startX, startY, targetX, targetY, Map(pMap.data(), mapWidth, mapHeight), actual.data(), mapSize);
+      REQUIRE(small.findPath(&fixedStats) == length);
+    }
+    else { fixedStats = actualStats; }
+    if (length > 0) { CHECK(routedStats.bytesAllocated == fixedStats.bytesAllocated); }
+  }
+}
+
+TEST_CASE("FixedPathfinder - buffer, unreachable Target, bad input")
+{
+  const unsigned char pMap[] = {1, 1, 1, 0,
+                                0, 0, 1, 1};
+  int outBuffer[4] = {-1, -1, -1, -1};
+  FixedPathfinder<4, 2> small(0, 0, 3, 1, Map(pMap, 4, 2), outBuffer, 3);
+  CHECK(small.findPath() == 4);
+  CHECK(outBuffer[0] == -1);  // too small an output buffer : the length only
+  FixedPathfinder<4, 2> fits(0, 0, 3, 1, Map(pMap, 4, 2), outBuffer, 4);
+  REQUIRE(fits.findPath() == 4);
+  CHECK(outBuffer[0] == 1);
+  CHECK(outBuffer[1] == 2);
+  CHECK(outBuffer[2] == 6);
+  CHECK(outBuffer[3] == 7);
+
+  FixedPathfinder<8, 8> same(2, 0, 2, 0, Map(pMap, 4, 2), outBuffer, 4);
+  CHECK(same.findPath() == 0);
+  const unsigned char pWalled[] = {1, 0, 1};
+  FixedPathfinder<8, 8> walled(0, 0, 2, 0, Map(pWalled, 3, 1), outBuffer, 4);
+  CHECK(walled.findPath() == -1);
+
+  FixedPathfinder<8, 8> blocked(0, 0, 1, 0, Map(pWalled, 3, 1), outBuffer, 4);
+  CHECK_THROWS_WITH(blocked.findPath(), findPathStatusMessage(FindPathStatus::TargetNotPassable));
+  int length = -2;
+  CHECK(blocked.findPathNoExcept(&length) == FindPathStatus::TargetNotPassable);
+  CHECK(length == -2);
+  CHECK(FindPathNoExcept(1, 0, 0, 0, pWalled, 3, 1, outBuffer, 4, &length) == FindPathStatus::StartNotPassable);
+  CHECK(FindPathNoExcept(2, 0, 0, 0, pWalled, 3, 1, outBuffer, 4, &length) == FindPathStatus::Ok);
+  CHECK(length == -1);
+}
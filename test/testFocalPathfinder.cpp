@@ -0,0 +1,89 @@
+#include "catch.hpp"
+#include "randomquery.hpp"
+#include "../focalpathfinder.hpp"
+#include "../preparedmap.hpp"
+#include <cstdlib>
+
+using namespace std;
+
+TEST_CASE("FocalPathfinder - path within (1 + epsilon) of the shortest one")
+{
+  srand(36);
+  for (int mapIndex = 0; mapIndex < 40; ++mapIndex)
+  {
+    const RandomQuery query = cornerQuery(50);
+    const int mapWidth = query.mapWidth, mapHeight = query.mapHeight;
+    const vector<unsigned char>& pMap = query.pMap;
+    const int size = mapWidth*mapHeight;
+    vector<int> outputBuffer(size);
+    const int shortest = FindPath(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                                  outputBuffer.data(), size);
+
+    for (const double epsilon : {0.0, 0.1, 0.5, 2.0})
+    {
+      for (const FocalHeuristic heuristic : {FocalHeuristic::DistanceToGo, FocalHeuristic::Deepest})
+      {
+        FocalOptions options;
+        options.epsilon = epsilon;
+        options.heuristic = heuristic;
+        FocalPathfinder pathfinder(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                                   outputBuffer.data(), size, options);
+        const int length = pathfinder.findPath();
+        if (shortest < 0)
+        {
+          CHECK(length == -1);
+          continue;
+        }
+        CHECK(length >= shortest);
+        CHECK(length <= (1 + epsilon) * shortest);
+
+        // the output is a valid path, ending on Target
+        checkPath(pMap, mapWidth, query.startIndex, query.targetIndex, outputBuffer.data(), length);
+      }
+    }
+  }
+}
+
+TEST_CASE("FocalPathfinder - fewer expansions with a larger epsilon")
+{
+  // open map with a wall : A* expands many cells of equal f, focal search goes straight on
+  const int mapWidth = 100;
+  const int mapHeight = 100;
+  vector<unsigned char> pMap(mapWidth*mapHeight, 1);
+  for (int y = 0; y < 90; ++y) { pMap[y*mapWidth + 50] = 0; }
+  vector<int> outputBuffer(mapWidth*mapHeight);
+
+  FocalOptions options;
+  options.epsilon = 0;
+  FocalPathfinder exact(0, 0, 99, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), (int)outputBuffer.size(), options);
+  SearchStats exactStats;
+  const int shortest = exact.findPath(&exactStats);
+  CHECK(shortest == FindPath(0, 0, 99, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), (int)outputBuffer.size()));
+
+  options.epsilon = 1;
+  FocalPathfinder bounded(0, 0, 99, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), (int)outputBuffer.size(), options);
+  SearchStats boundedStats;
+  const int length = bounded.findPath(&boundedStats);
+  CHECK(length <= 2 * shortest);
+  CHECK(boundedStats.nodesExpanded < exactStats.nodesExpanded);
+}
+
+TEST_CASE("FocalPathfinder - easy cases and bad input")
+{
+  unsigned char pMap[] = {0, 0, 1,
+                          0, 1, 1,
+                          1, 0, 1};
+  int outputBuffer[9];
+  CHECK(FocalPathfinder(2, 0, 0, 2, pMap, 3, 3, outputBuffer, 9).findPath() == -1);
+  CHECK(FocalPathfinder(2, 0, 2, 0, pMap, 3, 3, outputBuffer, 9).findPath() == 0);
+
+  PrepareOptions options;
+  options.components = true;
+  const PreparedMap prepared(pMap, 3, 3, options);
+  CHECK(FocalPathfinder(2, 0, 0, 2, prepared, outputBuffer, 9).findPath() == -1);
+  CHECK(FocalPathfinder(2, 0, 1, 1, prepared, outputBuffer, 9).findPath() == 2);
+
+  CHECK_THROWS_AS(FocalPathfinder(0, 0, 2, 2, pMap, 3, 3, outputBuffer, 9), BadInputException);
+  CHECK_THROWS_AS(FocalPathfinder(2, 0, 2, 2, pMap, 3, 0, outputBuffer, 9), BadInputException);
+  CHECK_THROWS_AS(FocalPathfinder(2, 0, 2, 2, prepared, outputBuffer, -1), BadInputException);
+}
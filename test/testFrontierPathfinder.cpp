@@ -0,0 +1,69 @@
+#include "catch.hpp"
+#include "randomquery.hpp"
+#include "../frontierpathfinder.hpp"
+#include "../preparedmap.hpp"
+#include <cstdlib>
+
+using namespace std;
+
+TEST_CASE("FrontierPathfinder - same lengths as FindPath")
+{
+  srand(49);
+  PrepareOptions options;
+  options.components = true;
+  for (int mapIndex = 0; mapIndex < 40; ++mapIndex)
+  {
+    const RandomQuery query = randomQuery();
+    const Coordinates& start = query.start;
+    const Coordinates& target = query.target;
+
+    vector<int> expected(query.mapSize), actual(query.mapSize);
+    const int length = FindPath(start.X, start.Y, target.X, target.Y, query.pMap.data(), query.mapWidth, query.mapHeight,
+                                expected.data(), query.mapSize);
+    FrontierPathfinder pathfinder(start.X, start.Y, target.X, target.Y, query.pMap.data(), query.mapWidth, query.mapHeight,
+                                  actual.data(), query.mapSize);
+    REQUIRE(pathfinder.findPath() == length);
+    checkPath(query.pMap, query.mapWidth, query.startIndex, query.targetIndex, actual.data(), length);
+
+    const PreparedMap preparedMap(query.pMap.data(), query.mapWidth, query.mapHeight, options);
+    FrontierPathfinder prepared(start.X, start.Y, target.X, target.Y, preparedMap, actual.data(), query.mapSize);
+    SearchStats stats;
+    REQUIRE(prepared.findPath(&stats) == length);
+    checkPath(query.pMap, query.mapWidth, query.startIndex, query.targetIndex, actual.data(), length);
+    if (length < 0) { CHECK(stats.nodesExpanded == 0); }  // other component : no search
+  }
+
+  // too small an output buffer : the length only
+  const unsigned char pMap[] = {1, 1, 1};
+  int outBuffer[2] = {-1, -1};
+  FrontierPathfinder small(0, 0, 2, 0, pMap, 3, 1, outBuffer, 1);
+  CHECK(small.findPath() == 2);
+  CHECK(outBuffer[0] == -1);
+  CHECK_THROWS_WITH(FrontierPathfinder(0, 0, 3, 0, pMap, 3, 1, outBuffer, 2),
+                    findPathStatusMessage(FindPathStatus::TargetXOutOfMap));
+}
+
+TEST_CASE("FrontierPathfinder - memory follows the frontier, not the explored area")
+{
+  const int mapWidth = 300, mapHeight = 300;
+  vector<unsigned char> pMap(mapWidth*mapHeight, 1);
+  // a wall with a gap at the far end : the heuristic is wrong by a lot, most of the map is explored
+  for (int y = 0; y < mapHeight - 2; ++y) { pMap[y*mapWidth + 150] = 0; }
+  const int size = mapWidth*mapHeight;
+  vector<int> expected(size), actual(size);
+  SearchStats astarStats, frontierStats;
+  const int length = FindPath(0, 0, 299, 0, pMap.data(), mapWidth, mapHeight, expected.data(), size, &astarStats);
+  FrontierPathfinder pathfinder(0, 0, 299, 0, pMap.data(), mapWidth, mapHeight, actual.data(), size);
+  REQUIRE(pathfinder.findPath(&frontierStats) == length);
+  checkPath(pMap, mapWidth, 0, 299, actual.data(), length);
+
+  CHECK(frontierStats.nodesExpanded > size / 2);
+  CHECK(frontierStats.peakOpenListSize < 4 * (mapWidth + mapHeight));
+  CHECK(frontierStats.bytesAllocated * 10 < astarStats.bytesAllocated);
+
+  // unreachable Target : every reachable cell, then -1
+  pMap[mapWidth*(mapHeight - 2) + 150] = pMap[mapWidth*(mapHeight - 1) + 150] = 0;
+  FrontierPathfinder walled(0, 0, 299, 0, pMap.data(), mapWidth, mapHeight, actual.data(), size);
+  CHECK(walled.findPath(&frontierStats) == -1);
+  CHECK(frontierStats.nodesExpanded >= 150 * mapHeight);
+}
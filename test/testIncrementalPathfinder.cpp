@@ -0,0 +1,104 @@
+#include "catch.hpp"
+#include "randomquery.hpp"
+#include "../incrementalpathfinder.hpp"
+#include "../preparedmap.hpp"
+#include <cstdlib>
+
+using namespace std;
+
+TEST_CASE("IncrementalPathfinder - path found over several steps")
+{
+  unsigned char pMap[] = {1, 1, 1, 1,
+                          0, 1, 0, 1,
+                          0, 1, 1, 1};
+  int outputBuffer[12];
+
+  IncrementalPathfinder search(0, 0, 1, 2, pMap, 4, 3, outputBuffer, 12);
+  CHECK(search.status() == StepStatus::InProgress);
+  CHECK(search.length() == -1);
+
+  int nbSteps = 0;
+  long long previousExpanded = 0;
+  while (search.step(1) == StepStatus::InProgress)
+  {
+    ++nbSteps;
+    CHECK(search.nodesExpanded() == previousExpanded + 1);
+    previousExpanded = search.nodesExpanded();
+  }
+  CHECK(nbSteps >= 2);
+  REQUIRE(search.status() == StepStatus::Found);
+  REQUIRE(search.length() == 3);
+  CHECK(outputBuffer[0] == 1);
+  CHECK(outputBuffer[1] == 5);
+  CHECK(outputBuffer[2] == 9);
+  CHECK(search.closestDistance() == 0);
+
+  // the search is over : further steps do nothing, and the state is released
+  CHECK(search.step(100) == StepStatus::Found);
+  CHECK(search.bytesAllocated() == 0);
+}
+
+TEST_CASE("IncrementalPathfinder - no path")
+{
+  unsigned char pMap[] = {0, 0, 1,
+                          0, 1, 1,
+                          1, 0, 1};
+  int outputBuffer[7];
+  IncrementalPathfinder search(2, 0, 0, 2, pMap, 3, 3, outputBuffer, 7);
+  CHECK(search.step(1000) == StepStatus::NoPath);
+  CHECK(search.length() == -1);
+
+  // with connected components, the answer is known without any step
+  PrepareOptions options;
+  options.components = true;
+  const PreparedMap prepared(pMap, 3, 3, options);
+  IncrementalPathfinder prepSearch(2, 0, 0, 2, prepared, outputBuffer, 7);
+  CHECK(prepSearch.status() == StepStatus::NoPath);
+  CHECK(prepSearch.nodesExpanded() == 0);
+}
+
+TEST_CASE("IncrementalPathfinder - Start is Target")
+{
+  unsigned char pMap[] = {1, 1};
+  int outputBuffer[2];
+  IncrementalPathfinder search(1, 0, 1, 0, pMap, 2, 1, outputBuffer, 2);
+  CHECK(search.status() == StepStatus::Found);
+  CHECK(search.length() == 0);
+}
+
+TEST_CASE("IncrementalPathfinder - bad input")
+{
+  unsigned char pMap[] = {1, 1,
+                          1, 0};
+  int outputBuffer[4];
+  CHECK_THROWS_AS(IncrementalPathfinder(0, 0, 1, 1, pMap, 0, 2, outputBuffer, 4), BadInputException);
+  CHECK_THROWS_AS(IncrementalPathfinder(0, 0, 1, 1, pMap, 2, 2, outputBuffer, 4), BadInputException);
+  CHECK_THROWS_AS(IncrementalPathfinder(0, 0, 5, 1, pMap, 2, 2, outputBuffer, 4), BadInputException);
+  const PreparedMap prepared(pMap, 2, 2);
+  CHECK_THROWS_AS(IncrementalPathfinder(0, 0, 1, 0, prepared, outputBuffer, -1), BadInputException);
+}
+
+TEST_CASE("IncrementalPathfinder - same paths as FindPath on random maps")
+{
+  srand(34);
+  for (int mapIndex = 0; mapIndex < 20; ++mapIndex)
+  {
+    const RandomQuery query = cornerQuery();
+    const int mapWidth = query.mapWidth, mapHeight = query.mapHeight;
+    const vector<unsigned char>& pMap = query.pMap;
+    const int size = mapWidth*mapHeight;
+    vector<int> expected(size), actual(size);
+
+    const int expectedLength = FindPath(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                                        expected.data(), size);
+    const int budget = 1 + rand() % 16;
+    IncrementalPathfinder search(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                                 actual.data(), size);
+    while (search.step(budget) == StepStatus::InProgress) {}
+    REQUIRE(search.length() == expectedLength);
+    for (int i = 0; i < expectedLength; ++i)
+    {
+      CHECK(actual[i] == expected[i]);
+    }
+  }
+}
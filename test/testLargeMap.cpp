@@ -0,0 +1,96 @@
+#include "catch.hpp"
+#include "randomquery.hpp"
+#include "../largemap.hpp"
+#include <climits>
+#include <cstdlib>
+
+using namespace std;
+
+TEST_CASE("FindPathLarge - same lengths as FindPath, on bytes and on bits")
+{
+  srand(42);
+  for (int mapIndex = 0; mapIndex < 30; ++mapIndex)
+  {
+    const RandomQuery query = randomQuery();
+    const Coordinates& start = query.start;
+    const Coordinates& target = query.target;
+    vector<uint64_t> bits((query.mapSize + 63) / 64, 0);
+    for (int i = 0; i < query.mapSize; ++i)
+    {
+      if (query.pMap[i]) { bits[i >> 6] |= (uint64_t)1 << (i & 63); }
+    }
+
+    vector<int> expected(query.mapSize);
+    const int length = FindPath(start.X, start.Y, target.X, target.Y, query.pMap.data(), query.mapWidth, query.mapHeight,
+                                expected.data(), query.mapSize);
+    for (const LargeMap& map : {LargeMap::bytes(query.pMap.data(), query.mapWidth, query.mapHeight),
+                                LargeMap::bitPacked(bits.data(), query.mapWidth, query.mapHeight)})
+    {
+      vector<int64_t> actual(query.mapSize);
+      REQUIRE(FindPathLarge(start.X, start.Y, target.X, target.Y, map, actual.data(), query.mapSize) == length);
+      // the path may differ between paths of the same length, but it is a path
+      checkPath(query.pMap, query.mapWidth, query.startIndex, query.targetIndex, actual.data(), length);
+    }
+  }
+}
+
+TEST_CASE("FindPathLarge - bad input, and maps too large for FindPath")
+{
+  const unsigned char pMap[] = {1, 1,
+                                1, 0};
+  int64_t outputBuffer[4];
+  const LargeMap map = LargeMap::bytes(pMap, 2, 2);
+  CHECK_THROWS_WITH(FindPathLarge(0, 0, 1, 1, map, outputBuffer, 4), findPathStatusMessage(FindPathStatus::TargetNotPassable));
+  CHECK_THROWS_WITH(FindPathLarge(0, 0, 2, 0, map, outputBuffer, 4), findPathStatusMessage(FindPathStatus::TargetXOutOfMap));
+  CHECK_THROWS_WITH(FindPathLarge(0, 0, 1, 0, map, outputBuffer, -1), findPathStatusMessage(FindPathStatus::OutBufferSizeNegative));
+  CHECK_THROWS_WITH(FindPathLarge(0, 0, 0, 0, LargeMap::bytes(pMap, 0, 2), outputBuffer, 4),
+                    findPathStatusMessage(FindPathStatus::MapWidthTooSmall));
+
+  // FindPath() does not read the map to reject it : its indexes would overflow
+  int length = 42;
+  int intBuffer[4];
+  CHECK(FindPathNoExcept(0, 0, 1, 0, pMap, 65536, 32769, intBuffer, 4, &length) == FindPathStatus::MapTooLarge);
+  CHECK(length == 42);
+  CHECK_THROWS_WITH(FindPath(0, 0, 1, 0, pMap, 46341, 46341, intBuffer, 4), findPathStatusMessage(FindPathStatus::MapTooLarge));
+}
+
+TEST_CASE("FindPathLarge - more than 2^31 cells, bit-packed")
+{
+  // 65536 x 32769 cells : the last row starts at index 2^31. 256 MB with one bit per cell
+  const int mapWidth  = 65536;
+  const int mapHeight = 32769;
+  const int64_t mapSize = (int64_t)mapWidth * mapHeight;
+  REQUIRE(mapSize > INT_MAX);
+  vector<uint64_t> bits((size_t)((mapSize + 63) / 64), ~(uint64_t)0);
+  const LargeMap map = LargeMap::bitPacked(bits.data(), mapWidth, mapHeight);
+
+  // a wall across the bottom right corner, with a single gap at x = 65000
+  const int wallY = mapHeight - 50;
+  for (int x = 64900; x < mapWidth; ++x)
+  {
+    if (x == 65000) { continue; }
+    const int64_t index = (int64_t)wallY * mapWidth + x;
+    bits[(size_t)(index >> 6)] &= ~((uint64_t)1 << (index & 63));
+  }
+
+  const int startX = 65400, startY = wallY - 10;
+  const int targetX = 65500, targetY = mapHeight - 1;
+  vector<int64_t> outputBuffer(2000);
+  SearchStats stats;
+  const int64_t length = FindPathLarge(startX, startY, targetX, targetY, map, outputBuffer.data(), (int64_t)outputBuffer.size(), &stats);
+  // through the gap : 400 to the left, 59 down, then 500 to the right
+  REQUIRE(length == 400 + 59 + 500);
+  CHECK(outputBuffer[length-1] == (int64_t)targetY * mapWidth + targetX);
+  CHECK(outputBuffer[length-1] > INT_MAX);
+  int64_t previous = (int64_t)startY * mapWidth + startX;
+  for (int64_t i = 0; i < length; ++i)
+  {
+    const Coordinates cell = map.indexToCoordinates(outputBuffer[i]);
+    const Coordinates previousCell = map.indexToCoordinates(previous);
+    REQUIRE(abs(cell.X - previousCell.X) + abs(cell.Y - previousCell.Y) == 1);
+    REQUIRE(map.isCellOk(cell));
+    previous = outputBuffer[i];
+  }
+  // the search state follows the cells reached, not the 2^31 cells of the map
+  CHECK(stats.bytesAllocated < 64*1024*1024);
+}
@@ -75,6 +75,46 @@ TEST_CASE("Map - is Cell ok, meaning not out of bounds, nor impassable")
 
 }
 
+TEST_CASE("Map - view of a channel of a larger buffer, with a threshold")
+{
+  // 2 channels, the map is the second one of the 3x2 cells from (1, 1) of a 5x3 image
+  const unsigned char pImage[] = {0, 0,   0, 0,   0, 0,   0, 0,   0, 0,
+                                   0, 0,   9, 200, 9, 10,  0, 128, 0, 0,
+                                   0, 0,   0, 255, 0, 0,   0, 127, 0, 0};
+  MapView image(pImage + 1, 5, 3);
+  image.rowPitch = 10;
+  image.cellStride = 2;
+  image.threshold = 128;
+  const MapView view = image.subView(1, 1, 3, 2);
+  CHECK(!view.isPacked());
+  Map _map(view);
+  CHECK(_map.isCellOk(Coordinates(0,0)) == true);
+  CHECK(_map.isCellOk(Coordinates(1,0)) == false);
+  CHECK(_map.isCellOk(Coordinates(2,0)) == true);
+  CHECK(_map.isCellOk(Coordinates(0,1)) == true);
+  CHECK(_map.isCellOk(Coordinates(1,1)) == false);
+  CHECK(_map.isCellOk(Coordinates(2,1)) == false);
+  CHECK(_map.isCellOk(Coordinates(3,0)) == false);
+  CHECK(_map.isCellOk(Coordinates(0,2)) == false);
+  // indices are row-major in the view
+  CHECK(_map.coordinatesToIndex(Coordinates(2,1)) == 5);
+  CHECK(_map.cellCount() == 6);
+
+  // bottom-up : the view starts at the last row, going up
+  MapView bottomUp(pImage + 2*10 + 1, 5, 3);
+  bottomUp.rowPitch = -10;
+  bottomUp.cellStride = 2;
+  bottomUp.threshold = 128;
+  Map flipped(bottomUp);
+  CHECK(flipped.isCellOk(Coordinates(1,0)) == true);
+  CHECK(flipped.isCellOk(Coordinates(3,0)) == false);
+  CHECK(flipped.isCellOk(Coordinates(1,1)) == true);
+  CHECK(flipped.isCellOk(Coordinates(3,1)) == true);
+  CHECK(flipped.isCellOk(Coordinates(2,1)) == false);
+
+  CHECK(MapView(pImage, 5, 6).isPacked());
+}
+
 TEST_CASE("Map - convert Coordinates to index")
 {
   const unsigned char pMap[] = {0, 0, 0, 0,
@@ -177,4 +217,28 @@ TEST_CASE("Map - find neighbors : for a given Cell, find the adjacent cells that
   REQUIRE(result.size() == 2);
   CHECK( *next(result.begin(), 0) == Coordinates(2,2) );
   CHECK( *next(result.begin(), 1) == Coordinates(1,3) );
-}
\ No newline at end of file
+}
+
+TEST_CASE("Map - find neighbors into an array, same order as the list version")
+{
+  const unsigned char pMap[] = {0, 0, 0,
+                                0, 1, 0,
+                                1, 1, 1,
+                                1, 1, 1};
+  Map _map(pMap, 3, 4);
+  Coordinates neighbors[4];
+
+  REQUIRE(_map.findNeighbors(Coordinates(1,1), neighbors) == 1);
+  CHECK( neighbors[0] == Coordinates(1,2) );
+
+  REQUIRE(_map.findNeighbors(Coordinates(1,2), neighbors) == 4);
+  CHECK( neighbors[0] == Coordinates(1,1) );
+  CHECK( neighbors[1] == Coordinates(1,3) );
+  CHECK( neighbors[2] == Coordinates(0,2) );
+  CHECK( neighbors[3] == Coordinates(2,2) );
+
+  REQUIRE(_map.findNeighbors(Coordinates(1,3), neighbors) == 3);
+  CHECK( neighbors[0] == Coordinates(1,2) );
+  CHECK( neighbors[1] == Coordinates(0,3) );
+  CHECK( neighbors[2] == Coordinates(2,3) );
+}
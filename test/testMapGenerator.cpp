@@ -0,0 +1,115 @@
+#include "catch.hpp"
+#include "../bench/mapgenerator.hpp"
+
+using namespace std;
+
+// every passable cell can be reached from the first passable cell
+static bool isConnected(const GridMap& grid)
+{
+  const int first = (int)(find(grid.cells.begin(), grid.cells.end(), 1) - grid.cells.begin());
+  vector<int> outputBuffer(grid.cells.size());
+  for (int index = 0; index < (int)grid.cells.size(); ++index)
+  {
+    if (grid.cells[index] == 0) { continue; }
+    if (FindPath(first % grid.width, first / grid.width, index % grid.width, index / grid.width,
+                 grid.cells.data(), grid.width, grid.height, outputBuffer.data(), (int)outputBuffer.size()) < 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST_CASE("MapGenerator - same seed gives the same map")
+{
+  for (const MapKind kind : {MapKind::Random, MapKind::Maze, MapKind::Rooms, MapKind::Warehouse})
+  {
+    MapGenParams params;
+    params.kind = kind;
+    params.width = 97;
+    params.height = 53;
+    params.density = 0.1;
+    params.seed = 42;
+    const GridMap first = generateMap(params);
+    const GridMap second = generateMap(params);
+    CHECK(first.width == 97);
+    CHECK(first.height == 53);
+    CHECK(first.cells == second.cells);
+
+    params.seed = 43;
+    if (kind != MapKind::Warehouse || params.density > 0)
+    {
+      CHECK(generateMap(params).cells != first.cells);
+    }
+  }
+}
+
+TEST_CASE("MapGenerator - random map follows the density")
+{
+  MapGenParams params;
+  params.kind = MapKind::Random;
+  params.width = 200;
+  params.height = 200;
+  params.density = 0.3;
+  const GridMap grid = generateMap(params);
+  const double obstacles = (double)count(grid.cells.begin(), grid.cells.end(), 0) / grid.cells.size();
+  CHECK(obstacles == Approx(0.3).margin(0.02));
+}
+
+TEST_CASE("MapGenerator - mazes and rooms are fully connected")
+{
+  MapGenParams params;
+  params.width = 31;
+  params.height = 24;
+  params.kind = MapKind::Maze;
+  const GridMap maze = generateMap(params);
+  CHECK(count(maze.cells.begin(), maze.cells.end(), 0) > 0);
+  CHECK(isConnected(maze));
+
+  params.kind = MapKind::Rooms;
+  params.roomSize = 6;
+  const GridMap rooms = generateMap(params);
+  CHECK(count(rooms.cells.begin(), rooms.cells.end(), 0) > 0);
+  CHECK(isConnected(rooms));
+
+  params.kind = MapKind::Warehouse;
+  params.density = 0;
+  CHECK(isConnected(generateMap(params)));
+}
+
+TEST_CASE("MapGenerator - scenarios are between passable cells")
+{
+  MapGenParams params;
+  params.width = 64;
+  params.height = 64;
+  const GridMap grid = generateMap(params);
+  const vector<Scenario> scenarios = generateScenarios(grid, "random.map", 50, 7);
+  REQUIRE(scenarios.size() == 50);
+  for (const Scenario& scenario : scenarios)
+  {
+    CHECK(grid.cells[scenario.start.Y*grid.width + scenario.start.X] == 1);
+    CHECK(grid.cells[scenario.target.Y*grid.width + scenario.target.X] == 1);
+    CHECK(scenario.bucket >= 0);
+    CHECK(scenario.bucket <= 9);
+    CHECK(scenario.mapFile == "random.map");
+  }
+}
+
+TEST_CASE("MapGenerator - bad parameters, throw exception")
+{
+  MapGenParams params;
+  params.width = 0;
+  CHECK_THROWS_WITH(generateMap(params), "in generateMap(), width must be between 1 and 32768.\n");
+  params.width = 32769;
+  CHECK_THROWS_WITH(generateMap(params), "in generateMap(), width must be between 1 and 32768.\n");
+  params.width = 10;
+  params.height = 32769;
+  CHECK_THROWS_WITH(generateMap(params), "in generateMap(), height must be between 1 and 32768.\n");
+  params.height = 10;
+  params.density = 1.5;
+  CHECK_THROWS_WITH(generateMap(params), "in generateMap(), density must be between 0 and 1.\n");
+  params.density = 0.5;
+  params.roomSize = 2;
+  CHECK_THROWS_WITH(generateMap(params), "in generateMap(), room size must be at least 3.\n");
+  CHECK_THROWS_AS(mapKindFromName("cave"), BadInputException);
+}
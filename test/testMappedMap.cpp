@@ -0,0 +1,216 @@
+#include "catch.hpp"
+#include "../mappedmap.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+using namespace std;
+
+static const char* FILE_PATH = "testMappedMap.pfmap";
+
+TEST_CASE("MappedMap - same paths as the PreparedMap it was saved from, for every option")
+{
+  srand(43);
+  const int mapWidth  = 37;
+  const int mapHeight = 23;
+  vector<unsigned char> pMap(mapWidth*mapHeight);
+  for (unsigned char& cell : pMap) { cell = (rand() % 100 < 30) ? 0 : 1; }
+
+  for (int bits = 0; bits < 32; ++bits)
+  {
+    PrepareOptions options;
+    options.padding       = (bits & 1) != 0;
+    options.bitPacking    = (bits & 2) != 0;
+    options.components    = (bits & 4) != 0;
+    options.neighborMasks = (bits & 8) != 0;
+    options.tiledLayout   = (bits & 16) != 0;
+    {
+      const PreparedMap prepared(pMap.data(), mapWidth, mapHeight, options);
+      savePreparedMap(prepared, FILE_PATH);
+    }
+    const MappedMap mapped(FILE_PATH);
+    const PreparedMap& prepared = mapped.prepared();
+    CHECK(prepared.width() == mapWidth);
+    CHECK(prepared.height() == mapHeight);
+    CHECK(prepared.options().tiledLayout == options.tiledLayout);
+    // nothing is copied : the arrays are in the file
+    CHECK(prepared.bytesAllocated() == 0);
+
+    for (int query = 0; query < 20; ++query)
+    {
+      const int from = rand() % (mapWidth*mapHeight);
+      const int to   = rand() % (mapWidth*mapHeight);
+      if (!pMap[from] || !pMap[to]) { continue; }
+      vector<int> expected(mapWidth*mapHeight), actual(mapWidth*mapHeight);
+      const int length = FindPath(from % mapWidth, from / mapWidth, to % mapWidth, to / mapWidth,
+                                  pMap.data(), mapWidth, mapHeight, expected.data(), (int)expected.size());
+      REQUIRE(prepared.findPath(from % mapWidth, from / mapWidth, to % mapWidth, to / mapWidth,
+                                actual.data(), (int)actual.size()) == length);
+      CHECK(actual == expected);
+    }
+  }
+
+  // saved from a view : the file holds the packed map, the same as saved from pMap
+  vector<unsigned char> image(2*pMap.size());
+  for (size_t index = 0; index < pMap.size(); ++index) { image[2*index + 1] = pMap[index] ? 200 : 50; }
+  MapView view(image.data() + 1, mapWidth, mapHeight);
+  view.rowPitch = 2*mapWidth;
+  view.cellStride = 2;
+  view.threshold = 100;
+  savePreparedMap(PreparedMap(view), FILE_PATH);
+  const MappedMap mapped(FILE_PATH);
+  CHECK(mapped.fingerprint() == mapFingerprint(pMap.data(), mapWidth, mapHeight));
+  CHECK(mapped.verify());
+  remove(FILE_PATH);
+}
+
+TEST_CASE("MappedMap - bad files, throw exception")
+{
+  CHECK_THROWS_WITH(MappedMap("no such file.pfmap"), "in MappedMap, no such file.pfmap cannot be opened.\n");
+
+  {
+    ofstream output(FILE_PATH, ios::binary);
+    output << "type octile\nheight 2\nwidth 2\nmap\n..\n..\n";
+    for (int i = 0; i < 100; ++i) { output << ' '; }
+  }
+  CHECK_THROWS_WITH(MappedMap(FILE_PATH), string("in MappedMap, ") + FILE_PATH + " is not a prepared map file.\n");
+
+  // truncated : the neighbor masks are missing
+  const unsigned char pMap[] = {1, 1,
+                                1, 0};
+  PrepareOptions options;
+  options.neighborMasks = true;
+  savePreparedMap(PreparedMap(pMap, 2, 2, options), FILE_PATH);
+  string content;
+  {
+    ifstream input(FILE_PATH, ios::binary);
+    content.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+  }
+  {
+    ofstream output(FILE_PATH, ios::binary | ios::trunc);
+    output.write(content.data(), (streamsize)content.size() - 2);
+  }
+  CHECK_THROWS_WITH(MappedMap(FILE_PATH), string("in MappedMap, ") + FILE_PATH + " is truncated or corrupted.\n");
+  remove(FILE_PATH);
+}
+
+TEST_CASE("MappedMap - openOrBuildPreparedMap rebuilds stale and corrupted files only")
+{
+  remove(FILE_PATH);
+  vector<unsigned char> pMap = {1, 1, 0, 1,
+                                1, 1, 0, 1,
+                                1, 1, 0, 1};
+  PrepareOptions options;
+  options.components = true;
+  int outBuffer[12];
+  bool rebuilt = false;
+
+  SECTION("missing, then up to date")
+  {
+    CHECK(openOrBuildPreparedMap(FILE_PATH, pMap.data(), 4, 3, options, &rebuilt)->prepared().findPath(0, 0, 3, 0, outBuffer, 12) == -1);
+    CHECK(rebuilt);
+    const unique_ptr<MappedMap> mapped = openOrBuildPreparedMap(FILE_PATH, pMap.data(), 4, 3, options, &rebuilt);
+    CHECK(!rebuilt);
+    CHECK(mapped->fingerprint() == mapFingerprint(pMap.data(), 4, 3));
+    CHECK(mapped->verify());
+  }
+
+  SECTION("another map, same size : stale")
+  {
+    savePreparedMap(PreparedMap(pMap.data(), 4, 3, options), FILE_PATH);
+    pMap[2] = 1;
+    const unique_ptr<MappedMap> mapped = openOrBuildPreparedMap(FILE_PATH, pMap.data(), 4, 3, options, &rebuilt);
+    CHECK(rebuilt);
+    CHECK(mapped->prepared().findPath(0, 0, 3, 0, outBuffer, 12) == 3);
+  }
+
+  SECTION("same cells, another size : stale")
+  {
+    savePreparedMap(PreparedMap(pMap.data(), 4, 3, options), FILE_PATH);
+    CHECK(mapFingerprint(pMap.data(), 3, 4) != mapFingerprint(pMap.data(), 4, 3));
+    const unique_ptr<MappedMap> mapped = openOrBuildPreparedMap(FILE_PATH, pMap.data(), 3, 4, options, &rebuilt);
+    CHECK(rebuilt);
+    CHECK(mapped->prepared().width() == 3);
+  }
+
+  SECTION("other options : stale")
+  {
+    savePreparedMap(PreparedMap(pMap.data(), 4, 3), FILE_PATH);
+    const unique_ptr<MappedMap> mapped = openOrBuildPreparedMap(FILE_PATH, pMap.data(), 4, 3, options, &rebuilt);
+    CHECK(rebuilt);
+    CHECK(mapped->prepared().options().components);
+  }
+
+  SECTION("a corrupted component label : checksum mismatch")
+  {
+    savePreparedMap(PreparedMap(pMap.data(), 4, 3, options), FILE_PATH);
+    string content;
+    {
+      ifstream input(FILE_PATH, ios::binary);
+      content.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+    }
+    content[content.size() - 12*sizeof(int)] ^= 2;  // component of cell 0, in the last section
+    {
+      ofstream output(FILE_PATH, ios::binary | ios::trunc);
+      output.write(content.data(), (streamsize)content.size());
+    }
+    CHECK(!MappedMap(FILE_PATH).verify());
+    const unique_ptr<MappedMap> mapped = openOrBuildPreparedMap(FILE_PATH, pMap.data(), 4, 3, options, &rebuilt);
+    CHECK(rebuilt);
+    CHECK(mapped->verify());
+  }
+
+  SECTION("not a prepared map file : replaced")
+  {
+    {
+      ofstream output(FILE_PATH, ios::binary);
+      output << "type octile\n";
+    }
+    openOrBuildPreparedMap(FILE_PATH, pMap.data(), 4, 3, options, &rebuilt);
+    CHECK(rebuilt);
+  }
+  remove(FILE_PATH);
+}
+
+TEST_CASE("MappedMap - concurrent rebuilds of the same stale file all succeed")
+{
+  // large enough for the writes of the rebuilds to overlap
+  const int mapWidth = 512;
+  const vector<unsigned char> pMap(mapWidth*mapWidth, 1);
+  PrepareOptions options;
+  options.padding = options.components = options.neighborMasks = true;
+
+  for (int round = 0; round < 4; ++round)
+  {
+    {
+      ofstream output(FILE_PATH, ios::binary);
+      output << "stale";
+    }
+    // each rebuild writes its own temporary file : none truncates nor renames another's
+    const int nbThreads = 8;
+    vector<int> lengths(nbThreads, -2);
+    vector<thread> threads;
+    for (int t = 0; t < nbThreads; ++t)
+    {
+      threads.emplace_back([&, t]() {
+        try
+        {
+          int outBuffer[2];
+          lengths[t] = openOrBuildPreparedMap(FILE_PATH, pMap.data(), mapWidth, mapWidth, options)->prepared().findPath(0, 0, 1, 1, outBuffer, 2);
+        }
+        catch (const BadInputException&)
+        {
+          lengths[t] = -3;
+        }
+      });
+    }
+    for (thread& t : threads) { t.join(); }
+    for (const int length : lengths) { CHECK(length == 2); }
+  }
+
+  bool rebuilt = true;
+  CHECK(openOrBuildPreparedMap(FILE_PATH, pMap.data(), mapWidth, mapWidth, options, &rebuilt)->verify());
+  CHECK(!rebuilt);
+  remove(FILE_PATH);
+}
@@ -0,0 +1,137 @@
+#include "catch.hpp"
+#include "randomquery.hpp"
+#include "../memoryboundedpathfinder.hpp"
+#include "../preparedmap.hpp"
+#include <cstdlib>
+
+using namespace std;
+
+TEST_CASE("MemoryBoundedPathfinder - shortest paths whatever the cap")
+{
+  srand(37);
+  for (int mapIndex = 0; mapIndex < 30; ++mapIndex)
+  {
+    const RandomQuery query = cornerQuery(30);
+    const int mapWidth = query.mapWidth, mapHeight = query.mapHeight;
+    const vector<unsigned char>& pMap = query.pMap;
+    const int size = mapWidth*mapHeight;
+    vector<int> expected(size), actual(size);
+    const int shortest = FindPath(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight, expected.data(), size);
+
+    for (const size_t maxBytes : {(size_t)16*1024, (size_t)64*1024, (size_t)1024*1024})
+    {
+      MemoryBoundedPathfinder pathfinder(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                                         actual.data(), size, maxBytes);
+      SearchStats stats;
+      REQUIRE(pathfinder.findPath(&stats) == shortest);
+      CHECK(stats.bytesAllocated <= (long long)maxBytes);
+
+      // the output is a valid path, ending on Target
+      checkPath(pMap, mapWidth, query.startIndex, query.targetIndex, actual.data(), shortest);
+    }
+  }
+}
+
+TEST_CASE("MemoryBoundedPathfinder - a smaller cap costs expansions, not optimality")
+{
+  const int mapWidth = 64;
+  const int mapHeight = 64;
+  vector<unsigned char> pMap(mapWidth*mapHeight, 1);
+  for (int y = 0; y < 60; ++y) { pMap[y*mapWidth + 32] = 0; }
+  vector<int> outputBuffer(mapWidth*mapHeight);
+  const int size = (int)outputBuffer.size();
+  const int shortest = FindPath(0, 0, 63, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), size);
+
+  SearchStats largeStats, smallStats;
+  MemoryBoundedPathfinder large(0, 0, 63, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), size, 1024*1024);
+  CHECK(large.findPath(&largeStats) == shortest);
+  MemoryBoundedPathfinder small(0, 0, 63, 0, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), size, 32*1024);
+  CHECK(small.findPath(&smallStats) == shortest);
+  CHECK(smallStats.bytesAllocated < largeStats.bytesAllocated);
+  CHECK(smallStats.nodesExpanded >= largeStats.nodesExpanded);
+}
+
+TEST_CASE("MemoryBoundedPathfinder - cap too small for the path")
+{
+  const int mapWidth = 200;
+  vector<unsigned char> pMap(mapWidth, 1);
+  vector<int> outputBuffer(mapWidth);
+  // room for 3 nodes only
+  MemoryBoundedPathfinder pathfinder(0, 0, mapWidth-1, 0, pMap.data(), mapWidth, 1, outputBuffer.data(), mapWidth, 256);
+  CHECK_THROWS_AS(pathfinder.findPath(), bad_alloc);
+  int length = 12;
+  CHECK(pathfinder.findPathNoExcept(&length) == FindPathStatus::OutOfMemory);
+  CHECK(length == 12);
+}
+
+TEST_CASE("MemoryBoundedPathfinder - easy cases and bad input")
+{
+  unsigned char pMap[] = {0, 0, 1,
+                          0, 1, 1,
+                          1, 0, 1};
+  int outputBuffer[9];
+  CHECK(MemoryBoundedPathfinder(2, 0, 0, 2, pMap, 3, 3, outputBuffer, 9, 4096).findPath() == -1);
+  CHECK(MemoryBoundedPathfinder(2, 0, 2, 0, pMap, 3, 3, outputBuffer, 9, 4096).findPath() == 0);
+
+  PrepareOptions options;
+  options.components = true;
+  const PreparedMap prepared(pMap, 3, 3, options);
+  CHECK(MemoryBoundedPathfinder(2, 0, 0, 2, prepared, outputBuffer, 9, 4096).findPath() == -1);
+  CHECK(MemoryBoundedPathfinder(2, 0, 1, 1, prepared, outputBuffer, 9, 4096).findPath() == 2);
+  CHECK(outputBuffer[0] == 5);
+  CHECK(outputBuffer[1] == 4);
+
+  CHECK_THROWS_AS(MemoryBoundedPathfinder(0, 0, 2, 2, pMap, 3, 3, outputBuffer, 9, 4096), BadInputException);
+  CHECK_THROWS_AS(MemoryBoundedPathfinder(2, 0, 2, 2, pMap, 3, 0, outputBuffer, 9, 4096), BadInputException);
+}
+
+TEST_CASE("MemoryBoundedPathfinder - the cap does not depend on the size of the map")
+{
+  // less than a byte per cell : only the nodes of the query are paid for
+  const int mapWidth = 2048;
+  vector<unsigned char> pMap((size_t)mapWidth*mapWidth, 1);
+  vector<int> outputBuffer(16);
+  MemoryBoundedPathfinder pathfinder(1000, 1000, 1005, 1005, pMap.data(), mapWidth, mapWidth,
+                                     outputBuffer.data(), 16, 1024*1024);
+  SearchStats stats;
+  CHECK(pathfinder.findPath(&stats) == 10);
+  CHECK(stats.bytesAllocated <= 1024*1024);
+  CHECK(outputBuffer[9] == 1005*mapWidth + 1005);
+
+  // a cap of a few KB forgets nodes, with a detour table of a few hundred entries
+  MemoryBoundedPathfinder small(1000, 1000, 1005, 1005, pMap.data(), mapWidth, mapWidth,
+                                outputBuffer.data(), 16, 4*1024);
+  int length = -1;
+  CHECK(small.findPathNoExcept(&length) == FindPathStatus::Ok);
+  CHECK(length == 10);
+}
+
+TEST_CASE("MemoryBoundedPathfinder - a nearly full pool gives a shortest path or none")
+{
+  // nodes are forgotten and regenerated, or reparented, at every expansion : a path found is still a shortest one
+  const int mapWidth = 58;
+  const int mapHeight = 74;
+  const int size = mapWidth*mapHeight;
+  vector<unsigned char> pMap(size);
+  vector<int> outputBuffer(size);
+  for (const unsigned int seed : {47u, 188u})
+  {
+    srand(seed);
+    for (unsigned char& cell : pMap) { cell = (rand() % 100 < 36) ? 0 : 1; }
+    pMap[56*mapWidth + 30] = 1;
+    pMap[47*mapWidth + 52] = 1;
+    const int shortest = FindPath(30, 56, 52, 47, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), size);
+    REQUIRE(shortest > 0);
+
+    int nbFound = 0;
+    for (size_t maxBytes = 6000; maxBytes <= 9000; maxBytes += 100)
+    {
+      MemoryBoundedPathfinder pathfinder(30, 56, 52, 47, pMap.data(), mapWidth, mapHeight, outputBuffer.data(), size, maxBytes);
+      int length = -1;
+      if (pathfinder.findPathNoExcept(&length) != FindPathStatus::Ok) { continue; }
+      CHECK(length == shortest);
+      ++nbFound;
+    }
+    CHECK(nbFound > 0);
+  }
+}
@@ -0,0 +1,64 @@
+#include "catch.hpp"
+#include "../bench/movingai.hpp"
+#include <sstream>
+
+using namespace std;
+
+TEST_CASE("MovingAI - load a map")
+{
+  istringstream input("type octile\n"
+                      "height 3\n"
+                      "width 4\n"
+                      "map\n"
+                      ".@G.\n"
+                      "TS.W\n"
+                      "...O\n");
+  const GridMap grid = loadMovingAIMap(input);
+  REQUIRE(grid.width == 4);
+  REQUIRE(grid.height == 3);
+  const vector<unsigned char> expected = {1, 0, 1, 1,
+                                          0, 1, 1, 0,
+                                          1, 1, 1, 0};
+  CHECK(grid.cells == expected);
+}
+
+TEST_CASE("MovingAI - bad map, throw exception")
+{
+  istringstream noHeader("height 3\nwidth 4\nmap\n....\n");
+  CHECK_THROWS_AS(loadMovingAIMap(noHeader), FormatException);
+
+  istringstream shortRow("type octile\nheight 2\nwidth 4\nmap\n....\n...\n");
+  CHECK_THROWS_WITH(loadMovingAIMap(shortRow), "in loadMovingAIMap(), row 1 does not match the map width.\n");
+
+  istringstream missingRow("type octile\nheight 2\nwidth 4\nmap\n....\n");
+  CHECK_THROWS_AS(loadMovingAIMap(missingRow), FormatException);
+}
+
+TEST_CASE("MovingAI - load scenarios")
+{
+  istringstream input("version 1\n"
+                      "0\tmaps/dao/arena.map\t49\t49\t1\t11\t1\t12\t1\n"
+                      "3\tmaps/dao/arena.map\t49\t49\t4\t5\t20\t30\t30.62741700\n");
+  const vector<Scenario> scenarios = loadMovingAIScenarios(input);
+  REQUIRE(scenarios.size() == 2);
+  CHECK(scenarios[0].bucket == 0);
+  CHECK(scenarios[0].mapFile == "maps/dao/arena.map");
+  CHECK(scenarios[0].mapWidth == 49);
+  CHECK(scenarios[0].mapHeight == 49);
+  CHECK(scenarios[0].start == Coordinates(1,11));
+  CHECK(scenarios[0].target == Coordinates(1,12));
+  CHECK(scenarios[0].optimalLength == Approx(1));
+  CHECK(scenarios[1].bucket == 3);
+  CHECK(scenarios[1].start == Coordinates(4,5));
+  CHECK(scenarios[1].target == Coordinates(20,30));
+  CHECK(scenarios[1].optimalLength == Approx(30.627417));
+}
+
+TEST_CASE("MovingAI - bad scenarios, throw exception")
+{
+  istringstream noVersion("0\tarena.map\t49\t49\t1\t11\t1\t12\t1\n");
+  CHECK_THROWS_AS(loadMovingAIScenarios(noVersion), FormatException);
+
+  istringstream truncated("version 1\n0\tarena.map\t49\t49\t1\t11\n");
+  CHECK_THROWS_WITH(loadMovingAIScenarios(truncated), "in loadMovingAIScenarios(), cannot read scenario 0.\n");
+}
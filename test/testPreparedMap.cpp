@@ -0,0 +1,210 @@
+#include "catch.hpp"
+#include "randomquery.hpp"
+#include "../preparedmap.hpp"
+#include <climits>
+#include <cstdlib>
+
+using namespace std;
+
+static const int COMPLEX_WIDTH  = 10;
+static const int COMPLEX_HEIGHT = 10;
+static const unsigned char COMPLEX_MAP[COMPLEX_WIDTH*COMPLEX_HEIGHT] ={0, 1, 0, 1, 1, 1, 1, 1, 0, 1,
+                                                                       0, 1, 0, 1, 0, 0, 0, 0, 0, 1,
+                                                                       1, 1, 0, 1, 0, 1, 1, 1, 0, 1,
+                                                                       1, 1, 0, 1, 1, 1, 0, 1, 0, 1,
+                                                                       1, 1, 0, 1, 0, 0, 0, 1, 0, 1,
+                                                                       1, 1, 0, 1, 1, 0, 1, 1, 0, 1,
+                                                                       1, 1, 0, 0, 1, 0, 1, 1, 0, 1,
+                                                                       1, 1, 1, 0, 1, 1, 0, 1, 1, 1,
+                                                                       1, 0, 1, 1, 0, 1, 0, 0, 0, 1,
+                                                                       1, 1, 0, 1, 1, 1, 0, 0, 0, 1};
+
+static PrepareOptions optionsFromBits(const int bits)
+{
+  PrepareOptions options;
+  options.padding       = (bits & 1) != 0;
+  options.bitPacking    = (bits & 2) != 0;
+  options.components    = (bits & 4) != 0;
+  options.neighborMasks = (bits & 8) != 0;
+  options.tiledLayout   = (bits & 16) != 0;
+  return options;
+}
+
+TEST_CASE("PreparedMap - every preprocessing gives the same paths as FindPath")
+{
+  const int mapSize = COMPLEX_WIDTH*COMPLEX_HEIGHT;
+  for (int bits = 0; bits < 32; ++bits)
+  {
+    const PreparedMap prepared(COMPLEX_MAP, COMPLEX_WIDTH, COMPLEX_HEIGHT, optionsFromBits(bits));
+    for (int from = 0; from < mapSize; ++from)
+    {
+      for (int to = 0; to < mapSize; ++to)
+      {
+        if (!COMPLEX_MAP[from] || !COMPLEX_MAP[to]) { continue; }
+        int expectedBuffer[mapSize];
+        int outputBuffer[mapSize];
+        const int expected = FindPath(from % COMPLEX_WIDTH, from / COMPLEX_WIDTH, to % COMPLEX_WIDTH, to / COMPLEX_WIDTH,
+                                      COMPLEX_MAP, COMPLEX_WIDTH, COMPLEX_HEIGHT, expectedBuffer, mapSize);
+        const int length = prepared.findPath(from % COMPLEX_WIDTH, from / COMPLEX_WIDTH, to % COMPLEX_WIDTH, to / COMPLEX_WIDTH,
+                                             outputBuffer, mapSize);
+        REQUIRE(length == expected);
+        if (length > 0)
+        {
+          CHECK(vector<int>(outputBuffer, outputBuffer + length) == vector<int>(expectedBuffer, expectedBuffer + length));
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("PreparedMap - neighbor masks and components")
+{
+  const unsigned char pMap[] = {1, 1, 0,
+                                0, 1, 0,
+                                1, 0, 1};
+  PrepareOptions options;
+  options.components = true;
+  options.neighborMasks = true;
+  const PreparedMap prepared(pMap, 3, 3, options);
+
+  CHECK(prepared.neighborMask(Coordinates(0,0)) == PreparedMap::NEIGHBOR_RIGHT);
+  CHECK(prepared.neighborMask(Coordinates(1,0)) == (PreparedMap::NEIGHBOR_DOWN | PreparedMap::NEIGHBOR_LEFT));
+  CHECK(prepared.neighborMask(Coordinates(1,1)) == PreparedMap::NEIGHBOR_UP);
+  CHECK(prepared.neighborMask(Coordinates(2,2)) == 0);
+
+  CHECK(prepared.component(Coordinates(0,0)) != 0);
+  CHECK(prepared.component(Coordinates(0,0)) == prepared.component(Coordinates(1,1)));
+  CHECK(prepared.component(Coordinates(0,2)) != prepared.component(Coordinates(0,0)));
+  CHECK(prepared.component(Coordinates(0,2)) != prepared.component(Coordinates(2,2)));
+  CHECK(prepared.component(Coordinates(2,0)) == 0);
+  CHECK(prepared.bytesAllocated() >= 9*sizeof(int) + 9);
+
+  // different components : no path, and no search at all
+  int outputBuffer[9];
+  SearchStats stats;
+  CHECK(prepared.findPath(0, 0, 2, 2, outputBuffer, 9, &stats) == -1);
+  CHECK(stats.nodesExpanded == 0);
+}
+
+TEST_CASE("PreparedMap - bad input, throw exception")
+{
+  const unsigned char pMap[] = {1, 1,
+                                1, 0};
+  CHECK_THROWS_WITH(PreparedMap(pMap, 0, 2), "in FindPath(), map width must be greater than 0.\n");
+  CHECK_THROWS_WITH(PreparedMap(pMap, 2, 0), "in FindPath(), map height must be greater than 0.\n");
+
+  const PreparedMap prepared(pMap, 2, 2, optionsFromBits(15));
+  int outputBuffer[4];
+  CHECK_THROWS_WITH(prepared.findPath(0, 2, 0, 0, outputBuffer, 4), "in FindPath(), Start's ordinate must be less than the map height.\n");
+  CHECK_THROWS_WITH(prepared.findPath(0, 0, 1, 1, outputBuffer, 4), "in FindPath(), Target point must be passable.\n");
+  CHECK_THROWS_WITH(prepared.findPath(0, 0, 1, 0, outputBuffer, -1), "in FindPath(), output buffer size must be greater than 0.\n");
+}
+
+TEST_CASE("PreparedMap - tiled layout, cell indexes are a bijection")
+{
+  const unsigned char pMap[37*23] = {};
+  PrepareOptions options;
+  options.tiledLayout = true;
+  const PreparedMap prepared(pMap, 37, 23, options);
+  // rounded up to whole tiles, and to a power of 2 tiles per row
+  CHECK(prepared.cellCount() == 64*32);
+
+  vector<bool> used(prepared.cellCount(), false);
+  for (int y = 0; y < 23; ++y)
+  {
+    for (int x = 0; x < 37; ++x)
+    {
+      const int index = prepared.cellIndex(Coordinates(x, y));
+      REQUIRE(index >= 0);
+      REQUIRE(index < prepared.cellCount());
+      CHECK(!used[index]);
+      used[index] = true;
+      CHECK(prepared.cellCoordinates(index) == Coordinates(x, y));
+    }
+  }
+  // Z-order in a tile : the cell below is 2 indexes away at the top-left of the tile
+  CHECK(prepared.cellIndex(Coordinates(0, 1)) - prepared.cellIndex(Coordinates(0, 0)) == 2);
+  CHECK(prepared.cellIndex(Coordinates(PreparedMap::TILE_SIZE, 0)) == PreparedMap::TILE_SIZE*PreparedMap::TILE_SIZE);
+}
+
+TEST_CASE("PreparedMap - tiled layout, the dense and compact searches find the same paths")
+{
+  srand(41);
+  for (int mapIndex = 0; mapIndex < 20; ++mapIndex)
+  {
+    const RandomQuery query = cornerQuery(70);
+    const int mapWidth = query.mapWidth, mapHeight = query.mapHeight;
+    const vector<unsigned char>& pMap = query.pMap;
+    PrepareOptions options;
+    options.neighborMasks = true;
+    options.tiledLayout = true;
+    const PreparedMap tiled(pMap.data(), mapWidth, mapHeight, options);
+
+    for (const SearchLayout layout : {SearchLayout::Dense, SearchLayout::Compact})
+    {
+      vector<int> expected(mapWidth*mapHeight), actual(mapWidth*mapHeight);
+      Pathfinder rowMajor(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                          expected.data(), (int)expected.size(), TieBreak::HigherG, layout);
+      Pathfinder pathfinder(0, 0, mapWidth-1, mapHeight-1, tiled,
+                            actual.data(), (int)actual.size(), TieBreak::HigherG, layout);
+      const int length = rowMajor.findPath();
+      REQUIRE(pathfinder.findPath() == length);
+      // same expansion order, and the output is translated back to row-major indexes
+      CHECK(actual == expected);
+    }
+  }
+}
+
+TEST_CASE("PreparedMap - tiled layout, maps whose tiles exceed 2^31 cells stay row-major")
+{
+  // the cells are not read : only the layout is computed
+  const unsigned char pMap[1] = {1};
+  PrepareOptions options;
+  options.tiledLayout = true;
+
+  // 2048 tiles per row : 4095 rows of tiles fit, 4096 do not
+  CHECK(PreparedMap::fitsTiledLayout(32768, 4095*PreparedMap::TILE_SIZE));
+  const PreparedMap largest(pMap, 32768, 4095*PreparedMap::TILE_SIZE, options);
+  CHECK(largest.options().tiledLayout);
+  CHECK(largest.cellCount() == 32768*4095*PreparedMap::TILE_SIZE);
+  CHECK(largest.cellCoordinates(largest.cellIndex(Coordinates(32767, 65519))) == Coordinates(32767, 65519));
+
+  CHECK(!PreparedMap::fitsTiledLayout(32768, 4095*PreparedMap::TILE_SIZE + 1));
+  const PreparedMap tooLarge(pMap, 32768, 4095*PreparedMap::TILE_SIZE + 1, options);
+  CHECK(!tooLarge.options().tiledLayout);
+  CHECK(tooLarge.cellCount() == 32768*(4095*PreparedMap::TILE_SIZE + 1));
+  CHECK(tooLarge.cellIndex(Coordinates(1, 2)) == 2*32768 + 1);
+
+  // less than 2^31 cells, more once rounded up to 2048 tiles per row
+  const PreparedMap rounded(pMap, 16400, 70000, options);
+  CHECK(!rounded.options().tiledLayout);
+  CHECK(rounded.cellCount() == 16400*70000);
+
+  // a height near INT_MAX : its rows of tiles are counted without overflow
+  CHECK(!PreparedMap::fitsTiledLayout(1, INT_MAX));
+  CHECK(!PreparedMap::fitsTiledLayout(1, INT_MAX - PreparedMap::TILE_SIZE + 2));
+  const PreparedMap tall(pMap, 1, INT_MAX, options);
+  CHECK(!tall.options().tiledLayout);
+  CHECK(tall.cellCount() == INT_MAX);
+  CHECK(tall.cellIndex(Coordinates(0, INT_MAX - 1)) == INT_MAX - 1);
+}
+
+TEST_CASE("PreparedMap - padding, maps whose border exceeds 2^31 cells are not padded")
+{
+  CHECK(PreparedMap::fitsPadding(46338, 46338));
+  CHECK(!PreparedMap::fitsPadding(46339, 46339));
+  CHECK(!PreparedMap::fitsPadding(1, INT_MAX));
+
+  // every cell reads the same byte : nothing is built
+  const unsigned char cell = 1;
+  MapView view(&cell, 46340, 46340);
+  view.rowPitch = 0;
+  view.cellStride = 0;
+  PrepareOptions options;
+  options.padding = true;
+  const PreparedMap prepared(view, options);
+  CHECK(!prepared.options().padding);
+  CHECK(prepared.bytesAllocated() == 0);
+  CHECK(prepared.isCellOk(Coordinates(46339, 46339)));
+  CHECK(!prepared.isCellOk(Coordinates(46340, 0)));
+}
@@ -0,0 +1,224 @@
+#include "catch.hpp"
+#include "../pathfinder.hpp"
+
+using namespace std;
+
+TEST_CASE("PriorityQueue - lower priority is dequeued first")
+{
+  PriorityQueue<int> q;
+  q.put(1, 12);
+  q.put(2, 3);
+  q.put(3, 7);
+  REQUIRE(q.size() == 3);
+  CHECK(q.dequeue() == 2);
+  CHECK(q.dequeue() == 3);
+  CHECK(q.dequeue() == 1);
+  CHECK(q.empty());
+}
+
+TEST_CASE("PriorityQueue - tie-break policies on same priority")
+{
+  SECTION("Fifo")
+  {
+    PriorityQueue<int> q(TieBreak::Fifo);
+    q.put(1, 5, 1);
+    q.put(2, 5, 3);
+    q.put(3, 5, 2);
+    CHECK(q.dequeue() == 1);
+    CHECK(q.dequeue() == 2);
+    CHECK(q.dequeue() == 3);
+  }
+  SECTION("Lifo")
+  {
+    PriorityQueue<int> q(TieBreak::Lifo);
+    q.put(1, 5, 1);
+    q.put(2, 5, 3);
+    q.put(3, 5, 2);
+    CHECK(q.dequeue() == 3);
+    CHECK(q.dequeue() == 2);
+    CHECK(q.dequeue() == 1);
+  }
+  SECTION("HigherG")
+  {
+    PriorityQueue<int> q(TieBreak::HigherG);
+    q.put(1, 5, 1);
+    q.put(2, 5, 3);
+    q.put(3, 5, 2);
+    q.put(4, 4, 0);
+    CHECK(q.dequeue() == 4);
+    CHECK(q.dequeue() == 2);
+    CHECK(q.dequeue() == 3);
+    CHECK(q.dequeue() == 1);
+  }
+  SECTION("LowerH")
+  {
+    PriorityQueue<int> q(TieBreak::LowerH);
+    q.put(1, 5, 4);
+    q.put(2, 5, 1);
+    q.put(3, 5, 4);
+    CHECK(q.dequeue() == 1);
+    CHECK(q.dequeue() == 3);
+    CHECK(q.dequeue() == 2);
+  }
+}
+
+TEST_CASE("findPath - tie-break policies give the same length, with expansions reported")
+{
+  const int mapWidth  = 32;
+  const int mapHeight = 32;
+  vector<unsigned char> pMap(mapWidth*mapHeight, 1);
+  vector<int> outputBuffer(mapWidth*mapHeight);
+
+  for (const TieBreak tieBreak : {TieBreak::Fifo, TieBreak::Lifo, TieBreak::HigherG, TieBreak::LowerH})
+  {
+    Pathfinder pathfinder(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                          outputBuffer.data(), (int)outputBuffer.size(), tieBreak);
+    SearchStats stats;
+    CHECK(pathfinder.findPath(&stats) == 62);
+    CHECK(stats.nodesExpanded >= 62);
+  }
+
+  // on an open map, preferring deep cells walks straight through the plateau of equal priority
+  Pathfinder deep(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                  outputBuffer.data(), (int)outputBuffer.size(), TieBreak::HigherG);
+  Pathfinder fifo(0, 0, mapWidth-1, mapHeight-1, pMap.data(), mapWidth, mapHeight,
+                  outputBuffer.data(), (int)outputBuffer.size(), TieBreak::Fifo);
+  SearchStats deepStats, fifoStats;
+  deep.findPath(&deepStats);
+  fifo.findPath(&fifoStats);
+  CHECK(deepStats.nodesExpanded == 62);
+  CHECK(fifoStats.nodesExpanded > deepStats.nodesExpanded);
+}
+
+TEST_CASE("findPath - ordering is deterministic")
+{
+  const int mapWidth  = 16;
+  const int mapHeight = 16;
+  vector<unsigned char> pMap(mapWidth*mapHeight, 1);
+  vector<int> firstBuffer(mapWidth*mapHeight);
+  vector<int> secondBuffer(mapWidth*mapHeight);
+
+  const int firstLength  = FindPath(0, 0, 15, 15, pMap.data(), mapWidth, mapHeight, firstBuffer.data(),  (int)firstBuffer.size());
+  const int secondLength = FindPath(0, 0, 15, 15, pMap.data(), mapWidth, mapHeight, secondBuffer.data(), (int)secondBuffer.size());
+  REQUIRE(firstLength == secondLength);
+  CHECK(firstBuffer == secondBuffer);
+}
+
+TEST_CASE("IndexedHeap - lower priority is dequeued first, without duplicates")
+{
+  IndexedHeap q(10);
+  q.put(4, 12, 0);
+  q.put(7, 3, 0);
+  q.put(2, 7, 0);
+  q.put(9, 5, 0);
+  q.put(1, 20, 0);
+  REQUIRE(q.size() == 5);
+  CHECK(q.contains(4));
+  CHECK_FALSE(q.contains(5));
+
+  // decrease-key : the cell is moved in place, not pushed twice
+  q.put(1, 4, 0);
+  CHECK(q.size() == 5);
+
+  CHECK(q.dequeue() == 7);
+  CHECK(q.dequeue() == 1);
+  CHECK(q.dequeue() == 9);
+  CHECK(q.dequeue() == 2);
+  CHECK(q.dequeue() == 4);
+  CHECK(q.empty());
+  CHECK_FALSE(q.contains(4));
+}
+
+TEST_CASE("IndexedHeap - many items come out sorted")
+{
+  const int capacity = 1000;
+  IndexedHeap q(capacity);
+  for (int index = 0; index < capacity; ++index)
+  {
+    q.put(index, (index * 7919) % 251, 0);
+  }
+  int previous = -1;
+  while (!q.empty())
+  {
+    const int priority = (q.dequeue() * 7919) % 251;
+    CHECK(priority >= previous);
+    previous = priority;
+  }
+}
+
+TEST_CASE("IndexedHeap - tie-break policies")
+{
+  IndexedHeap q(10, TieBreak::HigherG);
+  q.put(1, 5, 1);
+  q.put(2, 5, 3);
+  q.put(3, 5, 2);
+  CHECK(q.dequeue() == 2);
+  CHECK(q.dequeue() == 3);
+  CHECK(q.dequeue() == 1);
+}
+
+TEST_CASE("IndexedHeap - remove and visit up to a priority")
+{
+  const int capacity = 200;
+  IndexedHeap q(capacity);
+  for (int index = 0; index < capacity; ++index)
+  {
+    q.put(index, (index * 7919) % 101, 0);
+  }
+  // remove every third index
+  for (int index = 0; index < capacity; index += 3)
+  {
+    q.remove(index);
+    CHECK_FALSE(q.contains(index));
+  }
+
+  vector<int> visited;
+  q.visitUpTo(20, [&visited](const int index) { visited.push_back(index); });
+  int expectedVisits = 0;
+  for (int index = 0; index < capacity; ++index)
+  {
+    if (index % 3 != 0 && (index * 7919) % 101 <= 20) { ++expectedVisits; }
+  }
+  CHECK((int)visited.size() == expectedVisits);
+  for (const int index : visited)
+  {
+    CHECK(index % 3 != 0);
+    CHECK((index * 7919) % 101 <= 20);
+  }
+  // the stack of the visit is kept : visiting again does not allocate
+  const size_t bytesAfterVisit = q.bytesAllocated();
+  int nbVisits = 0;
+  q.visitUpTo(20, [&nbVisits](const int) { ++nbVisits; });
+  CHECK(nbVisits == expectedVisits);
+  CHECK(q.bytesAllocated() == bytesAfterVisit);
+
+  int previous = -1;
+  while (!q.empty())
+  {
+    const int index = q.dequeue();
+    CHECK(index % 3 != 0);
+    const int priority = (index * 7919) % 101;
+    CHECK(priority >= previous);
+    previous = priority;
+  }
+}
+
+TEST_CASE("findPath - every cell is expanded at most once")
+{
+  const int mapWidth  = 10;
+  const int mapHeight = 10;
+  vector<unsigned char> pMap(mapWidth*mapHeight, 1);
+  // wall with a single gap, forcing the search to expand most of the left side
+  for (int y = 1; y < mapHeight; ++y) { pMap[y*mapWidth + 5] = 0; }
+  vector<int> outputBuffer(mapWidth*mapHeight);
+
+  for (const TieBreak tieBreak : {TieBreak::Fifo, TieBreak::Lifo, TieBreak::HigherG, TieBreak::LowerH})
+  {
+    Pathfinder pathfinder(0, 9, 9, 9, pMap.data(), mapWidth, mapHeight,
+                          outputBuffer.data(), (int)outputBuffer.size(), tieBreak);
+    SearchStats stats;
+    CHECK(pathfinder.findPath(&stats) == 27);
+    CHECK(stats.nodesExpanded <= mapWidth*mapHeight - (mapHeight-1));
+    CHECK(stats.reExpansions == 0);
+  }
+}
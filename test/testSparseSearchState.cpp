@@ -0,0 +1,64 @@
+#include "catch.hpp"
+#include "../sparsesearchstate.hpp"
+#include <climits>
+
+using namespace std;
+
+TEST_CASE("SparseSearchState - nodes are found by cell, and keep their number when the table grows")
+{
+  SparseSearchState state;
+  CHECK(state.size() == 0);
+  CHECK(state.find(7) == -1);
+
+  // cells a power of 2 apart, as the cells of a column of a 1024 wide map
+  const int nbCells = 5000;
+  for (int i = 0; i < nbCells; ++i)
+  {
+    CHECK(state.insert(i * 1024, i, i - 1) == i);
+  }
+  CHECK(state.size() == nbCells);
+  for (int i = 0; i < nbCells; ++i)
+  {
+    const int node = state.find(i * 1024);
+    REQUIRE(node == i);
+    CHECK(state.node(node).cell == i * 1024);
+    CHECK(state.node(node).costFromStart == i);
+    CHECK(state.node(node).parent == i - 1);
+  }
+  CHECK(state.find(1023) == -1);
+  CHECK(state.find(nbCells * 1024) == -1);
+
+  // nodes are updated in place
+  state.node(state.find(2048)).costFromStart = 42;
+  CHECK(state.node(2).costFromStart == 42);
+}
+
+TEST_CASE("SparseSearchState - memory follows the nodes, and comes from the arena if any")
+{
+  SparseSearchState small(10);
+  SparseSearchState large(100000);
+  CHECK(small.bytesAllocated() < 1000);
+  CHECK(large.bytesAllocated() >= 100000 * sizeof(SparseSearchState::Node));
+
+  Arena arena;
+  const long long systemAllocations = arena.systemAllocations();
+  {
+    SparseSearchState state(1000, &arena);
+    for (int cell = 0; cell < 1000; ++cell) { state.insert(cell * 3, 0, -1); }
+    CHECK(state.find(2997) == 999);
+  }
+  CHECK(arena.systemAllocations() > systemAllocations);
+}
+
+TEST_CASE("SparseSearchState - the large state numbers its nodes in 64 bits, as its cells")
+{
+  // a search on a map beyond 2^31 cells may reach more than INT_MAX of them
+  LargeSparseSearchState state;
+  const int64_t farCell = (int64_t)INT_MAX * 4;
+  const int64_t node = state.insert(farCell, farCell, -1);
+  CHECK(state.insert(farCell + 1, farCell + 1, node) == node + 1);
+  CHECK(state.find(farCell + 1) == node + 1);
+  CHECK(state.node(node + 1).parent == node);
+  CHECK(sizeof(state.node(node).parent) == sizeof(int64_t));
+  CHECK(sizeof(state.find(farCell)) == sizeof(int64_t));
+}